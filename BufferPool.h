@@ -6,12 +6,45 @@
 #include <iostream>
 #include <unordered_map>
 #include <mutex>
+#include <shared_mutex>
+#include <cstdint>
+#include <atomic>
+#include <algorithm>
 #include <vector>
-#include <tuple>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/memfd.h>
 
 namespace bos::mm
 {
+    // cl_mem 绑定统计：命中 = 复用已有 cl_mem，未命中 = 调用了一次 clCreateBuffer
+    struct ClMemStats
+    {
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+    };
+
+    inline ClMemStats &cl_mem_stats()
+    {
+        static ClMemStats stats;
+        return stats;
+    }
+
+    // 普通内存的分配参数。多数 OpenCL 运行时（包括 POCL）只有在指针按页/缓存行对齐、
+    // 大小按缓存行补齐时，CL_MEM_USE_HOST_PTR 才是真正的零拷贝，否则会悄悄复制一份
+    struct BufferAllocOptions
+    {
+        size_t alignment = 4096;      // 起始地址对齐（字节，2 的幂）
+        size_t size_multiple = 64;    // 分配大小向上补齐到该倍数
+        bool huge_pages = false;      // 对 2MB 以上的缓冲区提示透明大页（MADV_HUGEPAGE）
+    };
+
     // Buffer 类
     class Buffer
     {
@@ -19,25 +52,92 @@ namespace bos::mm
         enum class Type
         {
             NORMAL, // 普通内存
-            DMABUF  // DMA缓冲区
+            DMABUF, // DMA缓冲区
+            MEMFD,  // memfd_create + mmap 的共享内存，可通过 fd 交给其他进程（DMA-BUF 的软件替身）
+            MAPPED  // 别处已经映射好的内存（例如文件映射中的一帧），Buffer 只引用、不释放
         };
 
         // 构造函数
-        Buffer(Type type, size_t size, int dma_fd = -1)
-            : type(type), size(size), dma_fd(dma_fd), data(nullptr)
+        Buffer(Type type, size_t size, int dma_fd = -1, const BufferAllocOptions &alloc = BufferAllocOptions())
+            : type(type), size(size), allocated_size(size), data(nullptr), dma_fd(dma_fd)
         {
             if (type == Type::NORMAL)
             {
-                data = std::make_unique<uint8_t[]>(size); // 普通内存分配
+                // 普通内存分配：按 alignment 对齐，大小补齐到 size_multiple
+                const size_t huge_page = 2 << 20;
+                size_t alignment = std::max(alloc.alignment, sizeof(void *));
+                size_t multiple = std::max<size_t>(alloc.size_multiple, 1);
+                allocated_size = (std::max<size_t>(size, 1) + multiple - 1) / multiple * multiple;
+                bool use_huge_pages = alloc.huge_pages && allocated_size >= huge_page;
+                if (use_huge_pages)
+                {
+                    alignment = std::max(alignment, huge_page);
+                    allocated_size = (allocated_size + huge_page - 1) / huge_page * huge_page;
+                }
+
+                void *ptr = nullptr;
+                if (posix_memalign(&ptr, alignment, allocated_size) != 0)
+                {
+                    throw std::bad_alloc();
+                }
+                data = static_cast<uint8_t *>(ptr);
+#ifdef MADV_HUGEPAGE
+                if (use_huge_pages)
+                {
+                    madvise(data, allocated_size, MADV_HUGEPAGE);
+                }
+#endif
+                std::memset(data, 0, allocated_size);
             }
             else if (type == Type::DMABUF && dma_fd != -1)
             {
                 // 映射DMA文件描述符到内存
-                data.reset(static_cast<uint8_t *>(mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, dma_fd, 0)));
-                if (data == MAP_FAILED)
+                void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, dma_fd, 0);
+                if (ptr == MAP_FAILED)
                 {
                     throw std::runtime_error("Failed to map DMA buffer to memory.");
                 }
+                data = static_cast<uint8_t *>(ptr);
+            }
+            else if (type == Type::MEMFD)
+            {
+                // dma_fd == -1 时新建 memfd；否则导入其他进程传来的 fd（复制一份，由 Buffer 负责关闭）
+                const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+                allocated_size = (std::max<size_t>(size, 1) + page - 1) / page * page;
+                if (dma_fd == -1)
+                {
+                    this->dma_fd = static_cast<int>(syscall(SYS_memfd_create, "bos-buffer", MFD_CLOEXEC));
+                    if (this->dma_fd < 0 || ftruncate(this->dma_fd, static_cast<off_t>(allocated_size)) != 0)
+                    {
+                        if (this->dma_fd >= 0)
+                        {
+                            close(this->dma_fd);
+                        }
+                        throw std::runtime_error("Failed to create memfd buffer.");
+                    }
+                }
+                else
+                {
+                    struct stat st;
+                    this->dma_fd = fcntl(dma_fd, F_DUPFD_CLOEXEC, 0);
+                    if (this->dma_fd < 0 || fstat(this->dma_fd, &st) != 0 || static_cast<size_t>(st.st_size) < size)
+                    {
+                        if (this->dma_fd >= 0)
+                        {
+                            close(this->dma_fd);
+                        }
+                        throw std::runtime_error("Invalid memfd for buffer import.");
+                    }
+                    allocated_size = std::min(allocated_size, static_cast<size_t>(st.st_size));
+                }
+
+                void *ptr = mmap(nullptr, allocated_size, PROT_READ | PROT_WRITE, MAP_SHARED, this->dma_fd, 0);
+                if (ptr == MAP_FAILED)
+                {
+                    close(this->dma_fd);
+                    throw std::runtime_error("Failed to map memfd buffer to memory.");
+                }
+                data = static_cast<uint8_t *>(ptr);
             }
             else
             {
@@ -45,125 +145,578 @@ namespace bos::mm
             }
         }
 
+        // 包装 owner 管理的一段现有内存（MAPPED）：不复制、不释放，owner 在 Buffer 析构前一直保持内存有效
+        Buffer(uint8_t *data, size_t size, std::shared_ptr<void> owner)
+            : type(Type::MAPPED), size(size), allocated_size(size), data(data), dma_fd(-1), owner(std::move(owner))
+        {
+            if (data == nullptr || this->owner == nullptr)
+            {
+                throw std::invalid_argument("Mapped buffer needs memory and an owner.");
+            }
+        }
+
+        Buffer(const Buffer &) = delete;
+        Buffer &operator=(const Buffer &) = delete;
+
         // 析构函数
         virtual ~Buffer()
         {
-            if (type == Type::DMABUF && data != nullptr)
+            // cl_mem 可能以 USE_HOST_PTR 引用这块内存，必须先于内存释放；子缓冲区先于父缓冲区释放
+            for (auto &view : sub_cl_mems)
+            {
+                clReleaseMemObject(view.mem);
+            }
+            for (auto &binding : cl_mems)
+            {
+                clReleaseMemObject(binding.second);
+            }
+            if (type == Type::DMABUF)
             {
                 // 解除映射
-                munmap(data.get(), size);
+                munmap(data, size);
+            }
+            else if (type == Type::MEMFD)
+            {
+                munmap(data, allocated_size);
+                close(dma_fd);
+            }
+            else if (type == Type::NORMAL)
+            {
+                free(data);
             }
         }
 
         // 获取数据指针
         uint8_t *get_data()
         {
-            return data.get();
-            ;
+            return data;
         }
 
         // 获取缓冲区类型
         Type get_type() const { return type; }
 
-        // 获取DMA文件描述符（仅适用于DMABUF类型）
+        // 获取DMA文件描述符（仅适用于DMABUF/MEMFD类型）
         int get_dma_fd() const { return dma_fd; }
 
         // 获取缓冲区大小
         size_t get_size() const { return size; }
 
+        // 实际分配的大小（含对齐补齐），cl_mem 按这个大小创建
+        size_t get_allocated_size() const { return allocated_size; }
+
+        // 获取绑定到 context 的 cl_mem，第一次调用时创建，之后复用直到 Buffer 析构。
+        // 返回的 cl_mem 归 Buffer 所有，调用者不要释放
+        cl_mem get_cl_mem(cl_context context, bool use_fd = false)
+        {
+            bool created = false;
+            cl_mem mem = bound_cl_mem(context, use_fd, created);
+            (created ? cl_mem_stats().misses : cl_mem_stats().hits).fetch_add(1, std::memory_order_relaxed);
+            return mem;
+        }
+
+        // 获取 [offset, offset + size) 这段内存的 cl_mem，是 get_cl_mem 返回的父缓冲区的 clCreateSubBuffer 视图，
+        // 同样按 context 缓存、归 Buffer 所有。offset 必须是设备 CL_DEVICE_MEM_BASE_ADDR_ALIGN 的整数倍
+        cl_mem get_sub_cl_mem(cl_context context, size_t offset, size_t size, bool use_fd = false)
+        {
+            if (offset + size > allocated_size)
+            {
+                std::cerr << "Sub-buffer [" << offset << ", " << offset + size << ") exceeds buffer size "
+                          << allocated_size << "." << std::endl;
+                return nullptr;
+            }
+            // 父缓冲区的查找不计入统计，一次子缓冲区查找只记一次命中或未命中
+            bool created = false;
+            cl_mem parent = bound_cl_mem(context, use_fd, created);
+            if (parent == nullptr)
+            {
+                return nullptr;
+            }
+
+            std::lock_guard<std::mutex> lock(cl_mem_mutex);
+            for (auto &view : sub_cl_mems)
+            {
+                if (view.context == context && view.offset == offset && view.size == size)
+                {
+                    cl_mem_stats().hits.fetch_add(1, std::memory_order_relaxed);
+                    return view.mem;
+                }
+            }
+
+            cl_mem_stats().misses.fetch_add(1, std::memory_order_relaxed);
+            cl_int err = CL_SUCCESS;
+            cl_buffer_region region = {offset, size};
+            cl_mem mem = clCreateSubBuffer(parent, CL_MEM_READ_WRITE, CL_BUFFER_CREATE_TYPE_REGION, &region, &err);
+            if (err != CL_SUCCESS)
+            {
+                if (err == CL_MISALIGNED_SUB_BUFFER_OFFSET)
+                {
+                    std::cerr << "Sub-buffer offset " << offset << " is not aligned to CL_DEVICE_MEM_BASE_ADDR_ALIGN." << std::endl;
+                }
+                else
+                {
+                    std::cerr << "Failed to create sub-buffer (error " << err << ")." << std::endl;
+                }
+                return nullptr;
+            }
+            sub_cl_mems.push_back({context, offset, size, mem});
+            return mem;
+        }
+
+        // 不经过缓存直接创建 cl_mem，调用者负责 clReleaseMemObject
+        cl_mem create_cl_mem(cl_context context, bool use_fd = false)
+        {
+            cl_int err = CL_SUCCESS;
+            cl_mem_flags flags = CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR;
+            cl_mem mem = nullptr;
+            if (use_fd && (type == Type::DMABUF || type == Type::MEMFD))
+            {
+                // 使用 DMA FD 创建 cl_mem；驱动不提供 fd 导入扩展或导入失败时退回到映射地址上的 USE_HOST_PTR
+                CreateBufferFromFdFn create_from_fd = find_create_buffer_from_fd(context);
+                if (create_from_fd != nullptr)
+                {
+                    mem = create_from_fd(context, dma_fd, flags, allocated_size, &err);
+                }
+                if (create_from_fd == nullptr || err != CL_SUCCESS || mem == nullptr)
+                {
+                    mem = clCreateBuffer(context, flags, allocated_size, data, &err);
+                }
+            }
+            else
+            {
+                // 使用普通内存创建 cl_mem
+                mem = clCreateBuffer(context, flags, allocated_size, data, &err);
+            }
+            if (err != CL_SUCCESS)
+            {
+                std::cerr << "Failed to create cl_mem for buffer (error " << err << ")." << std::endl;
+                return nullptr;
+            }
+            return mem;
+        }
+
+        // 查询运行时对 context 上的 cl_mem 是否真正零拷贝：
+        // 映射后的指针等于宿主指针说明直接使用了这块内存，否则运行时内部复制了一份
+        bool is_zero_copy(cl_context context, cl_command_queue queue)
+        {
+            cl_mem mem = get_cl_mem(context);
+            if (mem == nullptr)
+            {
+                return false;
+            }
+            cl_int err = CL_SUCCESS;
+            void *mapped = clEnqueueMapBuffer(queue, mem, CL_TRUE, CL_MAP_READ, 0, allocated_size, 0, nullptr, nullptr, &err);
+            if (err != CL_SUCCESS)
+            {
+                return false;
+            }
+            bool zero_copy = mapped == data;
+            clEnqueueUnmapMemObject(queue, mem, mapped, 0, nullptr, nullptr);
+            clFinish(queue);
+            return zero_copy;
+        }
+
     private:
-        Type type;                       // 缓冲区类型
-        size_t size;                     // 缓冲区大小
-        std::unique_ptr<uint8_t[]> data; // 数据指针（普通内存或DMA内存）
-        int dma_fd;                      // DMA缓冲区的文件描述符
+        // 查找或创建 context 上的父 cl_mem，不记录统计；created 表示这次调用了 create_cl_mem
+        cl_mem bound_cl_mem(cl_context context, bool use_fd, bool &created)
+        {
+            std::lock_guard<std::mutex> lock(cl_mem_mutex);
+            for (auto &binding : cl_mems)
+            {
+                if (binding.first == context)
+                {
+                    return binding.second;
+                }
+            }
+
+            created = true;
+            cl_mem mem = create_cl_mem(context, use_fd);
+            if (mem != nullptr)
+            {
+                cl_mems.emplace_back(context, mem);
+            }
+            return mem;
+        }
+
+        // clCreateBufferFromFd 是厂商扩展，Khronos 头文件不声明它，只能按平台在运行时查找
+        typedef cl_mem (*CreateBufferFromFdFn)(cl_context, int, cl_mem_flags, size_t, cl_int *);
+
+        static CreateBufferFromFdFn find_create_buffer_from_fd(cl_context context)
+        {
+            size_t devices_size = 0;
+            if (clGetContextInfo(context, CL_CONTEXT_DEVICES, 0, nullptr, &devices_size) != CL_SUCCESS || devices_size == 0)
+            {
+                return nullptr;
+            }
+            std::vector<cl_device_id> devices(devices_size / sizeof(cl_device_id));
+            cl_platform_id platform = nullptr;
+            if (clGetContextInfo(context, CL_CONTEXT_DEVICES, devices_size, devices.data(), nullptr) != CL_SUCCESS ||
+                clGetDeviceInfo(devices[0], CL_DEVICE_PLATFORM, sizeof(platform), &platform, nullptr) != CL_SUCCESS)
+            {
+                return nullptr;
+            }
+            return reinterpret_cast<CreateBufferFromFdFn>(
+                clGetExtensionFunctionAddressForPlatform(platform, "clCreateBufferFromFd"));
+        }
+
+        Type type;             // 缓冲区类型
+        size_t size;           // 缓冲区大小
+        size_t allocated_size; // 实际分配的大小
+        uint8_t *data;         // 数据指针（普通内存或DMA内存）
+        int dma_fd;            // DMA缓冲区的文件描述符
+        std::shared_ptr<void> owner; // MAPPED 类型的内存所有者，随 Buffer 一起释放
+        std::mutex cl_mem_mutex;
+        std::vector<std::pair<cl_context, cl_mem>> cl_mems; // 每个 context 一个 cl_mem，随 Buffer 一起释放
+
+        struct SubView
+        {
+            cl_context context;
+            size_t offset, size;
+            cl_mem mem;
+        };
+        std::vector<SubView> sub_cl_mems; // 父 cl_mem 上的子缓冲区视图（多平面图像的各个平面）
+    };
+
+    // BufferPool 配置
+    struct BufferPoolOptions
+    {
+        // 尺寸分级策略：相近的请求落到同一级，共享同一条空闲链表
+        enum class SizeClass
+        {
+            EXACT,        // 按请求尺寸精确分级
+            POWER_OF_TWO, // 向上取到 2 的幂（不小于 page_size）
+            GEOMETRIC     // 从 page_size 开始按 growth 倍数几何增长，再按页对齐
+        };
+
+        SizeClass size_class = SizeClass::EXACT;
+        double growth = 1.25;      // GEOMETRIC 的公比
+        size_t page_size = 4096;   // 分级容量的对齐单位
+        size_t high_watermark = 0; // 空闲内存上限（字节），超过后裁剪；0 表示不限制
+        size_t low_watermark = 0;  // 裁剪的目标空闲内存（字节），应不大于 high_watermark
+        BufferAllocOptions alloc;  // 新缓冲区的对齐/补齐/大页参数
     };
 
     // BufferPool 类
+    // 每个尺寸级维护一条空闲链表。get_buffer 返回的句柄是带自定义删除器的 shared_ptr，
+    // 最后一个引用释放时缓冲区自动回到空闲链表；shared_ptr 的控制块也按尺寸级回收，
+    // 因此稳态下获取/归还都是 O(1) 且不触发堆分配。
+    // 空闲内存超过 high_watermark 时，按最久未使用的尺寸级释放空闲缓冲区，直到不超过 low_watermark
     class BufferPool
     {
     public:
-        BufferPool(const std::vector<size_t> &buffer_sizes)
-            : buffer_sizes(buffer_sizes)
+        using Handle = std::shared_ptr<Buffer>;
+        using Options = BufferPoolOptions;
+
+        // buffers_per_size > 0 时为每个尺寸预先分配若干缓冲区
+        BufferPool(const std::vector<size_t> &buffer_sizes, size_t buffers_per_size = 0, const Options &options = Options())
+            : buffer_sizes(buffer_sizes), state(std::make_shared<State>(options))
         {
-            allocate_buffers();
+            allocate_buffers(buffers_per_size);
         }
 
-        // 获取缓冲区
-        std::shared_ptr<Buffer> get_buffer(Buffer::Type type, size_t size)
+        BufferPool(const BufferPool &) = delete;
+        BufferPool &operator=(const BufferPool &) = delete;
+
+        // 获取缓冲区，句柄析构时自动归还。返回的缓冲区容量是 size 所在尺寸级的容量，不小于 size
+        Handle get_buffer(Buffer::Type type, size_t size)
         {
-            std::lock_guard<std::mutex> lock(mutex);
+            Shelf &shelf = get_shelf(type, size);
+            shelf.last_use = state->clock.fetch_add(1, std::memory_order_relaxed);
 
-            // 根据大小选择对应的池
-            auto &pool = buffer_pools[size];
-            for (auto &buffer : pool)
+            Buffer *buffer = nullptr;
             {
-                if (!buffer_in_use[buffer.get()])
+                std::lock_guard<std::mutex> lock(shelf.mutex);
+                if (!shelf.free_list.empty())
                 {
-                    buffer_in_use[buffer.get()] = true;
-                    return buffer;
+                    buffer = shelf.free_list.back().release();
+                    shelf.free_list.pop_back();
+                    state->idle_bytes.fetch_sub(shelf.capacity, std::memory_order_relaxed);
                 }
             }
 
             // 如果没有可用的缓存区，创建新的
-            auto new_buffer = std::make_shared<Buffer>(type, size);
-            pool.push_back(new_buffer);
-            buffer_in_use[new_buffer.get()] = true;
-            return new_buffer;
+            if (buffer == nullptr)
+            {
+                buffer = new Buffer(type, shelf.capacity, -1, state->options.alloc);
+                state->total_bytes.fetch_add(shelf.capacity, std::memory_order_relaxed);
+                std::lock_guard<std::mutex> lock(shelf.mutex);
+                // 保证归还时 push_back 不会扩容
+                shelf.free_list.reserve(++shelf.count);
+            }
+
+            return Handle(buffer, Releaser{&shelf, state.get()}, BlockAllocator<Buffer>(state, &shelf));
         }
 
-        // 归还缓冲区
-        void return_buffer(std::shared_ptr<Buffer> buffer)
+        // 释放空闲缓冲区，直到空闲内存不超过 target_idle_bytes。最久未使用的尺寸级先被裁剪
+        void trim(size_t target_idle_bytes = 0)
         {
-            std::lock_guard<std::mutex> lock(mutex);
-            buffer_in_use[buffer.get()] = false;
+            state->trim(target_idle_bytes);
         }
 
-        // 缓存和复用 cl_mem
-        cl_mem get_cl_mem_from_plane(const Plane &plane, cl_context context, cl_command_queue queue, bool is_dma = false)
+        // size 实际落入的尺寸级容量
+        size_t get_size_class(size_t size) const
         {
-            std::lock_guard<std::mutex> lock(cl_mem_mutex);
+            return state->size_class(size);
+        }
 
-            // 尝试从缓存中获取
-            auto key = std::make_tuple(plane.get_width(), plane.get_height(), plane.get_stride(), is_dma);
-            auto it = cl_mem_cache.find(key);
-            if (it != cl_mem_cache.end())
+        // 当前分配过且仍存活的缓冲区总数
+        size_t get_allocated_count() const
+        {
+            std::shared_lock<std::shared_mutex> lock(state->shelves_mutex);
+            size_t count = 0;
+            for (auto &entry : state->shelves)
             {
-                // 缓存命中，直接返回
-                return it->second;
+                std::lock_guard<std::mutex> shelf_lock(entry.second->mutex);
+                count += entry.second->count;
             }
-
-            // 创建新的 cl_mem 对象
-            cl_mem cl_mem_obj = plane.to_cl_mem(context, queue, is_dma);
-            // 缓存该 cl_mem
-            cl_mem_cache[key] = cl_mem_obj;
-            return cl_mem_obj;
+            return count;
         }
 
-        // 归还 cl_mem 缓存
-        void return_cl_mem(const Plane &plane, cl_mem cl_mem_obj)
+        // 当前空闲（可立即复用）的缓冲区总数
+        size_t get_free_count() const
         {
-            std::lock_guard<std::mutex> lock(cl_mem_mutex);
-            auto key = std::make_tuple(plane.get_width(), plane.get_height(), plane.get_stride(), false); // 默认是普通内存
-            cl_mem_cache.erase(key);
-            // OpenCL 没有直接提供销毁缓冲区的 API，但可以调用 release 等方法释放内存
-            clReleaseMemObject(cl_mem_obj);
+            std::shared_lock<std::shared_mutex> lock(state->shelves_mutex);
+            size_t count = 0;
+            for (auto &entry : state->shelves)
+            {
+                std::lock_guard<std::mutex> shelf_lock(entry.second->mutex);
+                count += entry.second->free_list.size();
+            }
+            return count;
         }
 
+        // 池持有的全部内存 / 其中空闲的内存（字节）
+        size_t get_total_bytes() const { return state->total_bytes.load(std::memory_order_relaxed); }
+        size_t get_idle_bytes() const { return state->idle_bytes.load(std::memory_order_relaxed); }
+
     private:
-        std::unordered_map<size_t, std::vector<std::shared_ptr<Buffer>>> buffer_pools; // 存储不同大小的缓冲池
-        std::unordered_map<Buffer *, bool> buffer_in_use;                              // 跟踪每个缓冲区是否正在使用
-        std::mutex mutex;
+        // 同一类型、同一尺寸级的空闲链表
+        struct Shelf
+        {
+            std::mutex mutex;
+            size_t capacity = 0;                                // 该级缓冲区的容量
+            size_t count = 0;                                   // 该级存活的缓冲区数（空闲 + 使用中）
+            std::vector<std::unique_ptr<Buffer>> free_list;     // 空闲缓冲区，后进先出（缓存更热）
+            std::vector<void *> free_blocks;                    // 回收的 shared_ptr 控制块
+            size_t block_size = 0;
+            std::atomic<uint64_t> last_use{0};                  // 最近一次获取的逻辑时间，用于裁剪排序
+        };
+
+        // 池的共享状态。句柄的控制块持有它，BufferPool 先于句柄析构也不会悬空
+        struct State
+        {
+            Options options;
+            mutable std::shared_mutex shelves_mutex;
+            std::unordered_map<uint64_t, std::unique_ptr<Shelf>> shelves;
+            std::atomic<size_t> total_bytes{0};
+            std::atomic<size_t> idle_bytes{0};
+            std::atomic<uint64_t> clock{0};
+
+            explicit State(const Options &options) : options(options)
+            {
+                // 公比不大于 1 时 size_class 的几何增长循环不会结束
+                if (options.size_class == Options::SizeClass::GEOMETRIC && !(options.growth > 1.0))
+                {
+                    throw std::invalid_argument("BufferPool GEOMETRIC size classes need growth > 1.");
+                }
+            }
+
+            ~State()
+            {
+                for (auto &entry : shelves)
+                {
+                    for (void *block : entry.second->free_blocks)
+                    {
+                        ::operator delete(block);
+                    }
+                }
+            }
+
+            static size_t round_up(size_t value, size_t alignment)
+            {
+                return alignment ? (value + alignment - 1) / alignment * alignment : value;
+            }
+
+            size_t size_class(size_t size) const
+            {
+                switch (options.size_class)
+                {
+                case Options::SizeClass::POWER_OF_TWO:
+                {
+                    size_t capacity = options.page_size ? options.page_size : 1;
+                    while (capacity < size)
+                    {
+                        capacity <<= 1;
+                    }
+                    return capacity;
+                }
+                case Options::SizeClass::GEOMETRIC:
+                {
+                    double capacity = static_cast<double>(options.page_size ? options.page_size : 1);
+                    while (capacity < static_cast<double>(size))
+                    {
+                        capacity *= options.growth;
+                    }
+                    return round_up(static_cast<size_t>(capacity), options.page_size);
+                }
+                default:
+                    return size;
+                }
+            }
+
+            // 按最久未使用的尺寸级依次释放空闲缓冲区
+            void trim(size_t target_idle_bytes)
+            {
+                std::shared_lock<std::shared_mutex> lock(shelves_mutex);
+                // 先快照 last_use 再排序：get_buffer 会在其他线程并发更新它，直接比较原子值不是严格弱序
+                std::vector<std::pair<uint64_t, Shelf *>> order;
+                order.reserve(shelves.size());
+                for (auto &entry : shelves)
+                {
+                    order.emplace_back(entry.second->last_use.load(std::memory_order_relaxed), entry.second.get());
+                }
+                std::sort(order.begin(), order.end(), [](const std::pair<uint64_t, Shelf *> &a, const std::pair<uint64_t, Shelf *> &b)
+                          { return a.first < b.first; });
+
+                for (auto &entry : order)
+                {
+                    Shelf *shelf = entry.second;
+                    while (idle_bytes.load(std::memory_order_relaxed) > target_idle_bytes)
+                    {
+                        std::unique_ptr<Buffer> victim;
+                        {
+                            std::lock_guard<std::mutex> shelf_lock(shelf->mutex);
+                            if (shelf->free_list.empty())
+                            {
+                                break;
+                            }
+                            victim = std::move(shelf->free_list.front());
+                            shelf->free_list.erase(shelf->free_list.begin());
+                            shelf->count--;
+                        }
+                        idle_bytes.fetch_sub(shelf->capacity, std::memory_order_relaxed);
+                        total_bytes.fetch_sub(shelf->capacity, std::memory_order_relaxed);
+                    }
+                }
+            }
+        };
+
+        // 句柄删除器：把缓冲区放回空闲链表，空闲内存超过上限时触发裁剪
+        struct Releaser
+        {
+            Shelf *shelf;
+            State *state;
+
+            void operator()(Buffer *buffer) const
+            {
+                {
+                    std::lock_guard<std::mutex> lock(shelf->mutex);
+                    shelf->free_list.emplace_back(buffer);
+                }
+                size_t idle = state->idle_bytes.fetch_add(shelf->capacity, std::memory_order_relaxed) + shelf->capacity;
+                const Options &options = state->options;
+                if (options.high_watermark != 0 && idle > options.high_watermark)
+                {
+                    state->trim(std::min(options.low_watermark, options.high_watermark));
+                }
+            }
+        };
+
+        // shared_ptr 控制块分配器：按尺寸回收控制块，同时让控制块持有池状态
+        template <typename T>
+        struct BlockAllocator
+        {
+            using value_type = T;
+
+            std::shared_ptr<State> state;
+            Shelf *shelf;
+
+            BlockAllocator(std::shared_ptr<State> state, Shelf *shelf) : state(std::move(state)), shelf(shelf) {}
+
+            template <typename U>
+            BlockAllocator(const BlockAllocator<U> &other) : state(other.state), shelf(other.shelf) {}
+
+            T *allocate(size_t n)
+            {
+                size_t bytes = n * sizeof(T);
+                {
+                    std::lock_guard<std::mutex> lock(shelf->mutex);
+                    if (bytes == shelf->block_size && !shelf->free_blocks.empty())
+                    {
+                        void *block = shelf->free_blocks.back();
+                        shelf->free_blocks.pop_back();
+                        return static_cast<T *>(block);
+                    }
+                }
+                return static_cast<T *>(::operator new(bytes));
+            }
+
+            void deallocate(T *p, size_t n)
+            {
+                size_t bytes = n * sizeof(T);
+                std::lock_guard<std::mutex> lock(shelf->mutex);
+                if (shelf->block_size == 0)
+                {
+                    shelf->block_size = bytes;
+                }
+                if (bytes == shelf->block_size)
+                {
+                    shelf->free_blocks.push_back(p);
+                    return;
+                }
+                ::operator delete(p);
+            }
+
+            template <typename U>
+            bool operator==(const BlockAllocator<U> &other) const { return shelf == other.shelf; }
+            template <typename U>
+            bool operator!=(const BlockAllocator<U> &other) const { return shelf != other.shelf; }
+        };
+
         std::vector<size_t> buffer_sizes; // 支持的不同大小的缓冲区
-        // cl_mem 缓存
-        std::unordered_map<std::tuple<size_t, size_t, size_t, bool>, cl_mem> cl_mem_cache;
-        std::mutex cl_mem_mutex;
+        std::shared_ptr<State> state;
 
-        void allocate_buffers()
+        static uint64_t shelf_key(Buffer::Type type, size_t capacity)
+        {
+            return (static_cast<uint64_t>(capacity) << 2) | static_cast<uint64_t>(type);
+        }
+
+        // 查找 size 所在尺寸级的空闲链表，只有第一次遇到新尺寸级时才加写锁
+        Shelf &get_shelf(Buffer::Type type, size_t size)
+        {
+            size_t capacity = state->size_class(size);
+            uint64_t key = shelf_key(type, capacity);
+            {
+                std::shared_lock<std::shared_mutex> lock(state->shelves_mutex);
+                auto it = state->shelves.find(key);
+                if (it != state->shelves.end())
+                {
+                    return *it->second;
+                }
+            }
+            std::unique_lock<std::shared_mutex> lock(state->shelves_mutex);
+            auto &shelf = state->shelves[key];
+            if (!shelf)
+            {
+                shelf = std::make_unique<Shelf>();
+                shelf->capacity = capacity;
+            }
+            return *shelf;
+        }
+
+        void allocate_buffers(size_t buffers_per_size)
         {
             // 为每个支持的大小分配内存池
             for (auto size : buffer_sizes)
             {
-                buffer_pools[size] = std::vector<std::shared_ptr<Buffer>>();
+                Shelf &shelf = get_shelf(Buffer::Type::NORMAL, size);
+                for (size_t i = 0; i < buffers_per_size; ++i)
+                {
+                    shelf.free_list.push_back(std::make_unique<Buffer>(Buffer::Type::NORMAL, shelf.capacity, -1, state->options.alloc));
+                    shelf.count++;
+                    state->total_bytes.fetch_add(shelf.capacity, std::memory_order_relaxed);
+                    state->idle_bytes.fetch_add(shelf.capacity, std::memory_order_relaxed);
+                }
+                shelf.free_list.reserve(shelf.count);
             }
         }
     };
@@ -0,0 +1,817 @@
+#pragma once
+#include <memory>
+#include <CL/cl.h>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sstream>
+#include <unordered_map>
+#include <map>
+#include <fstream>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+
+#include "BufferPool.h"
+#include "Plane.h"
+#include "Image.h"
+#include "ProgramCache.h"
+#include "WorkSizeTuner.h"
+
+namespace bos::mm
+{
+    // 纯布局操作（拼接、拆分、重排）的执行方式
+    enum class LayoutBackend
+    {
+        KERNEL, // 内核逐段搬运
+        COPY,   // clEnqueueCopyBufferRect 批量提交，交给拷贝引擎或运行时的 memcpy，计算单元空闲
+        AUTO    // 按设备实测的分界点在两者之间选择
+    };
+
+    // NV21 图像在 cl_mem 中的位置，供拷贝路径使用
+    struct Nv21Target
+    {
+        cl_mem y, uv;           // Y、UV 平面所在的 cl_mem（可以是同一个）
+        size_t y_base, uv_base; // 平面在 cl_mem 中的起始偏移（字节）
+        size_t step;            // 行距（Y 与 UV 相同）
+    };
+
+    // 用拷贝引擎搬运一个 NV21 矩形：Y、UV 各一条 clEnqueueCopyBufferRect，坐标和尺寸为偶数。
+    // event 只挂在最后一条命令上，要求队列顺序执行
+    inline cl_int enqueue_copy_rect_nv21(cl_command_queue queue, const Nv21Target &src, size_t src_x, size_t src_y,
+                                         const Nv21Target &dst, size_t dst_x, size_t dst_y, size_t width, size_t height,
+                                         cl_event *event = nullptr)
+    {
+        size_t src_origin[3] = {src.y_base + src_x, src_y, 0};
+        size_t dst_origin[3] = {dst.y_base + dst_x, dst_y, 0};
+        size_t region[3] = {width, height, 1};
+        cl_int err = clEnqueueCopyBufferRect(queue, src.y, dst.y, src_origin, dst_origin, region,
+                                             src.step, 0, dst.step, 0, 0, nullptr, nullptr);
+        if (err != CL_SUCCESS)
+        {
+            return err;
+        }
+        size_t src_uv_origin[3] = {src.uv_base + src_x, src_y / 2, 0};
+        size_t dst_uv_origin[3] = {dst.uv_base + dst_x, dst_y / 2, 0};
+        size_t uv_region[3] = {width, height / 2, 1};
+        return clEnqueueCopyBufferRect(queue, src.uv, dst.uv, src_uv_origin, dst_uv_origin, uv_region,
+                                       src.step, 0, dst.step, 0, 0, nullptr, event);
+    }
+
+    // 图像在 cl_mem 中的位置：连续图像用整帧 cl_mem 加平面偏移，否则用各平面自己的 cl_mem
+    inline Nv21Target nv21_target(Image &image, cl_context context, cl_command_queue queue)
+    {
+        const auto &planes = image.get_planes();
+        size_t step = planes[0]->get_stride();
+        if (image.get_buffer())
+        {
+            cl_mem mem = image.get_cl_mem(context);
+            return {mem, mem, planes[0]->get_offset(), planes[1]->get_offset(), step};
+        }
+        return {planes[0]->to_cl_mem(context, queue), planes[1]->to_cl_mem(context, queue), 0, 0, step};
+    }
+
+    // 单条拷贝命令平均搬运的字节数不小于该值时拷贝路径比内核快。
+    // 每个设备只实测一次，结果写入 <程序缓存目录>/crossover.txt（定义在 TileRemap 之后）
+    inline size_t copy_crossover(cl_context context, cl_device_id device);
+
+    // 在设备上实测分界点，不查缓存
+    inline size_t measure_copy_crossover(cl_context context, cl_device_id device);
+
+    // 每个 NV21 矩形对应 Y、UV 两条拷贝命令，平均每条搬运 width * height * 3 / 4 字节
+    inline bool prefer_copy(cl_context context, cl_device_id device, size_t total_bytes, size_t rects)
+    {
+        return rects > 0 && total_bytes / (2 * rects) >= copy_crossover(context, device);
+    }
+
+    // 一路输入在拼接画面中的位置；宽、高和左上角坐标都必须是偶数（NV21 色度按 2x2 采样）
+    struct MosaicTile
+    {
+        size_t width, height; // 输入画面尺寸（不缩放）
+        size_t dst_x, dst_y;  // 在输出中的左上角
+    };
+
+    // N 路 NV21 拼接：所有输入放在同一个连续的源 Buffer 中（每路一个槽位），
+    // 生产者直接写入各自槽位的平面，compose() 用 compose_mosaic.cl 一次启动写完整张输出
+    class MosaicCompose
+    {
+    public:
+        // 与 compose_mosaic.cl 中的 mosaic_tile 一一对应
+        struct MosaicTileDesc
+        {
+            cl_int src_y_offset, src_uv_offset, src_step;
+            cl_int width, height, dst_x, dst_y, reserved;
+        };
+
+        MosaicCompose(cl_context context, cl_device_id device, size_t dst_width, size_t dst_height,
+                      const std::vector<MosaicTile> &tiles, BufferPool &buffer_pool,
+                      const ImageLayoutOptions &layout = ImageLayoutOptions(), LayoutBackend backend = LayoutBackend::AUTO)
+            : context(context), device(device), backend(backend), tiles(tiles),
+              output(Image::Format::NV21, dst_width, dst_height, buffer_pool, layout)
+        {
+            if (tiles.empty())
+            {
+                throw std::invalid_argument("Mosaic needs at least one tile.");
+            }
+
+            // 按槽位排布源缓冲区：每路一帧 NV21，槽位起点按 plane_alignment 对齐
+            size_t slot_alignment = std::max<size_t>(layout.plane_alignment, 64);
+            size_t offset = 0;
+            std::vector<std::vector<Image::PlaneLayout>> slots;
+            for (const auto &tile : tiles)
+            {
+                if (tile.width % 2 || tile.height % 2 || tile.dst_x % 2 || tile.dst_y % 2 ||
+                    tile.dst_x + tile.width > dst_width || tile.dst_y + tile.height > dst_height)
+                {
+                    throw std::invalid_argument("Mosaic tile must be even-aligned and inside the output.");
+                }
+                std::vector<Image::PlaneLayout> slot;
+                offset = (offset + slot_alignment - 1) / slot_alignment * slot_alignment;
+                size_t size = Image::compute_layout(Image::Format::NV21, tile.width, tile.height, layout, slot);
+                for (auto &plane : slot)
+                {
+                    plane.offset += offset;
+                }
+                offset += size;
+                slots.push_back(slot);
+                max_height = std::max(max_height, tile.height);
+                max_width = std::max(max_width, tile.width);
+            }
+
+            source = buffer_pool.get_buffer(Buffer::Type::NORMAL, offset);
+            for (const auto &slot : slots)
+            {
+                sources.emplace_back();
+                for (const auto &plane : slot)
+                {
+                    sources.back().push_back(std::make_shared<Plane>(plane.width, plane.height, plane.stride, source, plane.offset));
+                }
+                descs.push_back({static_cast<cl_int>(slot[0].offset), static_cast<cl_int>(slot[1].offset),
+                                 static_cast<cl_int>(slot[0].stride), 0, 0, 0, 0, 0});
+            }
+            for (size_t i = 0; i < tiles.size(); ++i)
+            {
+                descs[i].width = static_cast<cl_int>(tiles[i].width);
+                descs[i].height = static_cast<cl_int>(tiles[i].height);
+                descs[i].dst_x = static_cast<cl_int>(tiles[i].dst_x);
+                descs[i].dst_y = static_cast<cl_int>(tiles[i].dst_y);
+            }
+
+            // tile 描述表：只读，内核以 __constant 参数访问
+            cl_int err = CL_SUCCESS;
+            tile_table = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                        descs.size() * sizeof(MosaicTileDesc), descs.data(), &err);
+            if (err != CL_SUCCESS)
+            {
+                throw std::runtime_error("Failed to create mosaic tile table: " + std::to_string(err));
+            }
+        }
+
+        MosaicCompose(const MosaicCompose &) = delete;
+        MosaicCompose &operator=(const MosaicCompose &) = delete;
+
+        ~MosaicCompose()
+        {
+            if (kernel)
+            {
+                clReleaseKernel(kernel);
+                clReleaseProgram(program);
+            }
+            clReleaseMemObject(tile_table);
+        }
+
+        // cols x rows 的等大宫格布局
+        static std::vector<MosaicTile> grid(size_t cols, size_t rows, size_t tile_width, size_t tile_height)
+        {
+            std::vector<MosaicTile> tiles;
+            for (size_t r = 0; r < rows; ++r)
+            {
+                for (size_t c = 0; c < cols; ++c)
+                {
+                    tiles.push_back({tile_width, tile_height, c * tile_width, r * tile_height});
+                }
+            }
+            return tiles;
+        }
+
+        size_t get_tile_count() const { return tiles.size(); }
+
+        // 第 i 路输入的 Y、UV 平面，生产者直接写入，无需再拷贝到拼接缓冲区
+        const std::vector<std::shared_ptr<Plane>> &get_source(size_t i) const { return sources.at(i); }
+
+        // 所有输入所在的源 Buffer
+        const std::shared_ptr<Buffer> &get_source_buffer() const { return source; }
+
+        // 拼接输出
+        Image &get_output() { return output; }
+
+        // 主机写完输入后同步到设备（USE_HOST_PTR 下需要 map/unmap），整个源缓冲区一次传输。
+        // 与 Image::sync_to_device 一样用 INVALIDATE_REGION，避免设备旧数据覆盖主机刚写的输入
+        cl_int sync_sources_to_device(cl_command_queue queue)
+        {
+            cl_mem mem = source->get_cl_mem(context);
+            if (mem == nullptr)
+            {
+                return CL_INVALID_MEM_OBJECT;
+            }
+            cl_int err = CL_SUCCESS;
+            void *mapped = clEnqueueMapBuffer(queue, mem, CL_TRUE, CL_MAP_WRITE_INVALIDATE_REGION, 0, source->get_size(), 0, nullptr, nullptr, &err);
+            if (err != CL_SUCCESS)
+            {
+                return err;
+            }
+            return clEnqueueUnmapMemObject(queue, mem, mapped, 0, nullptr, nullptr);
+        }
+
+        // 实际使用的执行方式；AUTO 在第一次 compose 时按设备分界点确定
+        LayoutBackend get_backend()
+        {
+            if (backend == LayoutBackend::AUTO)
+            {
+                size_t bytes = 0;
+                for (const auto &tile : tiles)
+                {
+                    bytes += tile.width * tile.height * 3 / 2;
+                }
+                backend = prefer_copy(context, device, bytes, tiles.size()) ? LayoutBackend::COPY : LayoutBackend::KERNEL;
+            }
+            return backend;
+        }
+
+        // 写完整张拼接画面：内核路径一次启动，拷贝路径每路两条 clEnqueueCopyBufferRect。
+        // 未被任何 tile 覆盖的区域保持原值
+        cl_int compose(cl_command_queue queue, cl_event *event = nullptr)
+        {
+            if (get_backend() == LayoutBackend::COPY)
+            {
+                cl_mem mem = source->get_cl_mem(context);
+                Nv21Target dst = nv21_target(output, context, queue);
+                if (mem == nullptr || dst.y == nullptr || dst.uv == nullptr)
+                {
+                    return CL_INVALID_MEM_OBJECT;
+                }
+                for (size_t i = 0; i < tiles.size(); ++i)
+                {
+                    Nv21Target src = {mem, mem, static_cast<size_t>(descs[i].src_y_offset),
+                                      static_cast<size_t>(descs[i].src_uv_offset), static_cast<size_t>(descs[i].src_step)};
+                    cl_int err = enqueue_copy_rect_nv21(queue, src, 0, 0, dst, tiles[i].dst_x, tiles[i].dst_y,
+                                                        tiles[i].width, tiles[i].height, i + 1 == tiles.size() ? event : nullptr);
+                    if (err != CL_SUCCESS)
+                    {
+                        return err;
+                    }
+                }
+                return CL_SUCCESS;
+            }
+
+            cl_int err = build_kernel();
+            if (err != CL_SUCCESS)
+            {
+                return err;
+            }
+            cl_mem src = source->get_cl_mem(context);
+            cl_mem dst_y = output.get_planes()[0]->to_cl_mem(context, queue);
+            cl_mem dst_uv = output.get_planes()[1]->to_cl_mem(context, queue);
+            if (src == nullptr || dst_y == nullptr || dst_uv == nullptr)
+            {
+                return CL_INVALID_MEM_OBJECT;
+            }
+            cl_int dst_step = static_cast<cl_int>(output.get_planes()[0]->get_stride());
+
+            err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &src);
+            err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &dst_y);
+            err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &dst_uv);
+            err |= clSetKernelArg(kernel, 3, sizeof(cl_int), &dst_step);
+            err |= clSetKernelArg(kernel, 4, sizeof(cl_mem), &tile_table);
+            if (err != CL_SUCCESS)
+            {
+                return err;
+            }
+
+            size_t global_size[3] = {(max_width + vec - 1) / vec, max_height * 3 / 2, tiles.size()};
+            return enqueue_tuned(queue, kernel, 3, global_size, event);
+        }
+
+    private:
+        // 内核路径第一次使用时编译 compose_mosaic.cl（命中磁盘缓存时直接加载）
+        cl_int build_kernel()
+        {
+            if (kernel)
+            {
+                return CL_SUCCESS;
+            }
+            cl_int err = CL_SUCCESS;
+            std::string options = "-D COMPOSE_VEC=" + std::to_string(vec);
+            program = program_cache_build(context, device, "compose_mosaic.cl", options.c_str(), nullptr, &err);
+            if (program == nullptr)
+            {
+                return err;
+            }
+            kernel = clCreateKernel(program, "compose_mosaic", &err);
+            if (err != CL_SUCCESS)
+            {
+                clReleaseProgram(program);
+                program = nullptr;
+                kernel = nullptr;
+            }
+            return err;
+        }
+
+        static constexpr size_t vec = 16; // 每个工作项搬运的字节数（COMPOSE_VEC）
+
+        cl_context context;
+        cl_device_id device;
+        LayoutBackend backend;
+        std::vector<MosaicTile> tiles;
+        std::vector<MosaicTileDesc> descs;
+        Image output;
+        std::shared_ptr<Buffer> source;                           // 所有输入的连续源缓冲区
+        std::vector<std::vector<std::shared_ptr<Plane>>> sources; // 每路输入的 Y、UV 平面
+        size_t max_width = 0, max_height = 0;
+        cl_mem tile_table = nullptr;
+        cl_program program = nullptr;
+        cl_kernel kernel = nullptr;
+    };
+
+    // 分块重排布局：若干源矩形 -> 输出位置，加上若干填充黑边的矩形。
+    // 所有坐标和尺寸必须是偶数（NV21 色度按 2x2 采样）
+    struct RemapLayout
+    {
+        struct Entry
+        {
+            int src_x, src_y, width, height;
+            int dst_x, dst_y;
+            bool fill; // true 时填充黑边，忽略 src_x/src_y
+        };
+
+        size_t src_width = 0, src_height = 0;
+        size_t dst_width = 0, dst_height = 0;
+        std::vector<Entry> entries;
+
+        RemapLayout(size_t src_width, size_t src_height, size_t dst_width, size_t dst_height)
+            : src_width(src_width), src_height(src_height), dst_width(dst_width), dst_height(dst_height) {}
+
+        // 把源图像中 (src_x, src_y) 起 width x height 的矩形搬到输出的 (dst_x, dst_y)
+        RemapLayout &add_tile(int src_x, int src_y, int width, int height, int dst_x, int dst_y)
+        {
+            check(dst_x, dst_y, width, height, dst_width, dst_height);
+            check(src_x, src_y, width, height, src_width, src_height);
+            entries.push_back({src_x, src_y, width, height, dst_x, dst_y, false});
+            return *this;
+        }
+
+        // 用黑色填充输出中 (x, y) 起 width x height 的矩形；空矩形直接忽略
+        RemapLayout &add_fill(int x, int y, int width, int height)
+        {
+            if (width <= 0 || height <= 0)
+            {
+                return *this;
+            }
+            check(x, y, width, height, dst_width, dst_height);
+            entries.push_back({0, 0, width, height, x, y, true});
+            return *this;
+        }
+
+        // 源图像横向均分为 order.size() 块，按 order 的顺序横向排布到输出中，块之间及左右留出相等的黑边，
+        // 上下黑边平分剩余高度（testrearrange 的 3,4,1,2 排布即 order = {2, 3, 0, 1}）
+        static RemapLayout block_permutation(size_t src_width, size_t src_height, const std::vector<int> &order,
+                                             size_t dst_width, size_t dst_height)
+        {
+            RemapLayout layout(src_width, src_height, dst_width, dst_height);
+            int blocks = static_cast<int>(order.size());
+            int block_width = static_cast<int>(src_width) / blocks;
+            int side = (static_cast<int>(dst_width) - block_width * blocks) / (blocks + 1);
+            int top = (static_cast<int>(dst_height) - static_cast<int>(src_height)) / 2;
+            int height = static_cast<int>(src_height);
+            for (int i = 0; i < blocks; ++i)
+            {
+                int dst_x = side + i * (block_width + side);
+                layout.add_fill(dst_x - side, top, side, height);
+                layout.add_tile(order[i] * block_width, 0, block_width, height, dst_x, top);
+            }
+            int right = side + blocks * (block_width + side) - side;
+            layout.add_fill(right, top, static_cast<int>(dst_width) - right, height);
+            layout.add_fill(0, 0, static_cast<int>(dst_width), top);
+            layout.add_fill(0, top + height, static_cast<int>(dst_width), static_cast<int>(dst_height) - top - height);
+            return layout;
+        }
+
+        // 源图像横向均分为 parts 块，自上而下堆叠：输出 (src_width / parts) x (src_height * parts)
+        // （原 testgrid 内联的 rearrange_nv21 和 gridnv21.cl 的 nv21_split_and_assemble 即 parts = 2）
+        static RemapLayout split_stack(size_t src_width, size_t src_height, int parts)
+        {
+            int part_width = static_cast<int>(src_width) / parts;
+            int height = static_cast<int>(src_height);
+            RemapLayout layout(src_width, src_height, part_width, src_height * parts);
+            for (int i = 0; i < parts; ++i)
+            {
+                layout.add_tile(i * part_width, 0, part_width, height, 0, i * height);
+            }
+            return layout;
+        }
+
+        // rearrange.cl 的编译选项：把条目表编译成 __constant 常量
+        std::string build_options(int vec = 16) const
+        {
+            std::ostringstream options;
+            options << "-D REMAP_VEC=" << vec << " -D NUM_ENTRIES=" << entries.size() << " -D ENTRIES=";
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                const Entry &e = entries[i];
+                options << (i ? "," : "") << "(int8)(" << e.src_x << "," << e.src_y << "," << e.width << ","
+                        << e.height << "," << e.dst_x << "," << e.dst_y << "," << (e.fill ? 1 : 0) << ",0)";
+            }
+            return options.str();
+        }
+
+    private:
+        static void check(int x, int y, int width, int height, size_t bound_width, size_t bound_height)
+        {
+            if (x < 0 || y < 0 || width <= 0 || height <= 0 || (x | y | width | height) & 1 ||
+                static_cast<size_t>(x + width) > bound_width || static_cast<size_t>(y + height) > bound_height)
+            {
+                throw std::invalid_argument("Remap rectangle must be even-aligned and inside the image.");
+            }
+        }
+    };
+
+    // 按 RemapLayout 执行整张 NV21 的分块重排和黑边填充。
+    // 内核路径：rearrange.cl 的 remap_nv21，布局编译进内核，一次启动；
+    // 拷贝路径：每个矩形 Y、UV 各一条 clEnqueueCopyBufferRect，黑边从预先填好的黑色缓冲区拷贝
+    class TileRemap
+    {
+    public:
+        TileRemap(cl_context context, cl_device_id device, const RemapLayout &layout, LayoutBackend backend = LayoutBackend::AUTO)
+            : context(context), device(device), backend(backend), layout(layout)
+        {
+            if (layout.entries.empty())
+            {
+                throw std::invalid_argument("Remap layout has no entries.");
+            }
+            for (const auto &e : layout.entries)
+            {
+                max_width = std::max(max_width, static_cast<size_t>(e.width));
+                max_height = std::max(max_height, static_cast<size_t>(e.height));
+            }
+        }
+
+        TileRemap(const TileRemap &) = delete;
+        TileRemap &operator=(const TileRemap &) = delete;
+
+        ~TileRemap()
+        {
+            if (kernel)
+            {
+                clReleaseKernel(kernel);
+                clReleaseProgram(program);
+            }
+            if (black)
+            {
+                clReleaseMemObject(black);
+            }
+        }
+
+        const RemapLayout &get_layout() const { return layout; }
+
+        // 实际使用的执行方式；AUTO 在第一次 run 时按设备分界点确定
+        LayoutBackend get_backend()
+        {
+            if (backend == LayoutBackend::AUTO)
+            {
+                size_t bytes = 0;
+                for (const auto &e : layout.entries)
+                {
+                    bytes += static_cast<size_t>(e.width) * e.height * 3 / 2;
+                }
+                backend = prefer_copy(context, device, bytes, layout.entries.size()) ? LayoutBackend::COPY : LayoutBackend::KERNEL;
+            }
+            return backend;
+        }
+
+        // src / dst 必须是 NV21/NV12，尺寸与布局一致
+        cl_int run(cl_command_queue queue, Image &src, Image &dst, cl_event *event = nullptr)
+        {
+            if (src.get_width() != layout.src_width || src.get_height() != layout.src_height ||
+                dst.get_width() != layout.dst_width || dst.get_height() != layout.dst_height ||
+                src.get_planes().size() != 2 || dst.get_planes().size() != 2)
+            {
+                return CL_INVALID_VALUE;
+            }
+            if (get_backend() == LayoutBackend::COPY)
+            {
+                return run_copy(queue, src, dst, event);
+            }
+
+            cl_int err = build_kernel();
+            if (err != CL_SUCCESS)
+            {
+                return err;
+            }
+            cl_mem src_y = src.get_planes()[0]->to_cl_mem(context, queue);
+            cl_mem src_uv = src.get_planes()[1]->to_cl_mem(context, queue);
+            cl_mem dst_y = dst.get_planes()[0]->to_cl_mem(context, queue);
+            cl_mem dst_uv = dst.get_planes()[1]->to_cl_mem(context, queue);
+            if (src_y == nullptr || src_uv == nullptr || dst_y == nullptr || dst_uv == nullptr)
+            {
+                return CL_INVALID_MEM_OBJECT;
+            }
+            cl_int src_step = static_cast<cl_int>(src.get_planes()[0]->get_stride());
+            cl_int dst_step = static_cast<cl_int>(dst.get_planes()[0]->get_stride());
+
+            err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &src_y);
+            err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &src_uv);
+            err |= clSetKernelArg(kernel, 2, sizeof(cl_int), &src_step);
+            err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &dst_y);
+            err |= clSetKernelArg(kernel, 4, sizeof(cl_mem), &dst_uv);
+            err |= clSetKernelArg(kernel, 5, sizeof(cl_int), &dst_step);
+            if (err != CL_SUCCESS)
+            {
+                return err;
+            }
+
+            size_t global_size[3] = {(max_width + vec - 1) / vec, max_height * 3 / 2, layout.entries.size()};
+            if (!tuned)
+            {
+                return enqueue_geometry(queue, kernel, 3, global_size, WorkGeometry(), event);
+            }
+            return enqueue_tuned(queue, kernel, 3, global_size, event);
+        }
+
+    private:
+        // 分界点标定用的一次性布局不进 worksize.txt，local 交给驱动
+        friend size_t measure_copy_crossover(cl_context context, cl_device_id device);
+
+        cl_int run_copy(cl_command_queue queue, Image &src, Image &dst, cl_event *event)
+        {
+            Nv21Target from = nv21_target(src, context, queue);
+            Nv21Target to = nv21_target(dst, context, queue);
+            if (from.y == nullptr || from.uv == nullptr || to.y == nullptr || to.uv == nullptr)
+            {
+                return CL_INVALID_MEM_OBJECT;
+            }
+            cl_int err = CL_SUCCESS;
+            Nv21Target fill = black_target(queue, err);
+            if (err != CL_SUCCESS)
+            {
+                return err;
+            }
+            for (size_t i = 0; i < layout.entries.size(); ++i)
+            {
+                const auto &e = layout.entries[i];
+                cl_event *last = i + 1 == layout.entries.size() ? event : nullptr;
+                if (e.fill)
+                {
+                    err = enqueue_copy_rect_nv21(queue, fill, 0, 0, to, e.dst_x, e.dst_y, e.width, e.height, last);
+                }
+                else
+                {
+                    err = enqueue_copy_rect_nv21(queue, from, e.src_x, e.src_y, to, e.dst_x, e.dst_y, e.width, e.height, last);
+                }
+                if (err != CL_SUCCESS)
+                {
+                    return err;
+                }
+            }
+            return CL_SUCCESS;
+        }
+
+        // 拷贝路径的黑边来源：一块足够大的 NV21 黑色图像（Y = 0，UV = 128），第一次使用时用 clEnqueueFillBuffer 填好
+        Nv21Target black_target(cl_command_queue queue, cl_int &err)
+        {
+            size_t width = 0, height = 0;
+            for (const auto &e : layout.entries)
+            {
+                if (e.fill)
+                {
+                    width = std::max(width, static_cast<size_t>(e.width));
+                    height = std::max(height, static_cast<size_t>(e.height));
+                }
+            }
+            size_t y_size = width * height;
+            err = CL_SUCCESS;
+            if (black == nullptr && y_size > 0)
+            {
+                black = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_HOST_NO_ACCESS, y_size * 3 / 2, nullptr, &err);
+                if (err != CL_SUCCESS)
+                {
+                    black = nullptr;
+                    return {};
+                }
+                cl_uchar zero = 0, gray = 128;
+                err = clEnqueueFillBuffer(queue, black, &zero, 1, 0, y_size, 0, nullptr, nullptr);
+                if (err == CL_SUCCESS)
+                {
+                    err = clEnqueueFillBuffer(queue, black, &gray, 1, y_size, y_size / 2, 0, nullptr, nullptr);
+                }
+            }
+            return {black, black, 0, y_size, width};
+        }
+
+        // 内核路径第一次使用时编译 rearrange.cl（命中磁盘缓存时直接加载）
+        cl_int build_kernel()
+        {
+            if (kernel)
+            {
+                return CL_SUCCESS;
+            }
+            cl_int err = CL_SUCCESS;
+            std::string options = layout.build_options(static_cast<int>(vec));
+            program = program_cache_build(context, device, "rearrange.cl", options.c_str(), nullptr, &err);
+            if (program == nullptr)
+            {
+                return err;
+            }
+            kernel = clCreateKernel(program, "remap_nv21", &err);
+            if (err != CL_SUCCESS)
+            {
+                clReleaseProgram(program);
+                program = nullptr;
+                kernel = nullptr;
+            }
+            return err;
+        }
+
+        static constexpr size_t vec = 16; // 每个工作项处理的字节数（REMAP_VEC）
+
+        cl_context context;
+        cl_device_id device;
+        LayoutBackend backend;
+        RemapLayout layout;
+        size_t max_width = 0, max_height = 0;
+        cl_program program = nullptr;
+        cl_kernel kernel = nullptr;
+        cl_mem black = nullptr; // 拷贝路径的黑边来源
+        bool tuned = true;      // 内核路径是否经 WorkSizeTuner 选择 local
+    };
+
+    inline size_t measure_copy_crossover(cl_context context, cl_device_id device)
+    {
+        // 固定几何：一帧 1024x1024 NV21 整块搬运。内核路径一次启动（不经调优，local 交给驱动），得到每字节的时间 k；
+        // 拷贝路径分别按 1 个矩形（2 条命令）和 16x16 个 64x64 矩形（512 条命令）搬运同样的字节，
+        // 两者之差给出每条命令的固定开销 o，再得到每字节的时间 p。
+        // 每条命令搬运 s 字节时拷贝不慢于内核：o + s * p <= s * k，即 s >= o / (k - p)；p 不小于 k 时永远走内核
+        const size_t side = 1024, block = 64;
+        cl_int err = CL_SUCCESS;
+        cl_command_queue queue = clCreateCommandQueue(context, device, 0, &err);
+        if (err != CL_SUCCESS)
+        {
+            return SIZE_MAX;
+        }
+        auto best_time = [&](TileRemap &remap, Image &src, Image &dst)
+        {
+            double best = 1e30;
+            for (int i = 0; i < 6; ++i)
+            {
+                auto start = std::chrono::steady_clock::now();
+                if (remap.run(queue, src, dst) != CL_SUCCESS || clFinish(queue) != CL_SUCCESS)
+                {
+                    return -1.0;
+                }
+                double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                // 第一次包含编译/建缓冲区，不计入
+                best = i == 0 ? best : std::min(best, elapsed);
+            }
+            return best;
+        };
+
+        double kernel_time = -1, whole_time = -1, blocks_time = -1;
+        {
+            BufferPool pool({});
+            Image src(Image::Format::NV21, side, side, pool);
+            Image dst(Image::Format::NV21, side, side, pool);
+            int extent = static_cast<int>(side), step = static_cast<int>(block);
+            RemapLayout whole(side, side, side, side);
+            whole.add_tile(0, 0, extent, extent, 0, 0);
+            RemapLayout blocks(side, side, side, side);
+            for (int y = 0; y < extent; y += step)
+            {
+                for (int x = 0; x < extent; x += step)
+                {
+                    blocks.add_tile(x, y, step, step, x, y);
+                }
+            }
+            TileRemap kernel_path(context, device, whole, LayoutBackend::KERNEL);
+            kernel_path.tuned = false;
+            TileRemap copy_whole(context, device, whole, LayoutBackend::COPY);
+            TileRemap copy_blocks(context, device, blocks, LayoutBackend::COPY);
+            kernel_time = best_time(kernel_path, src, dst);
+            whole_time = best_time(copy_whole, src, dst);
+            blocks_time = best_time(copy_blocks, src, dst);
+        }
+        clReleaseCommandQueue(queue);
+
+        if (whole_time < 0 || blocks_time < 0)
+        {
+            return SIZE_MAX;
+        }
+        if (kernel_time < 0)
+        {
+            return 0;
+        }
+        const double bytes = side * side * 3 / 2.0;
+        const double whole_commands = 2, block_commands = 2.0 * (side / block) * (side / block);
+        double overhead = std::max(0.0, (blocks_time - whole_time) / (block_commands - whole_commands));
+        double copy_per_byte = std::max(0.0, (whole_time - whole_commands * overhead) / bytes);
+        double kernel_per_byte = kernel_time / bytes;
+        if (copy_per_byte >= kernel_per_byte)
+        {
+            return SIZE_MAX;
+        }
+        return static_cast<size_t>(overhead / (kernel_per_byte - copy_per_byte)) + 1;
+    }
+
+    inline size_t copy_crossover(cl_context context, cl_device_id device)
+    {
+        static std::mutex mutex;
+        static std::unordered_map<cl_device_id, size_t> crossovers;
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = crossovers.find(device);
+        if (it != crossovers.end())
+        {
+            return it->second;
+        }
+
+        // 文件格式：每行 “设备名|驱动版本<TAB>字节数”，与 worksize.txt 一样按设备区分，驱动升级后重新实测
+        char name[256] = {0}, driver[256] = {0};
+        clGetDeviceInfo(device, CL_DEVICE_NAME, sizeof(name) - 1, name, nullptr);
+        clGetDeviceInfo(device, CL_DRIVER_VERSION, sizeof(driver) - 1, driver, nullptr);
+        std::string key = std::string(name) + "|" + driver;
+        for (char &c : key)
+        {
+            c = c == '\t' || c == '\n' ? ' ' : c;
+        }
+        const char *dir = program_cache_dir();
+        std::string path = dir != nullptr ? std::string(dir) + "/crossover.txt" : std::string();
+        auto load = [&path](std::map<std::string, size_t> &table)
+        {
+            std::ifstream file(path);
+            std::string line;
+            while (std::getline(file, line))
+            {
+                size_t tab = line.find('\t');
+                size_t bytes = 0;
+                std::istringstream value(tab == std::string::npos ? std::string() : line.substr(tab + 1));
+                if (value >> bytes)
+                {
+                    table[line.substr(0, tab)] = bytes;
+                }
+            }
+        };
+
+        std::map<std::string, size_t> table;
+        if (!path.empty())
+        {
+            load(table);
+        }
+        auto stored = table.find(key);
+        size_t crossover = stored != table.end() ? stored->second : measure_copy_crossover(context, device);
+        if (stored == table.end() && !path.empty())
+        {
+            // 与 worksize.txt 相同：加锁后重新读入（合并其他进程的结果），写唯一的临时文件再 rename
+            program_cache_mkdirs(dir);
+            int lock_fd = open((path + ".lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+            if (lock_fd >= 0)
+            {
+                flock(lock_fd, LOCK_EX);
+            }
+            table.clear();
+            load(table);
+            table[key] = crossover;
+            std::string tmp_path = path + ".XXXXXX";
+            int fd = mkstemp(&tmp_path[0]);
+            if (fd >= 0)
+            {
+                fchmod(fd, 0644);
+                close(fd);
+                std::ofstream file(tmp_path);
+                for (const auto &entry : table)
+                {
+                    file << entry.first << '\t' << entry.second << '\n';
+                }
+                file.close();
+                if (file)
+                {
+                    rename(tmp_path.c_str(), path.c_str());
+                }
+                else
+                {
+                    remove(tmp_path.c_str());
+                }
+            }
+            if (lock_fd >= 0)
+            {
+                close(lock_fd); // 关闭即释放 flock
+            }
+        }
+
+        if (getenv("OCL_LAYOUT_VERBOSE") != nullptr)
+        {
+            std::cerr << "copy/kernel crossover: " << (crossover == SIZE_MAX ? std::string("never") : std::to_string(crossover) + " bytes per command")
+                      << std::endl;
+        }
+        crossovers[device] = crossover;
+        return crossover;
+    }
+}
@@ -0,0 +1,570 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <stdexcept>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+#endif
+
+#include "BufferPool.h"
+#include "Image.h"
+
+// 处理结果的异步输出：平面按行（有行距填充时）组成 iovec，作为一次向量写提交，
+// 写完之后才释放 Image / Buffer 的引用，池化的缓冲区随之回到 BufferPool。处理线程只负责提交，
+// 磁盘延迟不会卡住 GPU 流水线，也不需要先把 Y、UV 拼到一块新内存里再写。
+//
+//   IO_URING  直接用 io_uring_setup / io_uring_enter 系统调用（不依赖 liburing），IORING_OP_WRITEV，
+//             一个回收线程等待完成事件
+//   THREADS   若干工作线程执行 pwritev；内核或容器不允许 io_uring 时 AUTO 退回到这里
+//
+// 每次写入在提交时分配好文件偏移，完成顺序无关紧要；输出是管道或终端（不能定位）时只用一个线程按顺序 writev。
+// 同时在途的写入不超过 queue_depth，满了之后 write() 等待最早的完成（唯一的阻塞点）。
+
+namespace bos::mm
+{
+    enum class SinkBackend
+    {
+        AUTO,     // 优先 io_uring，不可用时用线程池
+        IO_URING, // 只用 io_uring，不可用时构造失败
+        THREADS   // 线程池 pwritev
+    };
+
+    struct FrameSinkOptions
+    {
+        size_t queue_depth = 16; // 同时在途的写入数
+        size_t threads = 2;      // THREADS 后端的工作线程数
+        SinkBackend backend = SinkBackend::AUTO;
+    };
+
+    // 图像一个平面每行的有效字节数（不含行距填充）
+    inline size_t image_row_bytes(const Image &image, size_t plane)
+    {
+        const auto &p = image.get_planes()[plane];
+        switch (image.get_format())
+        {
+        case Image::Format::RGB:
+            return p->get_width() * 3;
+        case Image::Format::RGBA:
+            return p->get_width() * 4;
+        case Image::Format::NV21:
+        case Image::Format::NV12:
+            return plane == 0 ? p->get_width() : p->get_width() * 2; // 交织的色度平面每行 width 字节
+        default:
+            return p->get_width();
+        }
+    }
+
+    class FrameSink
+    {
+    public:
+        // path 为 "-" 时写标准输出；否则创建 / 截断文件
+        explicit FrameSink(const std::string &path, const FrameSinkOptions &options = FrameSinkOptions())
+            : options(options)
+        {
+            this->options.queue_depth = std::max<size_t>(options.queue_depth, 1);
+            this->options.threads = std::max<size_t>(options.threads, 1);
+            if (path == "-")
+            {
+                fd = STDOUT_FILENO;
+                owns_fd = false;
+            }
+            else
+            {
+                fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+                if (fd < 0)
+                {
+                    throw std::runtime_error("Failed to open " + path + ": " + strerror(errno));
+                }
+            }
+            seekable = lseek(fd, 0, SEEK_CUR) >= 0;
+            requests.resize(this->options.queue_depth);
+            for (size_t i = 0; i < requests.size(); ++i)
+            {
+                free_slots.push_back(i);
+            }
+
+            if (options.backend != SinkBackend::THREADS && seekable && ring.setup(static_cast<unsigned>(this->options.queue_depth)))
+            {
+                backend = SinkBackend::IO_URING;
+                workers.emplace_back([this]()
+                                     { reap(); });
+                return;
+            }
+            if (options.backend == SinkBackend::IO_URING)
+            {
+                close_fd();
+                throw std::runtime_error("io_uring is not available for " + path + ".");
+            }
+            backend = SinkBackend::THREADS;
+            // 不能定位的输出只能按提交顺序写
+            size_t count = seekable ? this->options.threads : 1;
+            for (size_t i = 0; i < count; ++i)
+            {
+                workers.emplace_back([this]()
+                                     { work(); });
+            }
+        }
+
+        FrameSink(const FrameSink &) = delete;
+        FrameSink &operator=(const FrameSink &) = delete;
+
+        ~FrameSink()
+        {
+            flush();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            if (backend == SinkBackend::IO_URING)
+            {
+                // 一个空操作把回收线程从等待中唤醒
+                std::lock_guard<std::mutex> lock(mutex);
+                ring.submit_nop(STOP);
+            }
+            work_ready.notify_all();
+            for (auto &worker : workers)
+            {
+                worker.join();
+            }
+            ring.teardown();
+            close_fd();
+        }
+
+        // 提交 image 的全部平面，写完后释放这份引用；之前的写入失败过时返回 false
+        bool write(std::shared_ptr<Image> image)
+        {
+            if (image == nullptr)
+            {
+                return false;
+            }
+            std::vector<iovec> iov;
+            for (size_t p = 0; p < image->get_planes().size(); ++p)
+            {
+                Plane &plane = *image->get_planes()[p];
+                size_t row_bytes = image_row_bytes(*image, p);
+                for (size_t y = 0; y < plane.get_height(); ++y)
+                {
+                    uint8_t *row = plane.get_data() + y * plane.get_stride();
+                    // 紧密排列时相邻行（以及相邻平面）合并成一段
+                    if (!iov.empty() && static_cast<uint8_t *>(iov.back().iov_base) + iov.back().iov_len == row)
+                    {
+                        iov.back().iov_len += row_bytes;
+                    }
+                    else
+                    {
+                        iov.push_back({row, row_bytes});
+                    }
+                }
+            }
+            return submit(iov, image);
+        }
+
+        // 提交 buffer 的前 size 字节
+        bool write(std::shared_ptr<Buffer> buffer, size_t size)
+        {
+            if (buffer == nullptr || size > buffer->get_size())
+            {
+                return false;
+            }
+            std::vector<iovec> iov = {{buffer->get_data(), size}};
+            return submit(iov, buffer);
+        }
+
+        // 等待已提交的写入全部完成；有写入失败时返回 false
+        bool flush()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            slot_free.wait(lock, [this]()
+                           { return free_slots.size() == requests.size(); });
+            return error == 0;
+        }
+
+        SinkBackend get_backend() const { return backend; }
+
+        // 第一个失败的写入的 errno，0 表示没有
+        int get_error() const { return error.load(); }
+
+        size_t get_bytes_submitted() const { return bytes_submitted.load(); }
+        size_t get_bytes_written() const { return bytes_written.load(); }
+
+    private:
+        struct Request
+        {
+            std::vector<iovec> iov; // 复用，容量只增不减
+            off_t offset = 0;
+            size_t bytes = 0;
+            std::shared_ptr<void> holder; // 写完前保持内存有效
+        };
+
+        static constexpr uint64_t STOP = UINT64_MAX;
+
+#if defined(IORING_OP_WRITEV) && defined(__NR_io_uring_setup)
+        // 最小的 io_uring 封装：一个提交队列、一个完成队列
+        struct Ring
+        {
+            int fd = -1;
+            unsigned entries = 0;
+            unsigned *sq_head = nullptr, *sq_tail = nullptr, *sq_mask = nullptr, *sq_array = nullptr;
+            unsigned *cq_head = nullptr, *cq_tail = nullptr, *cq_mask = nullptr;
+            io_uring_sqe *sqes = nullptr;
+            io_uring_cqe *cqes = nullptr;
+            void *sq_ptr = MAP_FAILED, *cq_ptr = MAP_FAILED;
+            size_t sq_len = 0, cq_len = 0, sqes_len = 0;
+
+            bool setup(unsigned depth)
+            {
+                io_uring_params params;
+                memset(&params, 0, sizeof(params));
+                fd = static_cast<int>(syscall(__NR_io_uring_setup, depth + 1, &params)); // 多一项留给停止用的空操作
+                if (fd < 0)
+                {
+                    return false;
+                }
+                entries = params.sq_entries;
+                sq_len = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                cq_len = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+                bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+                if (single)
+                {
+                    sq_len = cq_len = std::max(sq_len, cq_len);
+                }
+                sq_ptr = mmap(nullptr, sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+                cq_ptr = single ? sq_ptr : mmap(nullptr, cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+                sqes_len = params.sq_entries * sizeof(io_uring_sqe);
+                void *sqe_ptr = mmap(nullptr, sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+                if (sq_ptr == MAP_FAILED || cq_ptr == MAP_FAILED || sqe_ptr == MAP_FAILED)
+                {
+                    if (sqe_ptr != MAP_FAILED)
+                    {
+                        munmap(sqe_ptr, sqes_len);
+                    }
+                    teardown();
+                    return false;
+                }
+                char *sq = static_cast<char *>(sq_ptr), *cq = static_cast<char *>(cq_ptr);
+                sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+                sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+                sq_mask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+                sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+                cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+                cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+                cq_mask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+                cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+                sqes = static_cast<io_uring_sqe *>(sqe_ptr);
+                return true;
+            }
+
+            // 调用者持有 FrameSink::mutex；每次提交后内核立即取走，提交队列不会积压。
+            // 返回 false 时这一项已从提交队列撤回，调用者可以同步写完并复用槽位
+            bool submit(uint8_t opcode, int file, const iovec *iov, unsigned count, off_t offset, uint64_t user_data)
+            {
+                unsigned tail = *sq_tail;
+                unsigned index = tail & *sq_mask;
+                io_uring_sqe &sqe = sqes[index];
+                memset(&sqe, 0, sizeof(sqe));
+                sqe.opcode = opcode;
+                sqe.fd = file;
+                sqe.addr = reinterpret_cast<uint64_t>(iov);
+                sqe.len = count;
+                sqe.off = static_cast<uint64_t>(offset);
+                sqe.user_data = user_data;
+                sq_array[index] = index;
+                __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+                long ret;
+                do
+                {
+                    ret = syscall(__NR_io_uring_enter, fd, 1, 0, 0, nullptr, 0);
+                } while (ret < 0 && errno == EINTR);
+                if (ret == 1)
+                {
+                    return true;
+                }
+                // EAGAIN/EBUSY/ENOMEM 等失败：内核没有取走这一项时撤回尾指针，否则下次 enter 会提交过期的请求；
+                // 已经取走则照常等它的完成事件
+                if (__atomic_load_n(sq_head, __ATOMIC_ACQUIRE) == tail)
+                {
+                    __atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+                    return false;
+                }
+                return true;
+            }
+
+            bool submit_writev(int file, const iovec *iov, unsigned count, off_t offset, uint64_t user_data)
+            {
+                return submit(IORING_OP_WRITEV, file, iov, count, offset, user_data);
+            }
+
+            void submit_nop(uint64_t user_data)
+            {
+                submit(IORING_OP_NOP, -1, nullptr, 0, 0, user_data);
+            }
+
+            // 等待一个完成事件；返回 false 表示出错
+            bool wait(uint64_t &user_data, int &result)
+            {
+                for (;;)
+                {
+                    unsigned head = *cq_head;
+                    if (head != __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+                    {
+                        const io_uring_cqe &cqe = cqes[head & *cq_mask];
+                        user_data = cqe.user_data;
+                        result = cqe.res;
+                        __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+                        return true;
+                    }
+                    if (syscall(__NR_io_uring_enter, fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR)
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            void teardown()
+            {
+                if (sqes)
+                {
+                    munmap(sqes, sqes_len);
+                }
+                if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr)
+                {
+                    munmap(cq_ptr, cq_len);
+                }
+                if (sq_ptr != MAP_FAILED)
+                {
+                    munmap(sq_ptr, sq_len);
+                }
+                if (fd >= 0)
+                {
+                    close(fd);
+                }
+                sqes = nullptr;
+                sq_ptr = cq_ptr = MAP_FAILED;
+                fd = -1;
+            }
+        };
+#else
+        // 没有 io_uring 头文件的系统：只能用线程池
+        struct Ring
+        {
+            bool setup(unsigned) { return false; }
+            bool submit_writev(int, const iovec *, unsigned, off_t, uint64_t) { return false; }
+            void submit_nop(uint64_t) {}
+            bool wait(uint64_t &, int &) { return false; }
+            void teardown() {}
+        };
+#endif
+
+        bool submit(const std::vector<iovec> &iov, std::shared_ptr<void> holder)
+        {
+            if (error != 0)
+            {
+                return false;
+            }
+            // 单次向量写最多 IOV_MAX 段，超出时拆成几次写入，偏移顺延
+            for (size_t begin = 0; begin < iov.size(); begin += IOV_MAX)
+            {
+                size_t end = std::min(iov.size(), begin + IOV_MAX);
+                std::unique_lock<std::mutex> lock(mutex);
+                slot_free.wait(lock, [this]()
+                               { return !free_slots.empty(); });
+                size_t slot = free_slots.back();
+                free_slots.pop_back();
+                Request &request = requests[slot];
+                request.iov.assign(iov.begin() + begin, iov.begin() + end);
+                request.bytes = 0;
+                for (const auto &v : request.iov)
+                {
+                    request.bytes += v.iov_len;
+                }
+                request.offset = static_cast<off_t>(next_offset);
+                request.holder = holder;
+                next_offset += request.bytes;
+                bytes_submitted += request.bytes;
+
+                if (backend == SinkBackend::IO_URING)
+                {
+                    if (!ring.submit_writev(fd, request.iov.data(), static_cast<unsigned>(request.iov.size()), request.offset, slot))
+                    {
+                        // 提交失败时在当前线程同步写完
+                        lock.unlock();
+                        complete(slot, write_all(request));
+                    }
+                }
+                else
+                {
+                    pending.push_back(slot);
+                    work_ready.notify_one();
+                }
+            }
+            return error == 0;
+        }
+
+        // 同步写完一个请求（处理部分写入），返回 0 或 errno
+        int write_all(Request &request, size_t done = 0)
+        {
+            std::vector<iovec> iov = request.iov;
+            size_t index = 0;
+            while (done > 0 && index < iov.size())
+            {
+                size_t skip = std::min(done, iov[index].iov_len);
+                iov[index].iov_base = static_cast<uint8_t *>(iov[index].iov_base) + skip;
+                iov[index].iov_len -= skip;
+                done -= skip;
+                index += iov[index].iov_len == 0 ? 1 : 0;
+            }
+            off_t offset = request.offset + static_cast<off_t>(request.bytes);
+            for (const auto &v : iov)
+            {
+                offset -= static_cast<off_t>(v.iov_len);
+            }
+            while (index < iov.size())
+            {
+                ssize_t n = seekable ? pwritev(fd, iov.data() + index, static_cast<int>(iov.size() - index), offset)
+                                     : writev(fd, iov.data() + index, static_cast<int>(iov.size() - index));
+                if (n < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    return errno;
+                }
+                offset += n;
+                size_t left = static_cast<size_t>(n);
+                while (left > 0 && index < iov.size())
+                {
+                    size_t skip = std::min(left, iov[index].iov_len);
+                    iov[index].iov_base = static_cast<uint8_t *>(iov[index].iov_base) + skip;
+                    iov[index].iov_len -= skip;
+                    left -= skip;
+                    index += iov[index].iov_len == 0 ? 1 : 0;
+                }
+            }
+            return 0;
+        }
+
+        // 一个请求结束：记录结果，释放对内存的引用（池化缓冲区由此回到池中），归还槽位
+        void complete(size_t slot, int err)
+        {
+            Request &request = requests[slot];
+            if (err == 0)
+            {
+                bytes_written += request.bytes;
+            }
+            else
+            {
+                int expected = 0;
+                error.compare_exchange_strong(expected, err);
+            }
+            request.holder.reset();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                free_slots.push_back(slot);
+            }
+            slot_free.notify_all();
+        }
+
+        // io_uring 回收线程
+        void reap()
+        {
+            for (;;)
+            {
+                uint64_t user_data = 0;
+                int result = 0;
+                if (!ring.wait(user_data, result))
+                {
+                    return;
+                }
+                if (user_data == STOP)
+                {
+                    return;
+                }
+                size_t slot = static_cast<size_t>(user_data);
+                Request &request = requests[slot];
+                int err = 0;
+                if (result < 0)
+                {
+                    err = -result;
+                }
+                else if (static_cast<size_t>(result) < request.bytes)
+                {
+                    // 部分写入：剩下的同步写完
+                    err = write_all(request, static_cast<size_t>(result));
+                }
+                complete(slot, err);
+            }
+        }
+
+        // 线程池工作线程
+        void work()
+        {
+            for (;;)
+            {
+                size_t slot;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    work_ready.wait(lock, [this]()
+                                    { return stopping || !pending.empty(); });
+                    if (pending.empty())
+                    {
+                        return;
+                    }
+                    slot = pending.front();
+                    pending.pop_front();
+                }
+                complete(slot, write_all(requests[slot]));
+            }
+        }
+
+        void close_fd()
+        {
+            if (fd >= 0 && owns_fd)
+            {
+                close(fd);
+            }
+            fd = -1;
+        }
+
+        FrameSinkOptions options;
+        SinkBackend backend = SinkBackend::THREADS;
+        int fd = -1;
+        bool owns_fd = true;
+        bool seekable = false;
+        Ring ring;
+
+        std::mutex mutex;
+        std::condition_variable slot_free;  // 有槽位归还
+        std::condition_variable work_ready; // 线程池有新请求或要退出
+        std::vector<Request> requests;
+        std::vector<size_t> free_slots;
+        std::deque<size_t> pending; // 线程池待写的槽位
+        bool stopping = false;
+        size_t next_offset = 0;
+        std::vector<std::thread> workers;
+
+        std::atomic<int> error{0};
+        std::atomic<size_t> bytes_submitted{0};
+        std::atomic<size_t> bytes_written{0};
+    };
+}
@@ -0,0 +1,798 @@
+#pragma once
+#include <CL/cl.h>
+#include <vector>
+#include <map>
+#include <string>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+
+#include "Image.h"
+#include "Compose.h"
+#include "Resize.h"
+#include "ProgramCache.h"
+#include "WorkSizeTuner.h"
+
+// 内核数据流图：节点是现有内核（YUV2RGB_NVx、resizeLN、resize_nvx、compose_nv21_plane、remap_nv21 …），
+// 边是 Image。
+//
+//   边   add_image()          调用者持有的 Image（零拷贝 cl_mem），运行前后自动同步
+//        add_intermediate()   只在图内部使用的中间结果，设备端分配
+//   节点 add_node() 或 yuv2rgb_nvx() / resize_linear() / resize_nv21() / compose() / remap()
+//
+// 节点按加入顺序就是一个拓扑序。run() 把全部节点提交到一条乱序队列，节点之间只有读写同一块内存时才有事件依赖
+// （写后读、读后写、写后写；按平面区分，同一图像的 Y、UV 平面互不依赖）。
+//
+// 中间结果按活跃区间 [第一次写, 最后一次读] 复用同一块设备内存（arena 的子缓冲区）：
+// 区间不相交的两条边可以占用重叠的地址，后者的每个访问节点都等待前者的全部访问节点。
+// 按大小从大到小首次适配放置，arena 的大小由最宽的一刀（同时活跃的中间结果之和）决定，而不是全部中间结果之和。
+// 所有平面起始偏移按 CL_DEVICE_MEM_BASE_ADDR_ALIGN 对齐，以便为单个平面创建子缓冲区。
+
+namespace bos::mm
+{
+    class KernelGraph
+    {
+    public:
+        // 节点参数
+        struct Arg
+        {
+            enum class Kind
+            {
+                VALUE,  // 标量，按字节保存
+                BUFFER, // 图外的 cl_mem（例如系数表），图持有一份引用
+                IMAGE,  // 边的整帧 cl_mem
+                PLANE   // 边的单个平面的 cl_mem
+            };
+
+            Kind kind = Kind::VALUE;
+            size_t edge = 0;
+            int plane = -1;     // 访问的平面，-1 表示整帧；IMAGE 也可以只声明访问某个平面（平面偏移作为参数另给）
+            bool write = false; // 节点是否写这条边
+            std::vector<unsigned char> value;
+            cl_mem buffer = nullptr;
+
+            template <typename T>
+            static Arg scalar(const T &v)
+            {
+                Arg arg;
+                arg.value.resize(sizeof(T));
+                std::memcpy(arg.value.data(), &v, sizeof(T));
+                return arg;
+            }
+
+            static Arg mem(cl_mem buffer)
+            {
+                Arg arg;
+                arg.kind = Kind::BUFFER;
+                arg.buffer = buffer;
+                return arg;
+            }
+
+            static Arg read(size_t edge, int plane = -1)
+            {
+                return bind(Kind::IMAGE, edge, plane, false);
+            }
+
+            static Arg write_to(size_t edge, int plane = -1)
+            {
+                return bind(Kind::IMAGE, edge, plane, true);
+            }
+
+            static Arg read_plane(size_t edge, int plane)
+            {
+                return bind(Kind::PLANE, edge, plane, false);
+            }
+
+            static Arg write_plane(size_t edge, int plane)
+            {
+                return bind(Kind::PLANE, edge, plane, true);
+            }
+
+        private:
+            static Arg bind(Kind kind, size_t edge, int plane, bool write)
+            {
+                Arg arg;
+                arg.kind = kind;
+                arg.edge = edge;
+                arg.plane = plane;
+                arg.write = write;
+                return arg;
+            }
+        };
+
+        KernelGraph(cl_context context, cl_device_id device) : context(context), device(device), tables(context)
+        {
+            cl_int err = CL_SUCCESS;
+            cl_queue_properties properties[] = {CL_QUEUE_PROPERTIES, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, 0};
+            queue = clCreateCommandQueueWithProperties(context, device, properties, &err);
+            if (err != CL_SUCCESS)
+            {
+                // 不支持乱序执行的设备退回顺序队列，依赖关系照样成立
+                queue = clCreateCommandQueueWithProperties(context, device, nullptr, &err);
+            }
+            if (err != CL_SUCCESS)
+            {
+                throw std::runtime_error("Failed to create graph queue: " + std::to_string(err));
+            }
+            alignment = plane_alignment(device);
+            clRetainContext(context);
+        }
+
+        // 设备要求的子缓冲区起点对齐（CL_DEVICE_MEM_BASE_ADDR_ALIGN，字节，至少 64）。
+        // 按平面绑定（read_plane / write_plane）的外部图像要用它作为 ImageLayoutOptions::plane_alignment 分配
+        static size_t plane_alignment(cl_device_id device)
+        {
+            cl_uint align_bits = 0;
+            clGetDeviceInfo(device, CL_DEVICE_MEM_BASE_ADDR_ALIGN, sizeof(align_bits), &align_bits, nullptr);
+            return std::max<size_t>(align_bits / 8, 64);
+        }
+
+        KernelGraph(const KernelGraph &) = delete;
+        KernelGraph &operator=(const KernelGraph &) = delete;
+
+        ~KernelGraph()
+        {
+            clFinish(queue);
+            release_arena();
+            for (auto &node : nodes)
+            {
+                clReleaseKernel(node.kernel);
+                for (auto &arg : node.args)
+                {
+                    if (arg.kind == Arg::Kind::BUFFER && arg.buffer)
+                    {
+                        clReleaseMemObject(arg.buffer);
+                    }
+                }
+            }
+            for (auto &entry : programs)
+            {
+                clReleaseProgram(entry.second);
+            }
+            clReleaseCommandQueue(queue);
+            clReleaseContext(context);
+        }
+
+        // 调用者持有的图像；必须比图活得久
+        size_t add_image(Image &image)
+        {
+            Edge edge;
+            edge.image = &image;
+            edge.format = image.get_format();
+            edge.width = image.get_width();
+            edge.height = image.get_height();
+            for (const auto &plane : image.get_planes())
+            {
+                edge.layout.push_back({plane->get_width(), plane->get_height(), plane->get_stride(), plane->get_offset()});
+            }
+            edge.bytes = image.get_size();
+            edges.push_back(edge);
+            return edges.size() - 1;
+        }
+
+        // 图内部的中间结果：紧密排列的行，平面起点按设备基址对齐
+        size_t add_intermediate(Image::Format format, size_t width, size_t height)
+        {
+            Edge edge;
+            edge.format = format;
+            edge.width = width;
+            edge.height = height;
+            ImageLayoutOptions options;
+            options.plane_alignment = alignment;
+            edge.bytes = Image::compute_layout(format, width, height, options, edge.layout);
+            edges.push_back(edge);
+            return edges.size() - 1;
+        }
+
+        // 通用节点：kernel 由图持有一份引用。global 以工作项计，local 为空时交给驱动。
+        // 读一条中间结果之前必须已有节点写过它
+        size_t add_node(const std::string &name, cl_kernel kernel, std::vector<Arg> args, cl_uint dims, const size_t *global,
+                        const size_t *local = nullptr)
+        {
+            if (kernel == nullptr || dims == 0 || dims > 3)
+            {
+                throw std::invalid_argument("Invalid graph node " + name + ".");
+            }
+            if (planned)
+            {
+                throw std::logic_error("Graph nodes cannot be added after the first run.");
+            }
+            Node node;
+            node.name = name;
+            node.kernel = kernel;
+            node.dims = dims;
+            for (cl_uint d = 0; d < dims; ++d)
+            {
+                node.global[d] = global[d];
+                node.geometry.local[d] = local ? local[d] : 0;
+            }
+            for (const auto &arg : args)
+            {
+                if (arg.kind != Arg::Kind::IMAGE && arg.kind != Arg::Kind::PLANE)
+                {
+                    continue;
+                }
+                if (arg.edge >= edges.size() || arg.plane >= static_cast<int>(edges[arg.edge].layout.size()) ||
+                    (arg.kind == Arg::Kind::PLANE && arg.plane < 0))
+                {
+                    throw std::invalid_argument("Graph node " + name + " binds an unknown image or plane.");
+                }
+                const Edge &edge = edges[arg.edge];
+                if (!arg.write && edge.image == nullptr && !edge.written(arg.plane))
+                {
+                    throw std::invalid_argument("Graph node " + name + " reads an intermediate before it is written.");
+                }
+                // 外部图像的平面以子缓冲区绑定，偏移不对齐时 clCreateSubBuffer 要到 run() 才失败
+                if (arg.kind == Arg::Kind::PLANE && edge.image && edge.layout[arg.plane].offset % alignment != 0)
+                {
+                    throw std::invalid_argument("Graph node " + name + " binds plane " + std::to_string(arg.plane) +
+                                                " of an image whose offset is not aligned to " + std::to_string(alignment) +
+                                                " bytes; allocate it with ImageLayoutOptions::plane_alignment = KernelGraph::plane_alignment(device).");
+                }
+            }
+
+            size_t index = nodes.size();
+            for (const auto &arg : args)
+            {
+                if (arg.kind != Arg::Kind::IMAGE && arg.kind != Arg::Kind::PLANE)
+                {
+                    continue;
+                }
+                // 同一块内存上的冒险：写后读、读后写、写后写
+                Edge &edge = edges[arg.edge];
+                for (const auto &access : edge.accesses)
+                {
+                    if (access.node != index && (access.write || arg.write) && (access.plane < 0 || arg.plane < 0 || access.plane == arg.plane))
+                    {
+                        add_dependency(node, access.node);
+                    }
+                }
+                edge.accesses.push_back({index, arg.plane, arg.write});
+                if (edge.first == SIZE_MAX)
+                {
+                    edge.first = index;
+                }
+                edge.last = index;
+            }
+            clRetainKernel(kernel);
+            for (auto &arg : args)
+            {
+                if (arg.kind == Arg::Kind::BUFFER)
+                {
+                    clRetainMemObject(arg.buffer);
+                }
+            }
+            node.args = std::move(args);
+            nodes.push_back(std::move(node));
+            return index;
+        }
+
+        // NV21 / NV12 -> RGB / RGBA（color_yuv.cl 的 YUV2RGB_NVx），宽高相同，UV 平面紧跟在 Y 平面之后
+        size_t yuv2rgb_nvx(size_t src, size_t dst)
+        {
+            const Edge &in = edges.at(src), &out = edges.at(dst);
+            bool nv21 = in.format == Image::Format::NV21;
+            if ((!nv21 && in.format != Image::Format::NV12) || (out.format != Image::Format::RGB && out.format != Image::Format::RGBA) ||
+                in.width != out.width || in.height != out.height || in.layout[1].offset != in.layout[0].stride * in.height)
+            {
+                throw std::invalid_argument("yuv2rgb_nvx needs a contiguous NV21/NV12 source and an RGB/RGBA target of the same size.");
+            }
+            int dcn = out.format == Image::Format::RGBA ? 4 : 3;
+            std::string options = "-D PIX_PER_WI_Y=1 -D SCN=1 -D DCN=" + std::to_string(dcn) + " -D BIDX=2 -D UIDX=" + (nv21 ? "1" : "0") +
+                                  " -D SRC_DEPTH=0";
+            cl_kernel kernel = create_kernel("color_yuv.cl", options, "YUV2RGB_NVx");
+            int rows = (int)in.height, cols = (int)in.width, zero = 0;
+            size_t global[2] = {in.width / 2, in.height / 2};
+            return add_owned_node("YUV2RGB_NVx", kernel,
+                                  {Arg::read(src), Arg::scalar((int)in.layout[0].stride), Arg::scalar(zero),
+                                   Arg::write_to(dst), Arg::scalar((int)out.layout[0].stride), Arg::scalar(zero), Arg::scalar(rows), Arg::scalar(cols)},
+                                  2, global);
+        }
+
+        // RGB / RGBA 双线性缩放（resize.cl 的 resizeLN，INTER_LINEAR_INTEGER），系数表取自图的 ResizeTableCache，同一几何只上传一次
+        size_t resize_linear(size_t src, size_t dst)
+        {
+            const Edge &in = edges.at(src), &out = edges.at(dst);
+            if (in.format != out.format || (in.format != Image::Format::RGB && in.format != Image::Format::RGBA))
+            {
+                throw std::invalid_argument("resize_linear needs RGB or RGBA images of the same format.");
+            }
+            int channels = in.format == Image::Format::RGBA ? 4 : 3;
+            int src_w = (int)in.width, src_h = (int)in.height, dst_w = (int)out.width, dst_h = (int)out.height, zero = 0;
+            std::string options = Resizer::build_options(ResizeKernel::LN_INTEGER, channels, src_w, src_h, dst_w, dst_h);
+            ResizeTables linear = tables.get(src_w, src_h, dst_w, dst_h, ResizeInterpolation::LINEAR);
+            cl_kernel kernel = create_kernel("resize.cl", options, "resizeLN");
+            size_t global[2] = {out.width, out.height};
+            return add_owned_node("resizeLN", kernel,
+                                  {Arg::read(src), Arg::scalar((int)in.layout[0].stride), Arg::scalar(zero), Arg::scalar(src_h), Arg::scalar(src_w),
+                                   Arg::write_to(dst), Arg::scalar((int)out.layout[0].stride), Arg::scalar(zero), Arg::scalar(dst_h), Arg::scalar(dst_w),
+                                   Arg::mem(linear.coeffs)},
+                                  2, global); // 节点持有系数表的一份引用
+        }
+
+        // NV21 / NV12 双线性缩放（resize_nvx.cl），亮度、色度各一个节点，两者互不依赖
+        size_t resize_nv21(size_t src, size_t dst)
+        {
+            const Edge &in = edges.at(src), &out = edges.at(dst);
+            if ((in.format != Image::Format::NV21 && in.format != Image::Format::NV12) || out.format != in.format ||
+                (in.width | in.height | out.width | out.height) & 1)
+            {
+                throw std::invalid_argument("resize_nv21 needs NV21/NV12 images of the same format with even sizes.");
+            }
+            size_t index = 0;
+            for (int p = 0; p < 2; ++p)
+            {
+                const char *name = p == 0 ? "resize_nvx_luma" : "resize_nvx_chroma";
+                cl_kernel kernel = create_kernel("resize_nvx.cl", "", name);
+                int src_w = (int)in.width >> p, src_h = (int)in.height >> p, dst_w = (int)out.width >> p, dst_h = (int)out.height >> p;
+                int scale_x = (src_w << 16) / dst_w, scale_y = (src_h << 16) / dst_h;
+                // 亮度每个工作项 4 个像素（resize_nvx.cl 的 LUMA_VEC），色度每个工作项一对 UV
+                size_t global[2] = {p == 0 ? (size_t)(dst_w + 3) / 4 : (size_t)dst_w, (size_t)dst_h};
+                index = add_owned_node(name, kernel,
+                                       {Arg::read(src, p), Arg::scalar((int)in.layout[p].stride), Arg::scalar((int)in.layout[p].offset),
+                                        Arg::scalar(src_w), Arg::scalar(src_h),
+                                        Arg::write_to(dst, p), Arg::scalar((int)out.layout[p].stride), Arg::scalar((int)out.layout[p].offset),
+                                        Arg::scalar(dst_w), Arg::scalar(dst_h), Arg::scalar(scale_x), Arg::scalar(scale_y)},
+                                       2, global);
+            }
+            return index;
+        }
+
+        // 两张 NV21 横向拼接（compose_nv21_buffer.cl 的 compose_nv21_plane），Y、UV 各一个节点
+        size_t compose(size_t left, size_t right, size_t dst)
+        {
+            const Edge &a = edges.at(left), &b = edges.at(right), &out = edges.at(dst);
+            if (a.height != b.height || out.height != a.height || out.width != a.width + b.width || (a.width & 1) ||
+                a.format != Image::Format::NV21 || b.format != a.format || out.format != a.format)
+            {
+                throw std::invalid_argument("compose needs two NV21 images of the same height and an output as wide as both.");
+            }
+            const size_t vec = 16; // compose_nv21_buffer.cl 默认的 COMPOSE_VEC
+            size_t index = 0;
+            for (int p = 0; p < 2; ++p)
+            {
+                cl_kernel kernel = create_kernel("compose_nv21_buffer.cl", "", "compose_nv21_plane");
+                int rows = (int)out.layout[p].height;
+                size_t global[2] = {(out.width + vec - 1) / vec, (size_t)rows};
+                index = add_owned_node("compose_nv21_plane", kernel,
+                                       {Arg::read_plane(left, p), Arg::scalar((int)a.layout[p].stride), Arg::read_plane(right, p),
+                                        Arg::scalar((int)b.layout[p].stride), Arg::write_plane(dst, p), Arg::scalar((int)out.layout[p].stride),
+                                        Arg::scalar((int)a.width), Arg::scalar((int)b.width), Arg::scalar(rows)},
+                                       2, global);
+            }
+            return index;
+        }
+
+        // NV21 分块重排（rearrange.cl 的 remap_nv21），布局编译进内核
+        size_t remap(size_t src, size_t dst, const RemapLayout &layout)
+        {
+            const Edge &in = edges.at(src), &out = edges.at(dst);
+            if (layout.entries.empty() || in.format != Image::Format::NV21 || out.format != Image::Format::NV21 ||
+                in.width != layout.src_width || in.height != layout.src_height || out.width != layout.dst_width ||
+                out.height != layout.dst_height || in.layout[0].stride != in.layout[1].stride || out.layout[0].stride != out.layout[1].stride)
+            {
+                throw std::invalid_argument("remap needs NV21 images matching the layout.");
+            }
+            const size_t vec = 16;
+            cl_kernel kernel = create_kernel("rearrange.cl", layout.build_options((int)vec), "remap_nv21");
+            size_t max_width = 0, max_height = 0;
+            for (const auto &e : layout.entries)
+            {
+                max_width = std::max(max_width, (size_t)e.width);
+                max_height = std::max(max_height, (size_t)e.height);
+            }
+            size_t global[3] = {(max_width + vec - 1) / vec, max_height * 3 / 2, layout.entries.size()};
+            return add_owned_node("remap_nv21", kernel,
+                                  {Arg::read_plane(src, 0), Arg::read_plane(src, 1), Arg::scalar((int)in.layout[0].stride),
+                                   Arg::write_plane(dst, 0), Arg::write_plane(dst, 1), Arg::scalar((int)out.layout[0].stride)},
+                                  3, global);
+        }
+
+        // 关闭中间结果复用（每条边独占一块内存），用于对照；只能在第一次 run() 之前调用
+        void set_aliasing(bool enable)
+        {
+            aliasing = enable;
+        }
+
+        // 执行整张图并等待完成：输入图像先同步到设备，被写过的图像完成后同步回主机
+        cl_int run()
+        {
+            cl_int err = plan();
+            if (err != CL_SUCCESS)
+            {
+                return err;
+            }
+            for (auto &edge : edges)
+            {
+                if (edge.image && !edge.written_first())
+                {
+                    err = edge.image->sync_to_device(context, queue);
+                    if (err != CL_SUCCESS)
+                    {
+                        return err;
+                    }
+                }
+            }
+
+            std::vector<cl_event> events(nodes.size(), nullptr);
+            for (size_t n = 0; n < nodes.size() && err == CL_SUCCESS; ++n)
+            {
+                Node &node = nodes[n];
+                err = set_args(node);
+                if (err != CL_SUCCESS)
+                {
+                    break;
+                }
+                std::vector<cl_event> wait;
+                for (size_t dep : node.deps)
+                {
+                    wait.push_back(events[dep]);
+                }
+                err = enqueue_geometry(queue, node.kernel, node.dims, node.global, node.geometry, &events[n], (cl_uint)wait.size(),
+                                       wait.empty() ? nullptr : wait.data());
+            }
+            cl_int finish = clFinish(queue);
+            for (cl_event event : events)
+            {
+                if (event)
+                {
+                    clReleaseEvent(event);
+                }
+            }
+            if (err != CL_SUCCESS)
+            {
+                return err;
+            }
+            if (finish != CL_SUCCESS)
+            {
+                return finish;
+            }
+            for (auto &edge : edges)
+            {
+                if (edge.image && edge.written(-1, true))
+                {
+                    err = edge.image->sync_to_host(context, queue);
+                    if (err != CL_SUCCESS)
+                    {
+                        return err;
+                    }
+                }
+            }
+            return CL_SUCCESS;
+        }
+
+        size_t get_node_count() const { return nodes.size(); }
+
+        // 节点 index 等待的节点
+        const std::vector<size_t> &get_dependencies(size_t index) const { return nodes.at(index).deps; }
+
+        const std::string &get_node_name(size_t index) const { return nodes.at(index).name; }
+
+        // 全部中间结果各占一块内存时的总字节数
+        size_t get_intermediate_bytes() const
+        {
+            size_t total = 0;
+            for (const auto &edge : edges)
+            {
+                total += edge.image ? 0 : edge.bytes;
+            }
+            return total;
+        }
+
+        // 最宽的一刀：任一节点执行时同时活跃的中间结果字节数的最大值，arena 大小的下界
+        size_t get_peak_live_bytes() const
+        {
+            size_t peak = 0;
+            for (size_t n = 0; n < nodes.size(); ++n)
+            {
+                size_t live = 0;
+                for (const auto &edge : edges)
+                {
+                    live += !edge.image && edge.first <= n && n <= edge.last ? edge.bytes : 0;
+                }
+                peak = std::max(peak, live);
+            }
+            return peak;
+        }
+
+        // 实际分配的设备内存（第一次 run() 之后有效）
+        size_t get_arena_bytes() const { return arena_bytes; }
+
+    private:
+        struct Access
+        {
+            size_t node;
+            int plane;
+            bool write;
+        };
+
+        struct Edge
+        {
+            Image *image = nullptr; // 为空时是中间结果
+            Image::Format format = Image::Format::NV21;
+            size_t width = 0, height = 0;
+            std::vector<Image::PlaneLayout> layout;
+            size_t bytes = 0;
+            std::vector<Access> accesses;
+            size_t first = SIZE_MAX, last = 0; // 活跃区间（节点序号）
+            size_t offset = 0;                 // 在 arena 中的偏移
+            cl_mem mem = nullptr;              // 中间结果的整帧子缓冲区
+            std::vector<cl_mem> planes;        // 中间结果的平面子缓冲区，用到时创建
+
+            // plane 已被写过（-1 表示任一平面）；whole 为真时只看是否有写访问
+            bool written(int plane, bool whole = false) const
+            {
+                for (const auto &access : accesses)
+                {
+                    if (access.write && (whole || access.plane < 0 || plane < 0 || access.plane == plane))
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            // 第一次访问就是写：内容完全由图产生，运行前不需要上传
+            bool written_first() const
+            {
+                return !accesses.empty() && accesses.front().write && accesses.front().plane < 0;
+            }
+        };
+
+        struct Node
+        {
+            std::string name;
+            cl_kernel kernel = nullptr;
+            std::vector<Arg> args;
+            cl_uint dims = 0;
+            size_t global[3] = {1, 1, 1};
+            WorkGeometry geometry;
+            std::vector<size_t> deps;
+        };
+
+        static void add_dependency(Node &node, size_t dep)
+        {
+            if (std::find(node.deps.begin(), node.deps.end(), dep) == node.deps.end())
+            {
+                node.deps.push_back(dep);
+            }
+        }
+
+        // 内置节点的 kernel 是新建的，add_node 再持有一份后释放创建时的引用
+        size_t add_owned_node(const std::string &name, cl_kernel kernel, std::vector<Arg> args, cl_uint dims, const size_t *global)
+        {
+            try
+            {
+                size_t index = add_node(name, kernel, std::move(args), dims, global);
+                clReleaseKernel(kernel);
+                return index;
+            }
+            catch (...)
+            {
+                clReleaseKernel(kernel);
+                throw;
+            }
+        }
+
+        cl_kernel create_kernel(const std::string &file, const std::string &options, const char *name)
+        {
+            std::string key = file + "\n" + options;
+            cl_int err = CL_SUCCESS;
+            auto it = programs.find(key);
+            if (it == programs.end())
+            {
+                cl_program program = program_cache_build(context, device, file.c_str(), options.empty() ? nullptr : options.c_str(), nullptr, &err);
+                if (err != CL_SUCCESS)
+                {
+                    throw std::runtime_error("Failed to build " + file + ": " + std::to_string(err));
+                }
+                it = programs.emplace(key, program).first;
+            }
+            cl_kernel kernel = clCreateKernel(it->second, name, &err);
+            if (err != CL_SUCCESS)
+            {
+                throw std::runtime_error(std::string("Failed to create kernel ") + name + ": " + std::to_string(err));
+            }
+            return kernel;
+        }
+
+        // 放置中间结果、补上复用带来的依赖并创建 arena；只在第一次 run() 时执行
+        cl_int plan()
+        {
+            if (planned)
+            {
+                return CL_SUCCESS;
+            }
+            std::vector<size_t> order;
+            for (size_t e = 0; e < edges.size(); ++e)
+            {
+                if (!edges[e].image && !edges[e].accesses.empty())
+                {
+                    order.push_back(e);
+                }
+            }
+            std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                             { return edges[a].bytes > edges[b].bytes; });
+
+            // 首次适配：与已放置且活跃区间相交的边按偏移排序，找第一个放得下的空隙
+            std::vector<size_t> placed;
+            arena_bytes = 0;
+            for (size_t e : order)
+            {
+                Edge &edge = edges[e];
+                std::vector<size_t> conflicts;
+                for (size_t other : placed)
+                {
+                    if (!aliasing || (edges[other].first <= edge.last && edge.first <= edges[other].last))
+                    {
+                        conflicts.push_back(other);
+                    }
+                }
+                std::sort(conflicts.begin(), conflicts.end(), [&](size_t a, size_t b)
+                          { return edges[a].offset < edges[b].offset; });
+                size_t offset = 0;
+                for (size_t other : conflicts)
+                {
+                    if (edges[other].offset >= offset + edge.bytes)
+                    {
+                        break;
+                    }
+                    offset = std::max(offset, align(edges[other].offset + edges[other].bytes));
+                }
+                edge.offset = offset;
+                arena_bytes = std::max(arena_bytes, offset + edge.bytes);
+                placed.push_back(e);
+            }
+
+            // 地址重叠、区间先后相接的两条边：后者的每个访问节点都等待前者的全部访问。
+            // 只挂在后者的第一个节点上不够：按平面拆开的写节点（例如 resize_nv21 的色度节点）互不依赖，
+            // 后写的平面可能覆盖前者仍在被读的字节
+            for (size_t a : placed)
+            {
+                for (size_t b : placed)
+                {
+                    const Edge &early = edges[a], &late = edges[b];
+                    if (early.last < late.first && early.offset < late.offset + late.bytes && late.offset < early.offset + early.bytes)
+                    {
+                        for (const auto &later : late.accesses)
+                        {
+                            for (const auto &access : early.accesses)
+                            {
+                                add_dependency(nodes[later.node], access.node);
+                            }
+                        }
+                    }
+                }
+            }
+
+            if (arena_bytes > 0)
+            {
+                cl_int err = CL_SUCCESS;
+                arena = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, arena_bytes, nullptr, &err);
+                if (err != CL_SUCCESS)
+                {
+                    arena = nullptr;
+                    return err;
+                }
+                for (size_t e : placed)
+                {
+                    edges[e].mem = sub_buffer(edges[e].offset, edges[e].bytes, err);
+                    if (err != CL_SUCCESS)
+                    {
+                        release_arena();
+                        return err;
+                    }
+                }
+            }
+            planned = true;
+            return CL_SUCCESS;
+        }
+
+        size_t align(size_t value) const
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        cl_mem sub_buffer(size_t offset, size_t size, cl_int &err)
+        {
+            cl_buffer_region region = {offset, size};
+            cl_mem mem = clCreateSubBuffer(arena, CL_MEM_READ_WRITE, CL_BUFFER_CREATE_TYPE_REGION, &region, &err);
+            return err == CL_SUCCESS ? mem : nullptr;
+        }
+
+        // 边在参数中的 cl_mem；外部图像用它自己缓存的 cl_mem
+        cl_mem binding(const Arg &arg, cl_int &err)
+        {
+            Edge &edge = edges[arg.edge];
+            err = CL_SUCCESS;
+            if (edge.image)
+            {
+                cl_mem mem = arg.kind == Arg::Kind::IMAGE ? edge.image->get_cl_mem(context) : edge.image->get_planes()[arg.plane]->to_cl_mem(context, queue);
+                err = mem ? CL_SUCCESS : CL_INVALID_MEM_OBJECT;
+                return mem;
+            }
+            if (arg.kind == Arg::Kind::IMAGE)
+            {
+                return edge.mem;
+            }
+            edge.planes.resize(edge.layout.size(), nullptr);
+            cl_mem &plane = edge.planes[arg.plane];
+            if (plane == nullptr)
+            {
+                const auto &layout = edge.layout[arg.plane];
+                plane = sub_buffer(edge.offset + layout.offset, layout.stride * layout.height, err);
+            }
+            return plane;
+        }
+
+        cl_int set_args(Node &node)
+        {
+            for (cl_uint i = 0; i < node.args.size(); ++i)
+            {
+                const Arg &arg = node.args[i];
+                cl_int err = CL_SUCCESS;
+                if (arg.kind == Arg::Kind::VALUE)
+                {
+                    err = clSetKernelArg(node.kernel, i, arg.value.size(), arg.value.data());
+                }
+                else if (arg.kind == Arg::Kind::BUFFER)
+                {
+                    err = clSetKernelArg(node.kernel, i, sizeof(cl_mem), &arg.buffer);
+                }
+                else
+                {
+                    cl_mem mem = binding(arg, err);
+                    if (err == CL_SUCCESS)
+                    {
+                        err = clSetKernelArg(node.kernel, i, sizeof(cl_mem), &mem);
+                    }
+                }
+                if (err != CL_SUCCESS)
+                {
+                    return err;
+                }
+            }
+            return CL_SUCCESS;
+        }
+
+        // 子缓冲区先于 arena 释放
+        void release_arena()
+        {
+            for (auto &edge : edges)
+            {
+                for (cl_mem plane : edge.planes)
+                {
+                    if (plane)
+                    {
+                        clReleaseMemObject(plane);
+                    }
+                }
+                edge.planes.clear();
+                if (edge.mem)
+                {
+                    clReleaseMemObject(edge.mem);
+                    edge.mem = nullptr;
+                }
+            }
+            if (arena)
+            {
+                clReleaseMemObject(arena);
+                arena = nullptr;
+            }
+        }
+
+        cl_context context;
+        cl_device_id device;
+        ResizeTableCache tables; // resize_linear 的系数表
+        cl_command_queue queue = nullptr;
+        size_t alignment = 64; // 平面与 arena 中各边起点的对齐（字节）
+        bool aliasing = true;
+        bool planned = false;
+        std::vector<Edge> edges;
+        std::vector<Node> nodes;
+        std::map<std::string, cl_program> programs; // 文件 + 编译选项 -> program
+        cl_mem arena = nullptr;
+        size_t arena_bytes = 0;
+    };
+}
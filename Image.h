@@ -4,12 +4,25 @@
 #include <vector>
 #include <iostream>
 #include <unordered_map>
+#include <stdexcept>
 
 #include "BufferPool.h"
 #include "Plane.h"
 
 namespace bos::mm
 {
+    // 图像的内存布局参数
+    struct ImageLayoutOptions
+    {
+        size_t stride = 0;          // 首平面每行字节数（原样使用）；0 表示按宽度计算后对齐到 row_alignment
+        size_t row_alignment = 1;   // 行对齐（字节），例如 64/128 便于向量加载和 DMA
+        size_t plane_alignment = 1; // 平面起始偏移的对齐（字节），1 表示紧密排列；要为单个平面建子缓冲区时取设备的基址对齐
+    };
+
+    // 图像：所有平面放在同一个连续 Buffer 里，按偏移切分。
+    // 默认紧密排列（与 .nv21/.yuv 文件布局一致），整帧读文件、上传、下载、写文件都是一次连续传输；
+    // 每个平面的 cl_mem 是整帧 cl_mem 上的 clCreateSubBuffer 视图。
+    // 行距（stride）可配置：按 row_alignment 对齐，或直接给出相机驱动等外部来源的实际行距，避免重新打包
     class Image
     {
     public:
@@ -24,83 +37,206 @@ namespace bos::mm
             // 更多格式
         };
 
-        // 从 BufferPool 获取缓冲区自动构造
-        Image(Format format, size_t width, size_t height, BufferPool &buffer_pool)
-            : format(format), width(width), height(height), buffer_pool(buffer_pool)
+        using LayoutOptions = ImageLayoutOptions;
+
+        // 单个平面的布局
+        struct PlaneLayout
+        {
+            size_t width, height, stride, offset;
+        };
+
+        // 从 BufferPool 获取缓冲区自动构造。
+        // 子缓冲区要求平面偏移是 CL_DEVICE_MEM_BASE_ADDR_ALIGN 的整数倍，尺寸不满足时用 plane_alignment 补齐
+        Image(Format format, size_t width, size_t height, BufferPool &buffer_pool, const LayoutOptions &options = LayoutOptions())
+            : format(format), width(width), height(height), buffer_pool(&buffer_pool)
         {
-            create_planes_from_pool();
+            create_planes_from_pool(options);
         }
 
-        // 从外部 Buffer 创建
-        Image(Format format, size_t width, size_t height, std::vector<std::shared_ptr<Buffer>> external_buffers)
-            : format(format), width(width), height(height), external_buffers(std::move(external_buffers))
+        // 从外部 Buffer 创建：一个 Buffer 时所有平面按布局排列在其中，否则每个平面一个 Buffer
+        Image(Format format, size_t width, size_t height, std::vector<std::shared_ptr<Buffer>> external_buffers,
+              const LayoutOptions &options = LayoutOptions())
+            : format(format), width(width), height(height), buffer_pool(nullptr), external_buffers(std::move(external_buffers))
         {
-            create_planes_from_external_buffers();
+            create_planes_from_external_buffers(options);
         }
 
-        // 创建多个 Plane，自动从 BufferPool 获取
-        void create_planes_from_pool()
+        // 计算各平面的布局，返回整帧需要的字节数
+        static size_t compute_layout(Format format, size_t width, size_t height, const LayoutOptions &options,
+                                     std::vector<PlaneLayout> &layout)
         {
-            // 根据格式生成相应的 Plane
-            if (format == Format::RGB || format == Format::RGBA)
+            size_t row_alignment = std::max<size_t>(options.row_alignment, 1);
+            auto pitch = [&](size_t row_bytes, size_t divisor)
             {
-                // 使用 BufferPool 获取 Buffer 创建 Plane
-                auto buffer = buffer_pool.get_buffer(Buffer::Type::NORMAL, width * height * 3);
-                planes.push_back(std::make_shared<Plane>(width, height, width * 3, buffer));
+                // 显式行距原样使用（色度平面按首平面行距同比缩小），否则把行字节数对齐到 row_alignment
+                if (options.stride == 0)
+                {
+                    return (row_bytes + row_alignment - 1) / row_alignment * row_alignment;
+                }
+                if (options.stride / divisor < row_bytes)
+                {
+                    throw std::invalid_argument("Image stride is smaller than the row size.");
+                }
+                return options.stride / divisor;
+            };
+
+            layout.clear();
+            if (format == Format::RGB)
+            {
+                layout.push_back({width, height, pitch(width * 3, 1), 0});
+            }
+            else if (format == Format::RGBA)
+            {
+                layout.push_back({width, height, pitch(width * 4, 1), 0});
             }
             else if (format == Format::NV21 || format == Format::NV12)
             {
-                // 获取两个缓冲区，Y 和 UV 分别创建 Plane
-                auto buffer_y = buffer_pool.get_buffer(Buffer::Type::NORMAL, width * height);
-                planes.push_back(std::make_shared<Plane>(width, height, width, buffer_y));
-                auto buffer_uv = buffer_pool.get_buffer(Buffer::Type::NORMAL, width * height / 2);
-                planes.push_back(std::make_shared<Plane>(width / 2, height / 2, width / 2, buffer_uv));
+                // Y 平面 + 交错的 VU/UV 平面（每行 width 字节，共 height / 2 行），两个平面行距相同
+                size_t stride = pitch(width, 1);
+                layout.push_back({width, height, stride, 0});
+                layout.push_back({width / 2, height / 2, stride, 0});
+            }
+            else if (format == Format::YUV420)
+            {
+                layout.push_back({width, height, pitch(width, 1), 0});
+                layout.push_back({width / 2, height / 2, pitch(width / 2, 2), 0});
+                layout.push_back({width / 2, height / 2, pitch(width / 2, 2), 0});
+            }
+            else if (format == Format::YUV422)
+            {
+                layout.push_back({width, height, pitch(width, 1), 0});
+                layout.push_back({width / 2, height, pitch(width / 2, 2), 0});
+                layout.push_back({width / 2, height, pitch(width / 2, 2), 0});
+            }
+
+            size_t alignment = std::max<size_t>(options.plane_alignment, 1);
+            size_t offset = 0;
+            for (auto &plane : layout)
+            {
+                offset = (offset + alignment - 1) / alignment * alignment;
+                plane.offset = offset;
+                offset += plane.stride * plane.height;
+            }
+            return offset;
+        }
+
+        // 获取所有 Plane 的引用
+        const std::vector<std::shared_ptr<Plane>> &get_planes() const
+        {
+            return planes;
+        }
+
+        Format get_format() const { return format; }
+        size_t get_width() const { return width; }
+        size_t get_height() const { return height; }
+
+        // 整帧的字节数（所有平面及其间的对齐补齐）
+        size_t get_size() const { return size; }
+
+        // 整帧的连续内存；由多个外部 Buffer 构造时为 nullptr
+        uint8_t *get_data() { return buffer ? buffer->get_data() : nullptr; }
+
+        // 整帧所在的 Buffer；由多个外部 Buffer 构造时为空
+        const std::shared_ptr<Buffer> &get_buffer() const { return buffer; }
+
+        // 整帧的 cl_mem（各平面子缓冲区的父缓冲区），归 Buffer 所有，不要释放
+        cl_mem get_cl_mem(cl_context context, bool is_dma = false)
+        {
+            if (!buffer)
+            {
+                std::cerr << "Image planes are not contiguous." << std::endl;
+                return nullptr;
             }
-            else if (format == Format::YUV420 || format == Format::YUV422)
-            {
-                // 获取三个缓冲区，Y、U、V 分别创建 Plane
-                auto buffer_y = buffer_pool.get_buffer(Buffer::Type::NORMAL, width * height);
-                planes.push_back(std::make_shared<Plane>(width, height, width, buffer_y));
-                auto buffer_u = buffer_pool.get_buffer(Buffer::Type::NORMAL, width * height / 4);
-                planes.push_back(std::make_shared<Plane>(width / 2, height / 2, width / 2, buffer_u));
-                auto buffer_v = buffer_pool.get_buffer(Buffer::Type::NORMAL, width * height / 4);
-                planes.push_back(std::make_shared<Plane>(width / 2, height / 2, width / 2, buffer_v));
+            return buffer->get_cl_mem(context, is_dma);
+        }
+
+        // 主机写完整帧后同步到设备（USE_HOST_PTR 下只有 map/unmap 才保证可见），一次整帧传输。
+        // 必须用 INVALIDATE_REGION：普通 CL_MAP_WRITE 会先把设备上的旧内容拷回宿主指针，覆盖主机刚写的帧
+        cl_int sync_to_device(cl_context context, cl_command_queue queue)
+        {
+            return map_unmap(context, queue, CL_MAP_WRITE_INVALIDATE_REGION);
+        }
+
+        // 设备写完整帧后同步回主机，一次整帧传输
+        cl_int sync_to_host(cl_context context, cl_command_queue queue)
+        {
+            return map_unmap(context, queue, CL_MAP_READ);
+        }
+
+    private:
+        // 创建多个 Plane，整帧一次从 BufferPool 获取
+        void create_planes_from_pool(const LayoutOptions &options)
+        {
+            std::vector<PlaneLayout> layout;
+            size = compute_layout(format, width, height, options, layout);
+            if (size == 0)
+            {
+                throw std::invalid_argument("Unsupported image format or empty image.");
+            }
+            buffer = buffer_pool->get_buffer(Buffer::Type::NORMAL, size);
+            for (const auto &plane : layout)
+            {
+                planes.push_back(std::make_shared<Plane>(plane.width, plane.height, plane.stride, buffer, plane.offset));
             }
         }
 
         // 从外部 Buffer 创建多个 Plane
-        void create_planes_from_external_buffers()
+        void create_planes_from_external_buffers(const LayoutOptions &options)
         {
-            // 根据格式生成相应的 Plane
-            if (format == Format::RGB || format == Format::RGBA)
+            std::vector<PlaneLayout> layout;
+            size = compute_layout(format, width, height, options, layout);
+            if (external_buffers.size() == 1)
             {
-                // 每个 Plane 使用外部的 Buffer
-                planes.push_back(std::make_shared<Plane>(width, height, width * 3, external_buffers[0]));
+                // 单个 Buffer：所有平面按布局切分
+                buffer = external_buffers[0];
+                if (buffer == nullptr || buffer->get_size() < size)
+                {
+                    throw std::invalid_argument("External buffer is too small for the image.");
+                }
+                for (const auto &plane : layout)
+                {
+                    planes.push_back(std::make_shared<Plane>(plane.width, plane.height, plane.stride, buffer, plane.offset));
+                }
+                return;
             }
-            else if (format == Format::NV21 || format == Format::NV12)
+
+            // 每个平面一个 Buffer
+            if (external_buffers.size() != layout.size())
             {
-                // 使用外部提供的缓冲区创建 Plane
-                planes.push_back(std::make_shared<Plane>(width, height, width, external_buffers[0]));
-                planes.push_back(std::make_shared<Plane>(width / 2, height / 2, width / 2, external_buffers[1]));
+                throw std::invalid_argument("External buffer count does not match the image format.");
             }
-            else if (format == Format::YUV420 || format == Format::YUV422)
+            for (size_t i = 0; i < layout.size(); ++i)
             {
-                planes.push_back(std::make_shared<Plane>(width, height, width, *external_buffers[0]));
-                planes.push_back(std::make_shared<Plane>(width / 2, height / 2, width / 2, external_buffers[1]));
-                planes.push_back(std::make_shared<Plane>(width / 2, height / 2, width / 2, external_buffers[2]));
+                planes.push_back(std::make_shared<Plane>(layout[i].width, layout[i].height, layout[i].stride, external_buffers[i]));
             }
         }
 
-        // 获取所有 Plane 的引用
-        const std::vector<std::shared_ptr<Plane>> &get_planes() const
+        cl_int map_unmap(cl_context context, cl_command_queue queue, cl_map_flags flags)
         {
-            return planes;
+            cl_mem mem = get_cl_mem(context);
+            if (mem == nullptr)
+            {
+                return CL_INVALID_MEM_OBJECT;
+            }
+            cl_int err = CL_SUCCESS;
+            void *mapped = clEnqueueMapBuffer(queue, mem, CL_TRUE, flags, 0, size, 0, nullptr, nullptr, &err);
+            if (err != CL_SUCCESS)
+            {
+                return err;
+            }
+            err = clEnqueueUnmapMemObject(queue, mem, mapped, 0, nullptr, nullptr);
+            if (err != CL_SUCCESS)
+            {
+                return err;
+            }
+            return clFinish(queue);
         }
 
-    private:
         Format format;
         size_t width, height;
-        BufferPool &buffer_pool;                               // 引用 BufferPool 用于从中获取缓冲区
+        size_t size = 0;                                       // 整帧字节数
+        BufferPool *buffer_pool;                               // 从中获取缓冲区的 BufferPool（外部 Buffer 构造时为空）
+        std::shared_ptr<Buffer> buffer;                        // 所有平面共享的连续缓冲区
         std::vector<std::shared_ptr<Buffer>> external_buffers; // 外部传入的缓冲区
         std::vector<std::shared_ptr<Plane>> planes;            // 存储多个 Plane
     };
@@ -14,8 +14,9 @@ namespace bos::mm
     class Plane
     {
     public:
-        Plane(size_t width, size_t height, size_t stride, std::shared_ptr<Buffer> buffer)
-            : mBuffer(std::move(buffer)), mWidth(width), mHeight(height), mStride(stride) {}
+        // offset 是平面在 buffer 中的起始字节，多个平面可以共享同一个连续 Buffer
+        Plane(size_t width, size_t height, size_t stride, std::shared_ptr<Buffer> buffer, size_t offset = 0)
+            : mBuffer(std::move(buffer)), mWidth(width), mHeight(height), mStride(stride), mOffset(offset) {}
 
         // 获取图像平面的宽度
         size_t get_width() const { return mWidth; }
@@ -26,35 +27,39 @@ namespace bos::mm
         // 获取图像平面的步幅（stride）
         size_t get_stride() const { return mStride; }
 
+        // 平面在 Buffer 中的起始偏移（字节）
+        size_t get_offset() const { return mOffset; }
+
+        // 平面占用的字节数
+        size_t get_size() const { return mStride * mHeight; }
+
         // 获取数据指针
-        uint8_t *get_data() { return mBuffer->get_data(); }
+        uint8_t *get_data() { return mBuffer->get_data() + mOffset; }
+
+        // 获取底层 Buffer
+        const std::shared_ptr<Buffer> &get_buffer() const { return mBuffer; }
 
-        // 转换为 OpenCL 缓冲区
+        // 转换为 OpenCL 缓冲区。cl_mem 缓存在 Buffer 上（每个 context 一个），
+        // 同一个池化 Buffer 反复使用时不会再调用 clCreateBuffer；返回值归 Buffer 所有，不要释放。
+        // 平面只占 Buffer 的一部分时返回整块 Buffer 上的子缓冲区
         cl_mem to_cl_mem(cl_context context, cl_command_queue queue, bool is_dma = false)
         {
-            if (is_dma && mBuffer->get_type() == Buffer::Type::DMABUF)
+            (void)queue;
+            if (mBuffer == nullptr || mBuffer->get_data() == nullptr)
             {
-                // 使用 DMA FD 创建 cl_mem
-                int fd = mBuffer->get_dma_fd();
-                cl_mem_flags flags = CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR;
-                return clCreateBufferFromFd(context, fd, flags, get_stride() * get_height(), nullptr);
+                std::cerr << "Failed to get plane data." << std::endl;
+                return nullptr;
             }
-            else
+            if (mOffset == 0 && get_size() >= mBuffer->get_size())
             {
-                // 使用普通内存创建 cl_mem
-                uint8_t *ptr = get_data();
-                if (ptr == nullptr)
-                {
-                    std::cerr << "Failed to get plane data." << std::endl;
-                    return nullptr;
-                }
-                cl_mem_flags flags = CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR;
-                return clCreateBuffer(context, flags, get_stride() * get_height(), ptr, nullptr);
+                return mBuffer->get_cl_mem(context, is_dma);
             }
+            return mBuffer->get_sub_cl_mem(context, mOffset, get_size(), is_dma);
         }
 
     private:
         std::shared_ptr<Buffer> mBuffer; // 使用智能指针来避免数据拷贝
         size_t mWidth, mHeight, mStride; // 图像平面特定的属性
+        size_t mOffset;                  // 在 Buffer 中的起始偏移
     };
 }
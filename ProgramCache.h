@@ -0,0 +1,394 @@
+#pragma once
+
+// OpenCL 程序二进制磁盘缓存（C/C++ 通用）
+//
+// 缓存键 = 内核源码 + 编译选项 + 平台/设备/驱动版本 的 FNV-1a 64 位哈希，
+// 命中时用 clCreateProgramWithBinary 加载 CL_PROGRAM_BINARIES，跳过源码编译。
+// 从文件构建时 #include "文件" 在读入时就地展开（相对包含它的文件所在目录），被包含的源码也进入缓存键。
+//
+// 环境变量：
+//   OCL_PROGRAM_CACHE          缓存目录，默认 ".clcache"；设为 "off" 关闭缓存
+//   OCL_PROGRAM_CACHE_VERBOSE  非空时在 stderr 打印每次命中/未命中
+
+#include <CL/cl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#define PROGRAM_CACHE_VERSION 1
+#define PROGRAM_CACHE_DEFAULT_DIR ".clcache"
+
+typedef struct
+{
+    unsigned long hits;   // 从二进制加载的次数
+    unsigned long misses; // 从源码编译的次数
+} program_cache_stats_t;
+
+static program_cache_stats_t program_cache_stats = {0, 0};
+
+static inline unsigned long long program_cache_fnv1a(unsigned long long hash, const void *data, size_t size)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= p[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// 把设备/平台信息字符串混入哈希
+static inline unsigned long long program_cache_hash_info(unsigned long long hash, cl_device_id device, cl_platform_id platform, cl_uint param)
+{
+    char info[256] = {0};
+    if (platform != NULL)
+    {
+        clGetPlatformInfo(platform, param, sizeof(info) - 1, info, NULL);
+    }
+    else
+    {
+        clGetDeviceInfo(device, param, sizeof(info) - 1, info, NULL);
+    }
+    return program_cache_fnv1a(hash, info, strlen(info) + 1);
+}
+
+static inline const char *program_cache_dir(void)
+{
+    const char *dir = getenv("OCL_PROGRAM_CACHE");
+    if (dir == NULL || dir[0] == '\0')
+    {
+        return PROGRAM_CACHE_DEFAULT_DIR;
+    }
+    if (strcmp(dir, "off") == 0)
+    {
+        return NULL;
+    }
+    return dir;
+}
+
+// 生成缓存文件路径：<dir>/<hash>.bin
+static inline int program_cache_path(cl_device_id device, const char *source, size_t source_size, const char *options,
+                                     char *path, size_t path_size)
+{
+    const char *dir = program_cache_dir();
+    if (dir == NULL)
+    {
+        return 0;
+    }
+
+    cl_platform_id platform = NULL;
+    clGetDeviceInfo(device, CL_DEVICE_PLATFORM, sizeof(platform), &platform, NULL);
+
+    int version = PROGRAM_CACHE_VERSION;
+    unsigned long long hash = 14695981039346656037ULL;
+    hash = program_cache_fnv1a(hash, &version, sizeof(version));
+    hash = program_cache_fnv1a(hash, source, source_size);
+    hash = program_cache_fnv1a(hash, options ? options : "", options ? strlen(options) + 1 : 1);
+    hash = program_cache_hash_info(hash, device, NULL, CL_DEVICE_NAME);
+    hash = program_cache_hash_info(hash, device, NULL, CL_DEVICE_VERSION);
+    hash = program_cache_hash_info(hash, device, NULL, CL_DRIVER_VERSION);
+    if (platform != NULL)
+    {
+        hash = program_cache_hash_info(hash, device, platform, CL_PLATFORM_VERSION);
+    }
+
+    // 路径放不下时不缓存，避免截断后的路径指向别的文件
+    int length = snprintf(path, path_size, "%s/%016llx.bin", dir, hash);
+    return length > 0 && (size_t)length < path_size;
+}
+
+// 逐级创建缓存目录（mkdir -p），OCL_PROGRAM_CACHE 可以是多级路径
+static inline void program_cache_mkdirs(const char *dir)
+{
+    size_t length = strlen(dir);
+    char *path = (char *)malloc(length + 1);
+    memcpy(path, dir, length + 1);
+    for (size_t i = 1; i <= length; ++i)
+    {
+        if (path[i] == '/' || path[i] == '\0')
+        {
+            char c = path[i];
+            path[i] = '\0';
+            mkdir(path, 0755);
+            path[i] = c;
+        }
+    }
+    free(path);
+}
+
+static inline void program_cache_print_log(cl_program program, cl_device_id device)
+{
+    size_t log_size = 0;
+    clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, 0, NULL, &log_size);
+    char *log = (char *)malloc(log_size + 1);
+    clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, log_size, log, NULL);
+    log[log_size] = '\0';
+    fprintf(stderr, "Build log:\n%s\n", log);
+    free(log);
+}
+
+// 尝试从缓存文件加载，失败（文件不存在、驱动拒绝二进制）时返回 NULL
+static inline cl_program program_cache_load(cl_context context, cl_device_id device, const char *path, const char *options)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    size_t size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    unsigned char *binary = (unsigned char *)malloc(size);
+    size_t read = fread(binary, 1, size, file);
+    fclose(file);
+    if (read != size || size == 0)
+    {
+        free(binary);
+        return NULL;
+    }
+
+    cl_int status, err;
+    const unsigned char *binaries[1] = {binary};
+    cl_program program = clCreateProgramWithBinary(context, 1, &device, &size, binaries, &status, &err);
+    free(binary);
+    if (err != CL_SUCCESS || status != CL_SUCCESS)
+    {
+        if (program)
+        {
+            clReleaseProgram(program);
+        }
+        return NULL;
+    }
+
+    // 二进制程序仍需 clBuildProgram，但只做链接，不会重新编译源码
+    if (clBuildProgram(program, 1, &device, options, NULL, NULL) != CL_SUCCESS)
+    {
+        clReleaseProgram(program);
+        return NULL;
+    }
+    return program;
+}
+
+// 把编译好的程序二进制写入缓存（先写临时文件再 rename，避免多进程读到半个文件）。
+// 临时文件名由 mkstemp 生成，同时编译同一程序的两个进程不会写到同一个临时文件
+static inline void program_cache_store(cl_program program, const char *path)
+{
+    size_t size = 0;
+    if (clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, sizeof(size), &size, NULL) != CL_SUCCESS || size == 0)
+    {
+        return;
+    }
+    unsigned char *binary = (unsigned char *)malloc(size);
+    unsigned char *binaries[1] = {binary};
+    if (clGetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(binaries), binaries, NULL) != CL_SUCCESS)
+    {
+        free(binary);
+        return;
+    }
+
+    program_cache_mkdirs(program_cache_dir());
+
+    size_t tmp_size = strlen(path) + sizeof(".XXXXXX");
+    char *tmp_path = (char *)malloc(tmp_size);
+    snprintf(tmp_path, tmp_size, "%s.XXXXXX", path);
+    int fd = mkstemp(tmp_path);
+    FILE *file = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    if (fd >= 0 && file == NULL)
+    {
+        close(fd);
+        remove(tmp_path);
+    }
+    if (file)
+    {
+        fchmod(fd, 0644); // mkstemp 创建的是 0600
+        size_t written = fwrite(binary, 1, size, file);
+        fclose(file);
+        if (written == size)
+        {
+            rename(tmp_path, path);
+        }
+        else
+        {
+            remove(tmp_path);
+        }
+    }
+    free(tmp_path);
+    free(binary);
+}
+
+// 从源码字符串构建程序，优先使用磁盘缓存。
+// from_cache 非空时写入 1（命中缓存）或 0（从源码编译）
+static inline cl_program program_cache_build_source(cl_context context, cl_device_id device,
+                                                    const char *source, size_t source_size, const char *options,
+                                                    int *from_cache, cl_int *errcode_ret)
+{
+    char path[1024];
+    int cacheable = program_cache_path(device, source, source_size, options, path, sizeof(path));
+    int verbose = getenv("OCL_PROGRAM_CACHE_VERBOSE") != NULL;
+    cl_int err = CL_SUCCESS;
+
+    if (cacheable)
+    {
+        cl_program program = program_cache_load(context, device, path, options);
+        if (program)
+        {
+            program_cache_stats.hits++;
+            if (verbose)
+            {
+                fprintf(stderr, "program cache hit: %s\n", path);
+            }
+            if (from_cache)
+            {
+                *from_cache = 1;
+            }
+            if (errcode_ret)
+            {
+                *errcode_ret = CL_SUCCESS;
+            }
+            return program;
+        }
+    }
+
+    program_cache_stats.misses++;
+    if (verbose)
+    {
+        fprintf(stderr, "program cache miss: %s\n", cacheable ? path : "(disabled)");
+    }
+    if (from_cache)
+    {
+        *from_cache = 0;
+    }
+
+    cl_program program = clCreateProgramWithSource(context, 1, &source, &source_size, &err);
+    if (err == CL_SUCCESS)
+    {
+        err = clBuildProgram(program, 1, &device, options, NULL, NULL);
+        if (err != CL_SUCCESS)
+        {
+            program_cache_print_log(program, device);
+            clReleaseProgram(program);
+            program = NULL;
+        }
+        else if (cacheable)
+        {
+            program_cache_store(program, path);
+        }
+    }
+    if (errcode_ret)
+    {
+        *errcode_ret = err;
+    }
+    return program;
+}
+
+// 读入 .cl 源码，行首的 #include "文件" 换成该文件展开后的内容（可以嵌套，最多 8 层）。
+// 返回以 '\0' 结尾的源码，调用者 free；失败返回 NULL
+static inline char *program_cache_read_source(const char *filename, size_t *size_ret, int depth)
+{
+    FILE *file = fopen(filename, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "Failed to open kernel file: %s\n", filename);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    size_t size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *raw = (char *)malloc(size + 1);
+    size = fread(raw, 1, size, file);
+    raw[size] = '\0';
+    fclose(file);
+
+    static const char directive[] = "#include \"";
+    const size_t directive_length = sizeof(directive) - 1;
+    const char *slash = strrchr(filename, '/');
+    size_t dir_length = slash ? (size_t)(slash - filename) + 1 : 0;
+    size_t capacity = size + 1, length = 0;
+    char *source = (char *)malloc(capacity);
+    const char *line = raw, *end = raw + size;
+    while (line < end)
+    {
+        const char *eol = (const char *)memchr(line, '\n', end - line);
+        const char *next = eol ? eol + 1 : end;
+        const char *p = line;
+        while (p < next && (*p == ' ' || *p == '\t'))
+        {
+            p++;
+        }
+        const char *name = NULL, *quote = NULL;
+        if ((size_t)(next - p) > directive_length && strncmp(p, directive, directive_length) == 0)
+        {
+            name = p + directive_length;
+            quote = (const char *)memchr(name, '"', next - name);
+        }
+        char *included = NULL;
+        size_t included_size = 0;
+        if (quote)
+        {
+            if (depth >= 8)
+            {
+                fprintf(stderr, "Kernel includes nested too deeply in %s\n", filename);
+                free(raw);
+                free(source);
+                return NULL;
+            }
+            char *path = (char *)malloc(dir_length + (quote - name) + 1);
+            memcpy(path, filename, dir_length);
+            memcpy(path + dir_length, name, quote - name);
+            path[dir_length + (quote - name)] = '\0';
+            included = program_cache_read_source(path, &included_size, depth + 1);
+            free(path);
+            if (!included)
+            {
+                free(raw);
+                free(source);
+                return NULL;
+            }
+        }
+        const char *piece = included ? included : line;
+        size_t piece_size = included ? included_size : (size_t)(next - line);
+        if (length + piece_size + 2 > capacity)
+        {
+            capacity = (length + piece_size + 2) * 2;
+            source = (char *)realloc(source, capacity);
+        }
+        memcpy(source + length, piece, piece_size);
+        length += piece_size;
+        if (included)
+        {
+            if (included_size == 0 || included[included_size - 1] != '\n')
+            {
+                source[length++] = '\n'; // 被包含的文件没有结尾换行时补上
+            }
+            free(included);
+        }
+        line = next;
+    }
+    source[length] = '\0';
+    free(raw);
+    *size_ret = length;
+    return source;
+}
+
+// 从 .cl 文件构建程序，优先使用磁盘缓存
+static inline cl_program program_cache_build(cl_context context, cl_device_id device, const char *filename,
+                                             const char *options, int *from_cache, cl_int *errcode_ret)
+{
+    size_t size = 0;
+    char *source = program_cache_read_source(filename, &size, 0);
+    if (!source)
+    {
+        if (errcode_ret)
+        {
+            *errcode_ret = CL_INVALID_VALUE;
+        }
+        return NULL;
+    }
+
+    cl_program program = program_cache_build_source(context, device, source, size, options, from_cache, errcode_ret);
+    free(source);
+    return program;
+}
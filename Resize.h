@@ -0,0 +1,357 @@
+#pragma once
+#include <CL/cl.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+
+#include "ProgramCache.h"
+#include "WorkSizeTuner.h"
+#include "ResizeTables.h"
+
+// resize.cl 的前端：按缩放比例和设备能力选择内核变体，生成对应的 -D 选项，
+// program 在进程内按选项缓存（磁盘上走 ProgramCache），系数表走 ResizeTableCache。
+//
+// 选择规则（8 位无符号数据，1 ~ 4 通道）：
+//   源为 image2d                     -> resizeSampler（硬件双线性，仅 LINEAR / AUTO）
+//   NEAREST                          -> resizeNN
+//   两个方向都是整数倍缩小           -> resizeAREA_FAST（每个源像素只读一次，无混叠）；
+//                                       LINEAR 只在恰好 2 倍时走这里，此时双线性就是 2x2 平均，仅舍入方式不同
+//   AREA / AUTO 的非整数倍缩小       -> resizeAREA（系数表）
+//   LINEAR 的其余缩小               -> resizeLN_tiled（局部内存分块、可分离，结果与 resizeLN 逐位一致）；
+//                                       源行在一个块内放不下局部内存时退回 resizeLN
+//   其余（放大）                     -> resizeLN，INTER_LINEAR_INTEGER（系数表）
+
+namespace bos::mm
+{
+    // 调用方要求的插值方式
+    enum class ResizeMethod
+    {
+        AUTO,    // 缩小用区域平均，放大用双线性
+        NEAREST,
+        LINEAR,
+        AREA
+    };
+
+    // resize.cl 中实际启动的内核
+    enum class ResizeKernel
+    {
+        NN,
+        LN_INTEGER,
+        LN_TILED,
+        SAMPLER,
+        AREA_FAST,
+        AREA
+    };
+
+    inline const char *resize_kernel_name(ResizeKernel kernel)
+    {
+        switch (kernel)
+        {
+        case ResizeKernel::NN:
+            return "resizeNN";
+        case ResizeKernel::LN_INTEGER:
+            return "resizeLN";
+        case ResizeKernel::LN_TILED:
+            return "resizeLN_tiled";
+        case ResizeKernel::SAMPLER:
+            return "resizeSampler";
+        case ResizeKernel::AREA_FAST:
+            return "resizeAREA_FAST";
+        case ResizeKernel::AREA:
+            return "resizeAREA";
+        }
+        return "";
+    }
+
+    class Resizer
+    {
+    public:
+        // resizeLN_tiled 的块尺寸（即工作组尺寸）和每条源行在局部内存中的字节数
+        static constexpr int TILE_W = 32;
+        static constexpr int TILE_H = 8;
+        static constexpr int TILE_SPAN = 1024;
+
+        // 一个块覆盖的源列区间（按 16 字节装载取整）是否放得下 TILE_SPAN
+        static bool tiled_fits(int src_w, int dst_w, int channels)
+        {
+            int pixels = (int)std::ceil((double)TILE_W * src_w / dst_w) + 3;
+            return (pixels * channels + 15) / 16 * 16 <= TILE_SPAN;
+        }
+
+        Resizer(cl_context context, cl_device_id device) : context(context), device(device), tables(context)
+        {
+            clRetainContext(context);
+            cl_bool images = CL_FALSE;
+            clGetDeviceInfo(device, CL_DEVICE_IMAGE_SUPPORT, sizeof(images), &images, nullptr);
+            image_support = images == CL_TRUE;
+        }
+
+        Resizer(const Resizer &) = delete;
+        Resizer &operator=(const Resizer &) = delete;
+
+        ~Resizer()
+        {
+            for (auto &entry : kernels)
+            {
+                clReleaseKernel(entry.second.kernel);
+                clReleaseProgram(entry.second.program);
+            }
+            clReleaseContext(context);
+        }
+
+        // 只做选择，不启动；src_is_image 表示源是 image2d
+        ResizeKernel select(int src_w, int src_h, int dst_w, int dst_h, ResizeMethod method, bool src_is_image, int channels = 3) const
+        {
+            if (src_is_image)
+            {
+                return ResizeKernel::SAMPLER;
+            }
+            if (method == ResizeMethod::NEAREST)
+            {
+                return ResizeKernel::NN;
+            }
+            bool downscale = dst_w <= src_w && dst_h <= src_h && (dst_w < src_w || dst_h < src_h);
+            bool integer = src_w % dst_w == 0 && src_h % dst_h == 0;
+            if (method == ResizeMethod::LINEAR)
+            {
+                if (downscale && src_w == dst_w * 2 && src_h == dst_h * 2)
+                {
+                    return ResizeKernel::AREA_FAST;
+                }
+                return downscale && tiled_fits(src_w, dst_w, channels) ? ResizeKernel::LN_TILED : ResizeKernel::LN_INTEGER;
+            }
+            if (!downscale)
+            {
+                return ResizeKernel::LN_INTEGER;
+            }
+            return integer ? ResizeKernel::AREA_FAST : ResizeKernel::AREA;
+        }
+
+        // 缓冲区到缓冲区：src / dst 为 channels 通道 uchar 图像，行距以字节计
+        cl_int resize(cl_command_queue queue, cl_mem src, int src_step, int src_w, int src_h,
+                      cl_mem dst, int dst_step, int dst_w, int dst_h, int channels,
+                      ResizeMethod method = ResizeMethod::AUTO, cl_event *event = nullptr)
+        {
+            if (!valid(src_w, src_h, dst_w, dst_h, channels))
+            {
+                return CL_INVALID_VALUE;
+            }
+            ResizeKernel which = select(src_w, src_h, dst_w, dst_h, method, false, channels);
+            std::lock_guard<std::mutex> lock(mutex);
+            cl_int err = CL_SUCCESS;
+            cl_kernel kernel = get_kernel(which, channels, src_w, src_h, dst_w, dst_h, &err);
+            if (err != CL_SUCCESS)
+            {
+                return err;
+            }
+
+            int offset = 0;
+            float ifx = (float)src_w / dst_w, ify = (float)src_h / dst_h;
+            cl_uint index = 0;
+            err = clSetKernelArg(kernel, index++, sizeof(cl_mem), &src);
+            err |= clSetKernelArg(kernel, index++, sizeof(int), &src_step);
+            err |= clSetKernelArg(kernel, index++, sizeof(int), &offset);
+            err |= clSetKernelArg(kernel, index++, sizeof(int), &src_h);
+            err |= clSetKernelArg(kernel, index++, sizeof(int), &src_w);
+            err |= clSetKernelArg(kernel, index++, sizeof(cl_mem), &dst);
+            err |= clSetKernelArg(kernel, index++, sizeof(int), &dst_step);
+            err |= clSetKernelArg(kernel, index++, sizeof(int), &offset);
+            err |= clSetKernelArg(kernel, index++, sizeof(int), &dst_h);
+            err |= clSetKernelArg(kernel, index++, sizeof(int), &dst_w);
+            ResizeTables t; // 持有系数表直到内核提交之后，期间其他线程淘汰这一几何也不影响
+            try
+            {
+                if (which == ResizeKernel::NN)
+                {
+                    err |= clSetKernelArg(kernel, index++, sizeof(float), &ifx);
+                    err |= clSetKernelArg(kernel, index++, sizeof(float), &ify);
+                }
+                else if (which == ResizeKernel::LN_INTEGER || which == ResizeKernel::LN_TILED)
+                {
+                    t = tables.get(src_w, src_h, dst_w, dst_h, ResizeInterpolation::LINEAR);
+                    err |= clSetKernelArg(kernel, index++, sizeof(cl_mem), &t.coeffs);
+                }
+                else if (which == ResizeKernel::AREA)
+                {
+                    t = tables.get(src_w, src_h, dst_w, dst_h, ResizeInterpolation::AREA);
+                    err |= clSetKernelArg(kernel, index++, sizeof(float), &ifx);
+                    err |= clSetKernelArg(kernel, index++, sizeof(float), &ify);
+                    err |= clSetKernelArg(kernel, index++, sizeof(cl_mem), &t.ofs);
+                    err |= clSetKernelArg(kernel, index++, sizeof(cl_mem), &t.map);
+                    err |= clSetKernelArg(kernel, index++, sizeof(cl_mem), &t.alpha);
+                }
+            }
+            catch (const std::exception &)
+            {
+                return CL_MEM_OBJECT_ALLOCATION_FAILURE;
+            }
+            if (err != CL_SUCCESS)
+            {
+                return err;
+            }
+
+            size_t global[2] = {(size_t)dst_w, (size_t)dst_h};
+            if (which == ResizeKernel::LN_TILED)
+            {
+                // reqd_work_group_size 固定了工作组尺寸，不经过调优器
+                size_t local[2] = {TILE_W, TILE_H};
+                global[0] = (global[0] + TILE_W - 1) / TILE_W * TILE_W;
+                global[1] = (global[1] + TILE_H - 1) / TILE_H * TILE_H;
+                return clEnqueueNDRangeKernel(queue, kernel, 2, nullptr, global, local, 0, nullptr, event);
+            }
+            return enqueue_tuned(queue, kernel, 2, global, event);
+        }
+
+        // image2d 到缓冲区（resizeSampler）：源的通道数由图像格式决定（CL_R / CL_RG / CL_RGBA，CL_UNORM_INT8）
+        cl_int resize(cl_command_queue queue, cl_mem src_image, cl_mem dst, int dst_step, int dst_w, int dst_h,
+                      cl_event *event = nullptr)
+        {
+            if (!image_support)
+            {
+                return CL_INVALID_OPERATION;
+            }
+            cl_image_format format;
+            size_t src_w = 0, src_h = 0;
+            cl_int err = clGetImageInfo(src_image, CL_IMAGE_FORMAT, sizeof(format), &format, nullptr);
+            err |= clGetImageInfo(src_image, CL_IMAGE_WIDTH, sizeof(src_w), &src_w, nullptr);
+            err |= clGetImageInfo(src_image, CL_IMAGE_HEIGHT, sizeof(src_h), &src_h, nullptr);
+            if (err != CL_SUCCESS)
+            {
+                return err;
+            }
+            int channels = format.image_channel_order == CL_R ? 1 : format.image_channel_order == CL_RG ? 2
+                                                                  : format.image_channel_order == CL_RGBA ? 4 : 0;
+            if (format.image_channel_data_type != CL_UNORM_INT8 || channels == 0 || dst_w <= 0 || dst_h <= 0)
+            {
+                return CL_INVALID_IMAGE_FORMAT_DESCRIPTOR;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            cl_kernel kernel = get_kernel(ResizeKernel::SAMPLER, channels, (int)src_w, (int)src_h, dst_w, dst_h, &err);
+            if (err != CL_SUCCESS)
+            {
+                return err;
+            }
+            int offset = 0;
+            float ifx = (float)src_w / dst_w, ify = (float)src_h / dst_h;
+            err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &src_image);
+            err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &dst);
+            err |= clSetKernelArg(kernel, 2, sizeof(int), &dst_step);
+            err |= clSetKernelArg(kernel, 3, sizeof(int), &offset);
+            err |= clSetKernelArg(kernel, 4, sizeof(int), &dst_h);
+            err |= clSetKernelArg(kernel, 5, sizeof(int), &dst_w);
+            err |= clSetKernelArg(kernel, 6, sizeof(float), &ifx);
+            err |= clSetKernelArg(kernel, 7, sizeof(float), &ify);
+            if (err != CL_SUCCESS)
+            {
+                return err;
+            }
+            size_t global[2] = {(size_t)dst_w, (size_t)dst_h};
+            return enqueue_tuned(queue, kernel, 2, global, event);
+        }
+
+        // 生成某个变体的编译选项（OpenCV ocl_resize 的写法）
+        static std::string build_options(ResizeKernel which, int channels, int src_w, int src_h, int dst_w, int dst_h)
+        {
+            std::string cn = channels == 1 ? "" : std::to_string(channels);
+            std::string options = "-D SRC_DEPTH=0 -D CN=" + std::to_string(channels) + " -D T1=uchar -D T=uchar" + cn;
+            switch (which)
+            {
+            case ResizeKernel::NN:
+                options += " -D INTER_NEAREST";
+                break;
+            case ResizeKernel::LN_INTEGER:
+                options += " -D INTER_LINEAR_INTEGER -D WT=int" + cn + " -D CONVERT_TO_WT=convert_int" + cn +
+                           " -D CONVERT_TO_DT=convert_uchar" + cn + "_sat -D INTER_RESIZE_COEF_BITS=11";
+                break;
+            case ResizeKernel::LN_TILED:
+                options += " -D INTER_LINEAR_TILED -D WT=int" + cn + " -D CONVERT_TO_WT=convert_int" + cn +
+                           " -D CONVERT_TO_DT=convert_uchar" + cn + "_sat -D TILE_W=" + std::to_string(TILE_W) +
+                           " -D TILE_H=" + std::to_string(TILE_H) + " -D TILE_SPAN=" + std::to_string(TILE_SPAN);
+                break;
+            case ResizeKernel::SAMPLER:
+                options += " -D USE_SAMPLER -D CONVERT_TO_DT=convert_uchar" + cn + "_sat";
+                break;
+            case ResizeKernel::AREA_FAST:
+            {
+                int xscale = src_w / dst_w, yscale = src_h / dst_h;
+                char scale[32];
+                snprintf(scale, sizeof(scale), "%.9g", 1.0 / (xscale * yscale));
+                if (strpbrk(scale, ".e") == nullptr)
+                {
+                    strcat(scale, ".0");
+                }
+                options += " -D INTER_AREA -D INTER_AREA_FAST -D XSCALE=" + std::to_string(xscale) + " -D YSCALE=" +
+                           std::to_string(yscale) + " -D SCALE=" + scale + "f -D WTV=int" + cn + " -D CONVERT_TO_WTV=convert_int" + cn +
+                           " -D WT2V=float" + cn + " -D CONVERT_TO_WT2V=convert_float" + cn + " -D CONVERT_TO_T=convert_uchar" + cn +
+                           "_sat_rte";
+                break;
+            }
+            case ResizeKernel::AREA:
+                options += " -D INTER_AREA -D WTV=float" + cn + " -D CONVERT_TO_WTV=convert_float" + cn +
+                           " -D CONVERT_TO_T=convert_uchar" + cn + "_sat_rte";
+                break;
+            }
+            return options;
+        }
+
+        bool get_image_support() const
+        {
+            return image_support;
+        }
+
+        ResizeTableCache &get_tables()
+        {
+            return tables;
+        }
+
+    private:
+        struct Built
+        {
+            cl_program program;
+            cl_kernel kernel;
+        };
+
+        static bool valid(int src_w, int src_h, int dst_w, int dst_h, int channels)
+        {
+            return src_w > 0 && src_h > 0 && dst_w > 0 && dst_h > 0 && channels >= 1 && channels <= 4;
+        }
+
+        // 同一组选项只构建一次；AREA_FAST 的选项含缩放倍数，每个倍数一份
+        cl_kernel get_kernel(ResizeKernel which, int channels, int src_w, int src_h, int dst_w, int dst_h, cl_int *err)
+        {
+            std::string options = build_options(which, channels, src_w, src_h, dst_w, dst_h);
+            auto it = kernels.find(options);
+            if (it != kernels.end())
+            {
+                *err = CL_SUCCESS;
+                return it->second.kernel;
+            }
+            Built built;
+            built.program = program_cache_build(context, device, "resize.cl", options.c_str(), nullptr, err);
+            if (*err != CL_SUCCESS)
+            {
+                return nullptr;
+            }
+            built.kernel = clCreateKernel(built.program, resize_kernel_name(which), err);
+            if (*err != CL_SUCCESS)
+            {
+                clReleaseProgram(built.program);
+                return nullptr;
+            }
+            kernels[options] = built;
+            return built.kernel;
+        }
+
+        cl_context context;
+        cl_device_id device;
+        bool image_support = false;
+        ResizeTableCache tables;
+        std::mutex mutex;
+        std::map<std::string, Built> kernels; // 编译选项 -> program / kernel
+    };
+}
@@ -0,0 +1,214 @@
+#pragma once
+#include <CL/cl.h>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <mutex>
+
+#include "ProgramCache.h"
+#include "WorkSizeTuner.h"
+#include "Compose.h"
+#include "resize_coord.cl" // 与内核共用的定点源坐标 resize_fixed_coord
+
+// NV21 / NV12 缩放引擎（resize_nvx.cl）：亮度、色度各自一次启动，半像素中心对齐。
+//   resize()       整数路径，缓冲区进出，与 resize_nvx_reference 逐位一致
+//   resize_image() 采样器路径，亮度为 CL_R、色度为 CL_RG 的 CL_UNORM_INT8 图像，精度由硬件滤波决定
+// 所有宽高必须是偶数
+
+namespace bos::mm
+{
+    // 一个平面的主机端参考实现；channels 为 1（Y）或 2（交织的 UV），宽高以“像素 / UV 对”计
+    inline void resize_nvx_plane_reference(const uint8_t *src, size_t src_step, int src_w, int src_h,
+                                           uint8_t *dst, size_t dst_step, int dst_w, int dst_h, int channels)
+    {
+        const int COEF_BITS = RESIZE_COEF_BITS, ONE = RESIZE_COEF_ONE;
+        int scale_x = (src_w << 16) / dst_w, scale_y = (src_h << 16) / dst_h;
+        for (int dy = 0; dy < dst_h; ++dy)
+        {
+            int sy, wy;
+            resize_fixed_coord(dy, scale_y, src_h, &sy, &wy);
+            const uint8_t *row0 = src + sy * src_step;
+            const uint8_t *row1 = row0 + (wy ? src_step : 0);
+            for (int dx = 0; dx < dst_w; ++dx)
+            {
+                int sx, wx;
+                resize_fixed_coord(dx, scale_x, src_w, &sx, &wx);
+                int x0 = sx * channels, x1 = (sx + (wx ? 1 : 0)) * channels;
+                for (int c = 0; c < channels; ++c)
+                {
+                    int top = row0[x0 + c] * (ONE - wx) + row0[x1 + c] * wx;
+                    int bottom = row1[x0 + c] * (ONE - wx) + row1[x1 + c] * wx;
+                    dst[dy * dst_step + dx * channels + c] =
+                        (uint8_t)((top * (ONE - wy) + bottom * wy + (1 << (2 * COEF_BITS - 1))) >> (2 * COEF_BITS));
+                }
+            }
+        }
+    }
+
+    // 紧密排列的整帧 NV21 / NV12
+    inline void resize_nvx_reference(const uint8_t *src, int src_w, int src_h, uint8_t *dst, int dst_w, int dst_h)
+    {
+        resize_nvx_plane_reference(src, src_w, src_w, src_h, dst, dst_w, dst_w, dst_h, 1);
+        resize_nvx_plane_reference(src + (size_t)src_w * src_h, src_w, src_w / 2, src_h / 2,
+                                   dst + (size_t)dst_w * dst_h, dst_w, dst_w / 2, dst_h / 2, 2);
+    }
+
+    class Nv21Resizer
+    {
+    public:
+        Nv21Resizer(cl_context context, cl_device_id device)
+        {
+            cl_int err = CL_SUCCESS;
+            program = program_cache_build(context, device, "resize_nvx.cl", nullptr, nullptr, &err);
+            if (err != CL_SUCCESS)
+            {
+                throw std::runtime_error("Failed to build resize_nvx.cl: " + std::to_string(err));
+            }
+            luma = clCreateKernel(program, "resize_nvx_luma", &err);
+            if (err == CL_SUCCESS)
+            {
+                chroma = clCreateKernel(program, "resize_nvx_chroma", &err);
+            }
+            cl_bool images = CL_FALSE;
+            clGetDeviceInfo(device, CL_DEVICE_IMAGE_SUPPORT, sizeof(images), &images, nullptr);
+            if (err == CL_SUCCESS && images == CL_TRUE)
+            {
+                image = clCreateKernel(program, "resize_nvx_image", &err);
+            }
+            if (err != CL_SUCCESS)
+            {
+                release();
+                throw std::runtime_error("Failed to create resize_nvx kernels: " + std::to_string(err));
+            }
+        }
+
+        Nv21Resizer(const Nv21Resizer &) = delete;
+        Nv21Resizer &operator=(const Nv21Resizer &) = delete;
+
+        ~Nv21Resizer()
+        {
+            release();
+        }
+
+        // 整数路径。event 挂在色度启动上，要求队列顺序执行
+        cl_int resize(cl_command_queue queue, const Nv21Target &src, int src_w, int src_h,
+                      const Nv21Target &dst, int dst_w, int dst_h, cl_event *event = nullptr)
+        {
+            if (src_w <= 0 || src_h <= 0 || dst_w <= 0 || dst_h <= 0 || (src_w | src_h | dst_w | dst_h) & 1)
+            {
+                return CL_INVALID_VALUE;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            cl_int err = set_args(luma, src.y, src.step, src.y_base, src_w, src_h, dst.y, dst.step, dst.y_base, dst_w, dst_h);
+            if (err != CL_SUCCESS)
+            {
+                return err;
+            }
+            size_t luma_global[2] = {(size_t)(dst_w + LUMA_VEC - 1) / LUMA_VEC, (size_t)dst_h};
+            err = enqueue_tuned(queue, luma, 2, luma_global);
+            if (err != CL_SUCCESS)
+            {
+                return err;
+            }
+            err = set_args(chroma, src.uv, src.step, src.uv_base, src_w / 2, src_h / 2, dst.uv, dst.step, dst.uv_base, dst_w / 2, dst_h / 2);
+            if (err != CL_SUCCESS)
+            {
+                return err;
+            }
+            size_t chroma_global[2] = {(size_t)dst_w / 2, (size_t)dst_h / 2};
+            return enqueue_tuned(queue, chroma, 2, chroma_global, event);
+        }
+
+        // 采样器路径：设备不支持图像时返回 CL_INVALID_OPERATION
+        cl_int resize_image(cl_command_queue queue, cl_mem src_y, cl_mem src_uv, cl_mem dst_y, cl_mem dst_uv, cl_event *event = nullptr)
+        {
+            if (image == nullptr)
+            {
+                return CL_INVALID_OPERATION;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            cl_mem planes[2][2] = {{src_y, dst_y}, {src_uv, dst_uv}};
+            for (int p = 0; p < 2; ++p)
+            {
+                size_t src_w = 0, src_h = 0, dst_w = 0, dst_h = 0;
+                cl_int err = clGetImageInfo(planes[p][0], CL_IMAGE_WIDTH, sizeof(src_w), &src_w, nullptr);
+                err |= clGetImageInfo(planes[p][0], CL_IMAGE_HEIGHT, sizeof(src_h), &src_h, nullptr);
+                err |= clGetImageInfo(planes[p][1], CL_IMAGE_WIDTH, sizeof(dst_w), &dst_w, nullptr);
+                err |= clGetImageInfo(planes[p][1], CL_IMAGE_HEIGHT, sizeof(dst_h), &dst_h, nullptr);
+                if (err != CL_SUCCESS)
+                {
+                    return err;
+                }
+                float ifx = (float)src_w / dst_w, ify = (float)src_h / dst_h;
+                err = clSetKernelArg(image, 0, sizeof(cl_mem), &planes[p][0]);
+                err |= clSetKernelArg(image, 1, sizeof(cl_mem), &planes[p][1]);
+                err |= clSetKernelArg(image, 2, sizeof(float), &ifx);
+                err |= clSetKernelArg(image, 3, sizeof(float), &ify);
+                if (err != CL_SUCCESS)
+                {
+                    return err;
+                }
+                size_t global[2] = {dst_w, dst_h};
+                err = enqueue_tuned(queue, image, 2, global, p == 1 ? event : nullptr);
+                if (err != CL_SUCCESS)
+                {
+                    return err;
+                }
+            }
+            return CL_SUCCESS;
+        }
+
+        bool get_image_support() const
+        {
+            return image != nullptr;
+        }
+
+    private:
+        static const int LUMA_VEC = 4; // 与 resize_nvx.cl 的默认值一致
+
+        static cl_int set_args(cl_kernel kernel, cl_mem src, size_t src_step, size_t src_offset, int src_w, int src_h,
+                               cl_mem dst, size_t dst_step, size_t dst_offset, int dst_w, int dst_h)
+        {
+            int src_step_i = (int)src_step, src_offset_i = (int)src_offset;
+            int dst_step_i = (int)dst_step, dst_offset_i = (int)dst_offset;
+            int scale_x = (src_w << 16) / dst_w, scale_y = (src_h << 16) / dst_h;
+            cl_int err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &src);
+            err |= clSetKernelArg(kernel, 1, sizeof(int), &src_step_i);
+            err |= clSetKernelArg(kernel, 2, sizeof(int), &src_offset_i);
+            err |= clSetKernelArg(kernel, 3, sizeof(int), &src_w);
+            err |= clSetKernelArg(kernel, 4, sizeof(int), &src_h);
+            err |= clSetKernelArg(kernel, 5, sizeof(cl_mem), &dst);
+            err |= clSetKernelArg(kernel, 6, sizeof(int), &dst_step_i);
+            err |= clSetKernelArg(kernel, 7, sizeof(int), &dst_offset_i);
+            err |= clSetKernelArg(kernel, 8, sizeof(int), &dst_w);
+            err |= clSetKernelArg(kernel, 9, sizeof(int), &dst_h);
+            err |= clSetKernelArg(kernel, 10, sizeof(int), &scale_x);
+            err |= clSetKernelArg(kernel, 11, sizeof(int), &scale_y);
+            return err;
+        }
+
+        void release()
+        {
+            for (cl_kernel kernel : {luma, chroma, image})
+            {
+                if (kernel)
+                {
+                    clReleaseKernel(kernel);
+                }
+            }
+            if (program)
+            {
+                clReleaseProgram(program);
+            }
+            luma = chroma = image = nullptr;
+            program = nullptr;
+        }
+
+        cl_program program = nullptr;
+        cl_kernel luma = nullptr;
+        cl_kernel chroma = nullptr;
+        cl_kernel image = nullptr; // 设备不支持图像时为空
+        std::mutex mutex;
+    };
+}
@@ -0,0 +1,275 @@
+#pragma once
+#include <CL/cl.h>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// resize.cl 系数表的设备端缓存
+//
+// resizeLN（INTER_LINEAR_INTEGER）和 resizeAREA 的插值表只取决于几何 (src_w, src_h, dst_w, dst_h) 和插值方式，
+// 视频流里同一个几何会重复几个小时。每个几何只在主机上计算一次、上传一次，之后常驻设备，
+// 后续缩放直接取 cl_mem 设为内核参数，不再有主机端的表计算和上传。
+
+namespace bos::mm
+{
+    // 需要系数表的插值方式
+    enum class ResizeInterpolation
+    {
+        LINEAR, // resizeLN，-D INTER_LINEAR_INTEGER：xofs, yofs, ialpha, ibeta 打包在同一个缓冲区
+        AREA    // resizeAREA（非整数比例）：ofs_tab, map_tab, alpha_tab 三个缓冲区
+    };
+
+    // 一个几何对应的设备端表；LINEAR 只有 coeffs，AREA 只有 ofs / map / alpha。
+    // 每个副本各持有一份 cl_mem 引用（复制时 clRetainMemObject，析构时释放），
+    // 缓存淘汰这一几何后，调用者手里的副本仍然有效，直到它析构
+    struct ResizeTables
+    {
+        cl_mem coeffs = nullptr;
+        cl_mem ofs = nullptr;
+        cl_mem map = nullptr;
+        cl_mem alpha = nullptr;
+        size_t bytes = 0; // 设备端占用
+
+        ResizeTables() = default;
+
+        ResizeTables(const ResizeTables &other)
+            : coeffs(other.coeffs), ofs(other.ofs), map(other.map), alpha(other.alpha), bytes(other.bytes)
+        {
+            for (cl_mem mem : {coeffs, ofs, map, alpha})
+            {
+                if (mem)
+                {
+                    clRetainMemObject(mem);
+                }
+            }
+        }
+
+        ResizeTables(ResizeTables &&other) noexcept
+            : coeffs(other.coeffs), ofs(other.ofs), map(other.map), alpha(other.alpha), bytes(other.bytes)
+        {
+            other.coeffs = other.ofs = other.map = other.alpha = nullptr;
+            other.bytes = 0;
+        }
+
+        ResizeTables &operator=(ResizeTables other) noexcept
+        {
+            std::swap(coeffs, other.coeffs);
+            std::swap(ofs, other.ofs);
+            std::swap(map, other.map);
+            std::swap(alpha, other.alpha);
+            std::swap(bytes, other.bytes);
+            return *this;
+        }
+
+        ~ResizeTables()
+        {
+            for (cl_mem mem : {coeffs, ofs, map, alpha})
+            {
+                if (mem)
+                {
+                    clReleaseMemObject(mem);
+                }
+            }
+        }
+    };
+
+    // INTER_LINEAR_INTEGER 的表：int xofs[dst_w], int yofs[dst_h], short ialpha[dst_w * 2], short ibeta[dst_h * 2]，
+    // 系数按 INTER_RESIZE_COEF_BITS = 11 定点化
+    inline std::vector<unsigned char> build_resize_linear_tables(int src_w, int src_h, int dst_w, int dst_h)
+    {
+        const int INTER_RESIZE_COEF_SCALE = 2048;
+        const float inv_fx = (float)src_w / dst_w;
+        const float inv_fy = (float)src_h / dst_h;
+
+        std::vector<unsigned char> buffer((dst_w + dst_h) * sizeof(int) + (dst_w + dst_h) * 2 * sizeof(short));
+        int *xofs = (int *)buffer.data();
+        int *yofs = xofs + dst_w;
+        short *ialpha = (short *)(yofs + dst_h);
+        short *ibeta = ialpha + dst_w * 2;
+
+        for (int dx = 0; dx < dst_w; dx++)
+        {
+            float fxx = (float)((dx + 0.5) * inv_fx - 0.5);
+            int sx = (int)std::floor(fxx);
+            fxx -= sx;
+            if (sx < 0)
+            {
+                fxx = 0, sx = 0;
+            }
+            if (sx >= src_w - 1)
+            {
+                fxx = 0, sx = src_w - 1;
+            }
+            xofs[dx] = sx;
+            ialpha[dx * 2 + 0] = (short)((1.f - fxx) * INTER_RESIZE_COEF_SCALE);
+            ialpha[dx * 2 + 1] = (short)(fxx * INTER_RESIZE_COEF_SCALE);
+        }
+        for (int dy = 0; dy < dst_h; dy++)
+        {
+            float fyy = (float)((dy + 0.5) * inv_fy - 0.5);
+            int sy = (int)std::floor(fyy);
+            fyy -= sy;
+            yofs[dy] = sy;
+            ibeta[dy * 2 + 0] = (short)((1.f - fyy) * INTER_RESIZE_COEF_SCALE);
+            ibeta[dy * 2 + 1] = (short)(fyy * INTER_RESIZE_COEF_SCALE);
+        }
+        return buffer;
+    }
+
+    // resizeAREA 一个方向上的表（OpenCV 的 ocl_computeResizeAreaTabs）：
+    // ofs_tab[d]..ofs_tab[d + 1] 为输出第 d 个像素覆盖的源像素区间，map_tab / alpha_tab 为源坐标及权重
+    inline void build_resize_area_axis(int ssize, int dsize, double scale, int *map_tab, float *alpha_tab, int *ofs_tab)
+    {
+        int k = 0, dx = 0;
+        for (; dx < dsize; dx++)
+        {
+            ofs_tab[dx] = k;
+            double fsx1 = dx * scale;
+            double fsx2 = fsx1 + scale;
+            double cell_width = std::min(scale, ssize - fsx1);
+            int sx1 = (int)std::ceil(fsx1), sx2 = (int)std::floor(fsx2);
+            sx2 = std::min(sx2, ssize - 1);
+            sx1 = std::min(sx1, sx2);
+
+            if (sx1 - fsx1 > 1e-3)
+            {
+                map_tab[k] = sx1 - 1;
+                alpha_tab[k++] = (float)((sx1 - fsx1) / cell_width);
+            }
+            for (int sx = sx1; sx < sx2; sx++)
+            {
+                map_tab[k] = sx;
+                alpha_tab[k++] = (float)(1.0 / cell_width);
+            }
+            if (fsx2 - sx2 > 1e-3)
+            {
+                map_tab[k] = sx2;
+                alpha_tab[k++] = (float)(std::min(std::min(fsx2 - sx2, 1.), cell_width) / cell_width);
+            }
+        }
+        ofs_tab[dx] = k;
+    }
+
+    // 按几何缓存的设备端系数表，属于一个 context，可被多个线程共享。
+    // 超过 capacity 个几何时缓存放掉最久未用的一组；get() 返回的 ResizeTables 自己持有引用，
+    // 调用者要让它活到内核提交之后（已提交的命令会再持有 cl_mem），之后析构即可
+    class ResizeTableCache
+    {
+    public:
+        explicit ResizeTableCache(cl_context context, size_t capacity = 16) : context(context), capacity(std::max<size_t>(capacity, 1))
+        {
+            clRetainContext(context);
+        }
+
+        ResizeTableCache(const ResizeTableCache &) = delete;
+        ResizeTableCache &operator=(const ResizeTableCache &) = delete;
+
+        ~ResizeTableCache()
+        {
+            entries.clear();
+            clReleaseContext(context);
+        }
+
+        // 取 (src_w, src_h, dst_w, dst_h, interpolation) 对应的表，第一次用到时计算并上传
+        ResizeTables get(int src_w, int src_h, int dst_w, int dst_h, ResizeInterpolation interpolation)
+        {
+            if (src_w <= 0 || src_h <= 0 || dst_w <= 0 || dst_h <= 0)
+            {
+                throw std::invalid_argument("Resize geometry must be positive.");
+            }
+            Key key(src_w, src_h, dst_w, dst_h, interpolation);
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = entries.find(key);
+            if (it != entries.end())
+            {
+                it->second.last_use = ++clock;
+                return it->second.tables;
+            }
+
+            if (entries.size() >= capacity)
+            {
+                auto oldest = std::min_element(entries.begin(), entries.end(), [](const auto &a, const auto &b)
+                                               { return a.second.last_use < b.second.last_use; });
+                entries.erase(oldest);
+            }
+
+            Entry entry;
+            entry.tables = interpolation == ResizeInterpolation::LINEAR ? build_linear(src_w, src_h, dst_w, dst_h)
+                                                                        : build_area(src_w, src_h, dst_w, dst_h);
+            entry.last_use = ++clock;
+            ++builds;
+            return entries.emplace(key, std::move(entry)).first->second.tables;
+        }
+
+        // 累计计算并上传过的几何数（命中缓存时不变）
+        size_t get_builds() const
+        {
+            return builds;
+        }
+
+        size_t size() const
+        {
+            return entries.size();
+        }
+
+    private:
+        using Key = std::tuple<int, int, int, int, ResizeInterpolation>;
+
+        struct Entry
+        {
+            ResizeTables tables;
+            uint64_t last_use = 0;
+        };
+
+        cl_mem upload(const void *data, size_t size)
+        {
+            cl_int err = CL_SUCCESS;
+            cl_mem mem = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, size, const_cast<void *>(data), &err);
+            if (err != CL_SUCCESS)
+            {
+                throw std::runtime_error("Failed to create resize table: " + std::to_string(err));
+            }
+            return mem;
+        }
+
+        ResizeTables build_linear(int src_w, int src_h, int dst_w, int dst_h)
+        {
+            std::vector<unsigned char> data = build_resize_linear_tables(src_w, src_h, dst_w, dst_h);
+            ResizeTables tables;
+            tables.coeffs = upload(data.data(), data.size());
+            tables.bytes = data.size();
+            return tables;
+        }
+
+        // map / alpha 表：x 方向 src_w * 2 项，y 方向 src_h * 2 项；ofs 表：dst_w + 1 与 dst_h + 1 项
+        ResizeTables build_area(int src_w, int src_h, int dst_w, int dst_h)
+        {
+            std::vector<int> map_tab((src_w + src_h) * 2), ofs_tab(dst_w + dst_h + 2);
+            std::vector<float> alpha_tab((src_w + src_h) * 2);
+            build_resize_area_axis(src_w, dst_w, (double)src_w / dst_w, map_tab.data(), alpha_tab.data(), ofs_tab.data());
+            build_resize_area_axis(src_h, dst_h, (double)src_h / dst_h, map_tab.data() + src_w * 2, alpha_tab.data() + src_w * 2,
+                                   ofs_tab.data() + dst_w + 1);
+
+            ResizeTables tables; // 上传中途失败时析构释放已创建的表
+            tables.ofs = upload(ofs_tab.data(), ofs_tab.size() * sizeof(int));
+            tables.map = upload(map_tab.data(), map_tab.size() * sizeof(int));
+            tables.alpha = upload(alpha_tab.data(), alpha_tab.size() * sizeof(float));
+            tables.bytes = ofs_tab.size() * sizeof(int) + map_tab.size() * sizeof(int) + alpha_tab.size() * sizeof(float);
+            return tables;
+        }
+
+        cl_context context;
+        size_t capacity;
+        std::mutex mutex;
+        std::map<Key, Entry> entries;
+        uint64_t clock = 0;
+        size_t builds = 0;
+    };
+}
@@ -0,0 +1,218 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "BufferPool.h"
+#include "Image.h"
+
+// 多帧原始序列（.yuv / .nv21 / .rgb …）的 mmap 读取。
+//
+// 整个文件只映射一次，第 N 帧是映射中的一段，以 MAPPED 类型的 Buffer 交出，
+// 可以直接用于 Image 的外部缓冲区构造，不经过 fread、不复制。帧按文件中的顺序紧密排列（可以带固定长度的文件头），
+// 格式和宽高由调用者声明；帧在文件中的起始偏移记录在帧索引里，容器格式可以用自己的索引构造。
+//
+// 预读：访问第 N 帧时对其后 prefetch_frames 帧发 POSIX_FADV_WILLNEED，内核在后台读盘；
+// drop_behind 时某一帧的最后一个 Buffer 释放后，把这一帧从进程映射和页缓存中丢掉，几个 GB 的采集文件也不会占满内存。
+// 丢弃跟随 Buffer 的释放而不是帧序号，仍在使用的帧（包括写过的私有页）不会被丢掉；映射是 MAP_PRIVATE 的，
+// 丢掉的页再次访问时从文件重新读入。
+
+namespace bos::mm
+{
+    struct SequenceOptions
+    {
+        size_t header_bytes = 0;    // 文件头长度，第一帧从这里开始
+        size_t prefetch_frames = 4; // 预读的帧数，0 表示不预读
+        bool drop_behind = true;    // 帧的 Buffer 全部释放后丢弃它的页
+    };
+
+    class SequenceReader
+    {
+    public:
+        // 原始序列：帧数 = (文件长度 - header_bytes) / 帧长，末尾不足一帧的部分忽略
+        SequenceReader(const std::string &path, Image::Format format, size_t width, size_t height,
+                       const SequenceOptions &options = SequenceOptions())
+            : SequenceReader(path, format, width, height, options, std::vector<size_t>())
+        {
+        }
+
+        // 帧索引由调用者给出（每帧在文件中的起始偏移），用于帧之间带有头部的容器格式
+        SequenceReader(const std::string &path, Image::Format format, size_t width, size_t height, const SequenceOptions &options,
+                       std::vector<size_t> frame_offsets)
+            : format(format), width(width), height(height), options(options), offsets(std::move(frame_offsets))
+        {
+            std::vector<Image::PlaneLayout> layout;
+            frame_size = Image::compute_layout(format, width, height, Image::LayoutOptions(), layout);
+            if (frame_size == 0)
+            {
+                throw std::invalid_argument("Sequence frame size must be positive.");
+            }
+            mapping = std::make_shared<Mapping>(path);
+            if (offsets.empty())
+            {
+                size_t frames = mapping->size > options.header_bytes ? (mapping->size - options.header_bytes) / frame_size : 0;
+                for (size_t i = 0; i < frames; ++i)
+                {
+                    offsets.push_back(options.header_bytes + i * frame_size);
+                }
+            }
+            for (size_t offset : offsets)
+            {
+                if (offset + frame_size > mapping->size)
+                {
+                    throw std::invalid_argument("Sequence frame lies outside " + path + ".");
+                }
+            }
+            if (offsets.empty())
+            {
+                throw std::invalid_argument(path + " is shorter than one frame.");
+            }
+            mapping->owners.resize(offsets.size());
+            posix_fadvise(mapping->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+            madvise(mapping->data, mapping->size, MADV_SEQUENTIAL);
+        }
+
+        SequenceReader(const SequenceReader &) = delete;
+        SequenceReader &operator=(const SequenceReader &) = delete;
+
+        size_t get_frame_count() const { return offsets.size(); }
+
+        // 一帧的字节数（紧密排列）
+        size_t get_frame_size() const { return frame_size; }
+
+        Image::Format get_format() const { return format; }
+        size_t get_width() const { return width; }
+        size_t get_height() const { return height; }
+
+        // 第 index 帧在文件中的起始偏移
+        size_t get_frame_offset(size_t index) const { return offsets.at(index); }
+
+        // 第 index 帧的零拷贝 Buffer；Buffer 持有映射，读取器先析构也没有关系。
+        // 映射可写但为私有：写入只改本进程的副本，不会写回文件（该帧的 Buffer 全部释放、drop_behind 丢弃后恢复为文件内容）
+        std::shared_ptr<Buffer> frame_buffer(size_t index)
+        {
+            if (index >= offsets.size())
+            {
+                throw std::out_of_range("Sequence frame " + std::to_string(index) + " out of range.");
+            }
+            advise(index);
+            std::shared_ptr<void> owner = options.drop_behind ? frame_owner(index) : mapping;
+            return std::make_shared<Buffer>(mapping->data + offsets[index], frame_size, owner);
+        }
+
+        // 第 index 帧包装成 Image（紧密排列的布局）
+        Image frame(size_t index)
+        {
+            return Image(format, width, height, std::vector<std::shared_ptr<Buffer>>{frame_buffer(index)});
+        }
+
+    private:
+        // 只读打开、私有映射整个文件；最后一个引用它的 Buffer 释放时解除映射
+        struct Mapping
+        {
+            explicit Mapping(const std::string &path)
+            {
+                fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+                struct stat st;
+                if (fd < 0 || fstat(fd, &st) != 0)
+                {
+                    if (fd >= 0)
+                    {
+                        close(fd);
+                    }
+                    throw std::runtime_error("Failed to open sequence " + path + ".");
+                }
+                size = static_cast<size_t>(st.st_size);
+                void *ptr = size ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+                if (ptr == MAP_FAILED)
+                {
+                    close(fd);
+                    throw std::runtime_error("Failed to map sequence " + path + ".");
+                }
+                data = static_cast<uint8_t *>(ptr);
+            }
+
+            ~Mapping()
+            {
+                munmap(data, size);
+                close(fd);
+            }
+
+            // 丢弃 [offset, offset + length) 的页缓存，以及完全落在其中的映射页（首尾与相邻帧共用的页保留）
+            void drop(size_t offset, size_t length)
+            {
+                const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+                size_t begin = (offset + page - 1) / page * page;
+                size_t end = (offset + length) / page * page;
+                if (end > begin)
+                {
+                    madvise(data + begin, end - begin, MADV_DONTNEED);
+                }
+                posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(length), POSIX_FADV_DONTNEED);
+            }
+
+            int fd = -1;
+            uint8_t *data = nullptr;
+            size_t size = 0;
+            std::mutex owners_mutex;
+            std::vector<std::weak_ptr<void>> owners; // 每帧当前的所有者，同一帧的 Buffer 共用一个
+        };
+
+        // 帧的所有者持有映射；最后一个引用它的 Buffer 释放时丢弃这一帧。
+        // 释放与重新获取同一帧并发时，新的所有者已登记，旧的不再丢弃
+        std::shared_ptr<void> frame_owner(size_t index)
+        {
+            std::lock_guard<std::mutex> lock(mapping->owners_mutex);
+            std::shared_ptr<void> owner = mapping->owners[index].lock();
+            if (owner == nullptr)
+            {
+                std::shared_ptr<Mapping> keep = mapping;
+                size_t offset = offsets[index], length = frame_size;
+                owner = std::shared_ptr<void>(keep->data + offset, [keep, index, offset, length](void *)
+                                              {
+                                                  std::lock_guard<std::mutex> lock(keep->owners_mutex);
+                                                  if (keep->owners[index].expired())
+                                                  {
+                                                      keep->drop(offset, length);
+                                                  }
+                                              });
+                mapping->owners[index] = owner;
+            }
+            return owner;
+        }
+
+        void advise(size_t index)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (options.prefetch_frames > 0)
+            {
+                // 已经预读过的范围不再重复发
+                size_t last = std::min(index + options.prefetch_frames, offsets.size() - 1);
+                size_t end = offsets[last] + frame_size;
+                size_t begin = std::max(offsets[index], prefetched_until);
+                if (end > begin)
+                {
+                    posix_fadvise(mapping->fd, static_cast<off_t>(begin), static_cast<off_t>(end - begin), POSIX_FADV_WILLNEED);
+                    prefetched_until = end;
+                }
+            }
+        }
+
+        Image::Format format;
+        size_t width, height;
+        SequenceOptions options;
+        size_t frame_size = 0;
+        std::vector<size_t> offsets; // 帧索引
+        std::shared_ptr<Mapping> mapping;
+        std::mutex mutex;
+        size_t prefetched_until = 0; // 已发过 WILLNEED 的文件范围终点
+    };
+}
@@ -0,0 +1,329 @@
+#pragma once
+#include <CL/cl.h>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <algorithm>
+
+#include "Image.h"
+#include "Compose.h"
+
+// 流水线流式执行器：N 个帧槽轮转在上传、计算、下载三条顺序队列上，用 cl_event 串起来，
+// 第 k 帧的计算与第 k + 1 帧的上传、第 k - 1 帧的下载同时进行，吞吐趋近 max(传输, 计算) 而不是两者之和。
+//
+// 每个槽：主机端输入 / 输出各一个池化 Image，设备端输入 / 输出各一个常驻 cl_mem（不带 USE_HOST_PTR，
+// 上传下载是真正的 DMA 拷贝）。一帧的命令：
+//   上传队列   clEnqueueWriteBuffer(input -> src)                     -> uploaded
+//   计算队列   barrier(uploaded)，compute(src -> dst)                 -> computed
+//   下载队列   clEnqueueReadBuffer(dst -> output)，等待 computed      -> downloaded
+// 槽再次使用前等待它上一帧的 downloaded，此时上一帧的三段都已完成，主机端输入、设备缓冲区都可以改写。
+// slots = 1 时每帧都等前一帧下载完，即同步处理，用作对照。
+// write 回调可以留下输出 Image 的引用（例如交给 FrameSink 异步写盘），槽再次使用时发现输出仍被引用，
+// 就从池里换一个新的 Image，旧的随最后一个引用释放回到池中，不需要复制
+
+namespace bos::mm
+{
+    // 交给计算回调的一帧
+    struct StreamFrame
+    {
+        size_t index;  // 帧序号
+        Image &input;  // 主机端输入（已上传）
+        Image &output; // 主机端输出（计算完成后下载到这里）
+        cl_mem src;    // 设备端输入，布局与 input 相同
+        cl_mem dst;    // 设备端输出，布局与 output 相同
+    };
+
+    // 设备端整帧缓冲区上的 NV21 / NV12 平面位置，布局取自主机端 Image
+    inline Nv21Target stream_target(const Image &image, cl_mem mem)
+    {
+        const auto &planes = image.get_planes();
+        return {mem, mem, planes[0]->get_offset(), planes[1]->get_offset(), planes[0]->get_stride()};
+    }
+
+    // 一次 run() 的统计；*_ms 为各段设备时间之和（需要运行时支持事件计时）
+    struct StreamStats
+    {
+        size_t frames = 0;
+        double seconds = 0; // 墙钟时间，包含读入与写出
+        double upload_ms = 0;
+        double compute_ms = 0;
+        double download_ms = 0;
+
+        double fps() const
+        {
+            return seconds > 0 ? frames / seconds : 0;
+        }
+    };
+
+    class StreamPipeline
+    {
+    public:
+        // 读入第 index 帧到 input；返回 false 表示流结束
+        using Reader = std::function<bool(Image &input, size_t index)>;
+        // 在 queue 上提交一帧的计算，event 挂在最后一条命令上（队列顺序执行）
+        using Compute = std::function<cl_int(cl_command_queue queue, StreamFrame &frame, cl_event *event)>;
+        // 处理完的第 index 帧，按帧序回调；可以复制 output 这个 shared_ptr 留到回调之后使用
+        using Writer = std::function<void(const std::shared_ptr<Image> &output, size_t index)>;
+
+        StreamPipeline(cl_context context, cl_device_id device, Image::Format input_format, size_t input_width, size_t input_height,
+                       Image::Format output_format, size_t output_width, size_t output_height, BufferPool &pool, size_t slot_count = 3)
+            : pool(pool), output_format(output_format), output_width(output_width), output_height(output_height)
+        {
+            if (slot_count == 0)
+            {
+                throw std::invalid_argument("Stream pipeline needs at least one slot.");
+            }
+            cl_int err = CL_SUCCESS;
+            for (cl_command_queue *queue : {&upload_queue, &compute_queue, &download_queue})
+            {
+                *queue = clCreateCommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE, &err);
+                if (err != CL_SUCCESS)
+                {
+                    release();
+                    throw std::runtime_error("Failed to create stream queue: " + std::to_string(err));
+                }
+            }
+            for (size_t i = 0; i < slot_count; ++i)
+            {
+                auto slot = std::make_unique<Slot>();
+                slot->input = std::make_unique<Image>(input_format, input_width, input_height, pool);
+                slot->output = std::make_shared<Image>(output_format, output_width, output_height, pool);
+                slot->src = clCreateBuffer(context, CL_MEM_READ_ONLY, slot->input->get_size(), nullptr, &err);
+                if (err == CL_SUCCESS)
+                {
+                    slot->dst = clCreateBuffer(context, CL_MEM_WRITE_ONLY, slot->output->get_size(), nullptr, &err);
+                }
+                slots.push_back(std::move(slot));
+                if (err != CL_SUCCESS)
+                {
+                    release();
+                    throw std::runtime_error("Failed to create stream buffers: " + std::to_string(err));
+                }
+            }
+        }
+
+        StreamPipeline(const StreamPipeline &) = delete;
+        StreamPipeline &operator=(const StreamPipeline &) = delete;
+
+        ~StreamPipeline()
+        {
+            release();
+        }
+
+        // 处理整条流直到 read 返回 false；出错时等待已提交的帧完成后返回错误码，已完成的帧仍按序交给 write
+        cl_int run(const Reader &read, const Compute &compute, const Writer &write, StreamStats *stats = nullptr)
+        {
+            StreamStats total;
+            auto start = std::chrono::steady_clock::now();
+            cl_int result = CL_SUCCESS;
+            size_t next = 0; // 下一个要读入的帧
+            bool ended = false;
+            while (!ended && result == CL_SUCCESS)
+            {
+                Slot &slot = *slots[next % slots.size()];
+                if (slot.busy)
+                {
+                    result = retire(slot, write, total);
+                    if (result != CL_SUCCESS)
+                    {
+                        break;
+                    }
+                }
+                if (!read(*slot.input, next))
+                {
+                    ended = true;
+                    break;
+                }
+                result = submit(slot, next, compute);
+                ++next;
+            }
+
+            // 排空：剩下的槽按帧序收尾
+            for (size_t i = 0; i < slots.size(); ++i)
+            {
+                Slot &slot = *slots[(next + i) % slots.size()];
+                if (slot.busy)
+                {
+                    cl_int err = retire(slot, write, total);
+                    result = result == CL_SUCCESS ? err : result;
+                }
+            }
+            total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (stats)
+            {
+                *stats = total;
+            }
+            return result;
+        }
+
+        size_t get_slot_count() const
+        {
+            return slots.size();
+        }
+
+    private:
+        struct Slot
+        {
+            std::unique_ptr<Image> input;
+            std::shared_ptr<Image> output; // write 回调可能还持有上一帧的输出
+            cl_mem src = nullptr, dst = nullptr;
+            cl_event uploaded = nullptr, started = nullptr, computed = nullptr, downloaded = nullptr;
+            size_t index = 0;
+            bool busy = false;
+        };
+
+        cl_int submit(Slot &slot, size_t index, const Compute &compute)
+        {
+            slot.index = index;
+            slot.busy = true;
+            if (slot.output.use_count() > 1)
+            {
+                slot.output = std::make_shared<Image>(output_format, output_width, output_height, pool);
+            }
+            cl_int err = clEnqueueWriteBuffer(upload_queue, slot.src, CL_FALSE, 0, slot.input->get_size(), slot.input->get_data(),
+                                              0, nullptr, &slot.uploaded);
+            if (err != CL_SUCCESS)
+            {
+                return err;
+            }
+            // 其他队列等待 uploaded 之前必须先提交上传队列，否则回调里的 clFinish（例如首帧的工作组调优）可能死锁
+            clFlush(upload_queue);
+            // 栅栏让计算队列后续命令等待本帧上传；marker 的完成时间即计算开始时间
+            err = clEnqueueBarrierWithWaitList(compute_queue, 1, &slot.uploaded, nullptr);
+            if (err == CL_SUCCESS)
+            {
+                err = clEnqueueMarkerWithWaitList(compute_queue, 0, nullptr, &slot.started);
+            }
+            if (err != CL_SUCCESS)
+            {
+                return err;
+            }
+            StreamFrame frame = {index, *slot.input, *slot.output, slot.src, slot.dst};
+            err = compute(compute_queue, frame, &slot.computed);
+            if (err != CL_SUCCESS)
+            {
+                return err;
+            }
+            if (slot.computed == nullptr)
+            {
+                // 回调没有给出事件时，用 marker 标记计算结束
+                err = clEnqueueMarkerWithWaitList(compute_queue, 0, nullptr, &slot.computed);
+                if (err != CL_SUCCESS)
+                {
+                    return err;
+                }
+            }
+            // 同理，下载队列等待 computed 之前先提交计算队列
+            clFlush(compute_queue);
+            err = clEnqueueReadBuffer(download_queue, slot.dst, CL_FALSE, 0, slot.output->get_size(), slot.output->get_data(),
+                                      1, &slot.computed, &slot.downloaded);
+            if (err != CL_SUCCESS)
+            {
+                return err;
+            }
+            clFlush(download_queue);
+            return CL_SUCCESS;
+        }
+
+        // 等待槽里的帧完成，交给 write 并释放事件
+        cl_int retire(Slot &slot, const Writer &write, StreamStats &stats)
+        {
+            cl_int err = CL_SUCCESS;
+            if (slot.downloaded)
+            {
+                err = clWaitForEvents(1, &slot.downloaded);
+            }
+            else
+            {
+                // 提交中途失败：等已提交的命令结束后再复用缓冲区
+                clFinish(upload_queue);
+                clFinish(compute_queue);
+                clFinish(download_queue);
+                err = CL_INVALID_OPERATION;
+            }
+            if (err == CL_SUCCESS)
+            {
+                stats.upload_ms += duration_ms(slot.uploaded, slot.uploaded);
+                stats.compute_ms += duration_ms(slot.started, slot.computed);
+                stats.download_ms += duration_ms(slot.downloaded, slot.downloaded);
+                ++stats.frames;
+                write(slot.output, slot.index);
+            }
+            release_events(slot);
+            slot.busy = false;
+            return err;
+        }
+
+        // from 的开始到 to 的结束；marker 没有开始时间时用其结束时间
+        static double duration_ms(cl_event from, cl_event to)
+        {
+            cl_ulong begin = 0, end = 0;
+            if (from == nullptr || to == nullptr ||
+                clGetEventProfilingInfo(to, CL_PROFILING_COMMAND_END, sizeof(end), &end, nullptr) != CL_SUCCESS)
+            {
+                return 0;
+            }
+            if (clGetEventProfilingInfo(from, from == to ? CL_PROFILING_COMMAND_START : CL_PROFILING_COMMAND_END, sizeof(begin), &begin,
+                                        nullptr) != CL_SUCCESS ||
+                end < begin)
+            {
+                return 0;
+            }
+            return (end - begin) * 1e-6;
+        }
+
+        static void release_events(Slot &slot)
+        {
+            for (cl_event *event : {&slot.uploaded, &slot.started, &slot.computed, &slot.downloaded})
+            {
+                if (*event)
+                {
+                    clReleaseEvent(*event);
+                    *event = nullptr;
+                }
+            }
+        }
+
+        void release()
+        {
+            for (cl_command_queue queue : {upload_queue, compute_queue, download_queue})
+            {
+                if (queue)
+                {
+                    clFinish(queue);
+                }
+            }
+            for (auto &slot : slots)
+            {
+                release_events(*slot);
+                for (cl_mem mem : {slot->src, slot->dst})
+                {
+                    if (mem)
+                    {
+                        clReleaseMemObject(mem);
+                    }
+                }
+            }
+            slots.clear();
+            for (cl_command_queue queue : {upload_queue, compute_queue, download_queue})
+            {
+                if (queue)
+                {
+                    clReleaseCommandQueue(queue);
+                }
+            }
+            upload_queue = compute_queue = download_queue = nullptr;
+        }
+
+        cl_command_queue upload_queue = nullptr;
+        cl_command_queue compute_queue = nullptr;
+        cl_command_queue download_queue = nullptr;
+        std::vector<std::unique_ptr<Slot>> slots;
+        BufferPool &pool;
+        Image::Format output_format;
+        size_t output_width, output_height;
+    };
+}
@@ -0,0 +1,381 @@
+#pragma once
+#include <CL/cl.h>
+#include <vector>
+#include <map>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "ProgramCache.h"
+
+// 按设备调优工作组尺寸，结果持久化
+//
+// 调优键 = 设备名 + 驱动版本 + 内核函数名 + 编译选项哈希 + 全局尺寸。某个键第一次启动时，
+// 在私有 profiling 队列上把所有合法的 local size 都试跑一遍；内核有 PIX_PER_WI_Y 变体时也一并比较。
+// 最快的一组写入 <程序缓存目录>/worksize.txt，之后直接查表。
+// 启动时全局尺寸向上取整到 local 的整数倍，所以内核必须自己判断越界（尾部工作项直接返回）。
+//
+// 调优按调用者已经设置好的真实参数，在私有队列上把每个候选跑至少 4 次，输出会被反复改写，
+// 所以内核必须是幂等的：输出只取决于输入，不能原地读改写（累加到输出、输入与输出是同一块内存）。
+// 开始调优前等待调用方队列（clFinish）和 wait_list 中的事件；其他队列上的生产者必须放进 wait_list，
+// 否则调优可能读到尚未写完的输入。
+// 内核源码改动后需要删除 worksize.txt，才会重新调优。
+//
+// 环境变量：
+//   OCL_TUNE          设为 "off" 时不调优，local 交给驱动（NULL）
+//   OCL_TUNE_VERBOSE  非空时在 stderr 打印每次调优的结果
+
+namespace bos::mm
+{
+    // 一次启动的几何
+    struct WorkGeometry
+    {
+        size_t local[3] = {0, 0, 0}; // 全 0 表示交给驱动
+        int pix_per_wi = 1;          // 每个工作项处理的行数（第 1 维），对应 -D PIX_PER_WI_Y
+    };
+
+    // 同一内核按不同 PIX_PER_WI_Y 编译出的变体；不支持的内核只有 {1, kernel} 一项
+    struct KernelVariant
+    {
+        int pix_per_wi;
+        cl_kernel kernel;
+    };
+
+    // 按给定几何提交。global 以“每个工作项处理一行”计：第 1 维先除以 pix_per_wi，
+    // 再把每一维向上取整到 local 的整数倍。wait_list 供乱序队列上的依赖使用
+    inline cl_int enqueue_geometry(cl_command_queue queue, cl_kernel kernel, cl_uint dims, const size_t *global,
+                                   const WorkGeometry &geometry, cl_event *event = nullptr,
+                                   cl_uint num_wait = 0, const cl_event *wait_list = nullptr)
+    {
+        bool use_local = geometry.local[0] != 0;
+        size_t rounded[3] = {1, 1, 1};
+        for (cl_uint d = 0; d < dims; ++d)
+        {
+            size_t size = global[d];
+            if (d == 1)
+            {
+                size = (size + geometry.pix_per_wi - 1) / geometry.pix_per_wi;
+            }
+            if (use_local)
+            {
+                size = (size + geometry.local[d] - 1) / geometry.local[d] * geometry.local[d];
+            }
+            rounded[d] = size;
+        }
+        return clEnqueueNDRangeKernel(queue, kernel, dims, nullptr, rounded, use_local ? geometry.local : nullptr, num_wait, wait_list, event);
+    }
+
+    class WorkSizeTuner
+    {
+    public:
+        static WorkSizeTuner &instance()
+        {
+            static WorkSizeTuner tuner;
+            return tuner;
+        }
+
+        // 返回 variants 在该全局尺寸下的最佳几何，未调优过时先调优。
+        // 调优按真实参数试跑，所以调用前参数必须已经设置好，并且会写输出；wait_list 是输入的生产者（可以在其他队列上）
+        WorkGeometry get(cl_command_queue queue, cl_uint dims, const size_t *global, const std::vector<KernelVariant> &variants,
+                         cl_uint num_wait = 0, const cl_event *wait_list = nullptr)
+        {
+            const char *mode = getenv("OCL_TUNE");
+            if (variants.empty() || (mode != nullptr && strcmp(mode, "off") == 0))
+            {
+                return WorkGeometry();
+            }
+            cl_device_id device = nullptr;
+            if (clGetCommandQueueInfo(queue, CL_QUEUE_DEVICE, sizeof(device), &device, nullptr) != CL_SUCCESS)
+            {
+                return WorkGeometry();
+            }
+
+            std::string key = make_key(device, dims, global, variants);
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = table.find(key);
+            if (it != table.end())
+            {
+                return it->second;
+            }
+
+            WorkGeometry best = tune(queue, device, dims, global, variants, num_wait, wait_list);
+            table[key] = best;
+            save();
+            if (getenv("OCL_TUNE_VERBOSE") != nullptr)
+            {
+                std::cerr << "tuned " << key << ": local " << best.local[0] << "x" << best.local[1] << "x" << best.local[2]
+                          << ", " << best.pix_per_wi << " row(s) per work-item" << std::endl;
+            }
+            return best;
+        }
+
+    private:
+        WorkSizeTuner()
+        {
+            const char *dir = program_cache_dir();
+            if (dir != nullptr)
+            {
+                path = std::string(dir) + "/worksize.txt";
+                load();
+            }
+        }
+
+        static std::string device_string(cl_device_id device, cl_device_info param)
+        {
+            char value[256] = {0};
+            clGetDeviceInfo(device, param, sizeof(value) - 1, value, nullptr);
+            return value;
+        }
+
+        // 键中不含制表符和换行（缓存文件按行、按制表符分隔）
+        static std::string make_key(cl_device_id device, cl_uint dims, const size_t *global, const std::vector<KernelVariant> &variants)
+        {
+            cl_kernel kernel = variants[0].kernel;
+            char name[256] = {0};
+            clGetKernelInfo(kernel, CL_KERNEL_FUNCTION_NAME, sizeof(name) - 1, name, nullptr);
+
+            cl_program program = nullptr;
+            clGetKernelInfo(kernel, CL_KERNEL_PROGRAM, sizeof(program), &program, nullptr);
+            size_t size = 0;
+            clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_OPTIONS, 0, nullptr, &size);
+            std::string options(size, '\0');
+            clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_OPTIONS, size, &options[0], nullptr);
+            unsigned long long hash = program_cache_fnv1a(1469598103934665603ULL, options.data(), options.size());
+
+            std::ostringstream key;
+            key << device_string(device, CL_DEVICE_NAME) << "|" << device_string(device, CL_DRIVER_VERSION) << "|" << name << "|"
+                << std::hex << hash << std::dec << "|";
+            for (const auto &variant : variants)
+            {
+                key << variant.pix_per_wi << ",";
+            }
+            for (cl_uint d = 0; d < dims; ++d)
+            {
+                key << (d ? "x" : "|") << global[d];
+            }
+            std::string result = key.str();
+            for (char &c : result)
+            {
+                c = c == '\t' || c == '\n' ? ' ' : c;
+            }
+            return result;
+        }
+
+        // 所有合法 local size 的候选：第 0 维 8..256，第 1 维 1..16，第 2 维固定为 1，
+        // 不超过内核和设备的限制，也不超过取整到 2 的幂的全局尺寸（否则大半是空转的工作项）
+        static std::vector<WorkGeometry> candidates(cl_kernel kernel, cl_device_id device, cl_uint dims, const size_t *global, int pix_per_wi)
+        {
+            size_t max_group = 0;
+            size_t max_items[3] = {0, 0, 0};
+            clGetKernelWorkGroupInfo(kernel, device, CL_KERNEL_WORK_GROUP_SIZE, sizeof(max_group), &max_group, nullptr);
+            clGetDeviceInfo(device, CL_DEVICE_MAX_WORK_ITEM_SIZES, sizeof(max_items), max_items, nullptr);
+
+            auto covers = [](size_t local, size_t size)
+            {
+                size_t pow2 = 1;
+                while (pow2 < size)
+                {
+                    pow2 *= 2;
+                }
+                return local <= pow2;
+            };
+            size_t rows = dims > 1 ? (global[1] + pix_per_wi - 1) / pix_per_wi : 1;
+
+            std::vector<WorkGeometry> result;
+            WorkGeometry driver;
+            driver.pix_per_wi = pix_per_wi;
+            result.push_back(driver);
+            for (size_t x = dims == 1 ? 16 : 8; x <= (dims == 1 ? 1024 : 256); x *= 2)
+            {
+                for (size_t y = 1; y <= (dims == 1 ? 1 : 16); y *= 2)
+                {
+                    if (x * y > max_group || x > max_items[0] || (dims > 1 && y > max_items[1]) ||
+                        !covers(x, global[0]) || (y > 1 && !covers(y, rows)))
+                    {
+                        continue;
+                    }
+                    WorkGeometry geometry;
+                    geometry.local[0] = x;
+                    geometry.local[1] = dims > 1 ? y : 0;
+                    geometry.local[2] = dims > 2 ? 1 : 0;
+                    geometry.pix_per_wi = pix_per_wi;
+                    result.push_back(geometry);
+                }
+            }
+            return result;
+        }
+
+        // 每个候选先跑一次预热，再取 3 次中最短的内核时间；启动失败（资源不足等）的候选跳过
+        static WorkGeometry tune(cl_command_queue queue, cl_device_id device, cl_uint dims, const size_t *global,
+                                 const std::vector<KernelVariant> &variants, cl_uint num_wait, const cl_event *wait_list)
+        {
+            WorkGeometry best;
+            best.pix_per_wi = variants[0].pix_per_wi;
+            cl_context context = nullptr;
+            clGetCommandQueueInfo(queue, CL_QUEUE_CONTEXT, sizeof(context), &context, nullptr);
+            cl_int err = CL_SUCCESS;
+            cl_command_queue probe = clCreateCommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE, &err);
+            if (err != CL_SUCCESS)
+            {
+                return best;
+            }
+            // 调用方队列里可能还有读写这些缓冲区的命令，其他队列上的生产者由 wait_list 给出，先等它们完成
+            clFinish(queue);
+            if (num_wait > 0 && clWaitForEvents(num_wait, wait_list) != CL_SUCCESS)
+            {
+                clReleaseCommandQueue(probe);
+                return best;
+            }
+
+            double best_time = 1e30;
+            for (const auto &variant : variants)
+            {
+                for (const auto &geometry : candidates(variant.kernel, device, dims, global, variant.pix_per_wi))
+                {
+                    double time = 1e30;
+                    for (int i = 0; i < 4; ++i)
+                    {
+                        cl_event event = nullptr;
+                        if (enqueue_geometry(probe, variant.kernel, dims, global, geometry, &event) != CL_SUCCESS)
+                        {
+                            time = 1e30;
+                            break;
+                        }
+                        clWaitForEvents(1, &event);
+                        cl_ulong start = 0, end = 0;
+                        clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_START, sizeof(start), &start, nullptr);
+                        clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END, sizeof(end), &end, nullptr);
+                        clReleaseEvent(event);
+                        if (i > 0)
+                        {
+                            time = std::min(time, static_cast<double>(end - start));
+                        }
+                    }
+                    if (time < best_time)
+                    {
+                        best_time = time;
+                        best = geometry;
+                    }
+                }
+            }
+            clFinish(probe);
+            clReleaseCommandQueue(probe);
+            return best;
+        }
+
+        // 文件格式：每行 “键<TAB>local0 local1 local2 pix_per_wi”。
+        // keep_existing 为 true 时只补充表里没有的键（合并其他进程的结果，本进程的结果优先）
+        void load(bool keep_existing = false)
+        {
+            std::ifstream file(path);
+            std::string line;
+            while (std::getline(file, line))
+            {
+                size_t tab = line.find('\t');
+                if (tab == std::string::npos)
+                {
+                    continue;
+                }
+                WorkGeometry geometry;
+                std::istringstream values(line.substr(tab + 1));
+                if (values >> geometry.local[0] >> geometry.local[1] >> geometry.local[2] >> geometry.pix_per_wi && geometry.pix_per_wi > 0)
+                {
+                    if (keep_existing)
+                    {
+                        table.emplace(line.substr(0, tab), geometry);
+                    }
+                    else
+                    {
+                        table[line.substr(0, tab)] = geometry;
+                    }
+                }
+            }
+        }
+
+        // 整表重写（先写唯一的临时文件再 rename，与程序缓存相同）。
+        // 多个进程可能同时调优：在 worksize.txt.lock 上加锁，重新读入文件合并其他进程的结果后再写，避免互相覆盖
+        void save()
+        {
+            if (path.empty())
+            {
+                return;
+            }
+            program_cache_mkdirs(program_cache_dir());
+            std::string lock_path = path + ".lock";
+            int lock_fd = open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+            if (lock_fd >= 0)
+            {
+                flock(lock_fd, LOCK_EX);
+            }
+            load(true);
+            write_table();
+            if (lock_fd >= 0)
+            {
+                close(lock_fd); // 关闭即释放 flock
+            }
+        }
+
+        void write_table()
+        {
+            std::string tmp_path = path + ".XXXXXX";
+            int fd = mkstemp(&tmp_path[0]);
+            if (fd < 0)
+            {
+                return;
+            }
+            fchmod(fd, 0644);
+            close(fd);
+            {
+                std::ofstream file(tmp_path);
+                for (const auto &entry : table)
+                {
+                    const WorkGeometry &g = entry.second;
+                    file << entry.first << '\t' << g.local[0] << ' ' << g.local[1] << ' ' << g.local[2] << ' ' << g.pix_per_wi << '\n';
+                }
+                if (!file)
+                {
+                    remove(tmp_path.c_str());
+                    return;
+                }
+            }
+            rename(tmp_path.c_str(), path.c_str());
+        }
+
+        std::mutex mutex;
+        std::map<std::string, WorkGeometry> table;
+        std::string path; // 为空时只在进程内缓存
+    };
+
+    // 按调优结果提交 variants 中最快的变体。wait_list 同时用于调优前的等待和这次提交
+    inline cl_int enqueue_tuned(cl_command_queue queue, const std::vector<KernelVariant> &variants, cl_uint dims, const size_t *global,
+                                cl_event *event = nullptr, cl_uint num_wait = 0, const cl_event *wait_list = nullptr)
+    {
+        WorkGeometry geometry = WorkSizeTuner::instance().get(queue, dims, global, variants, num_wait, wait_list);
+        for (const auto &variant : variants)
+        {
+            if (variant.pix_per_wi == geometry.pix_per_wi)
+            {
+                return enqueue_geometry(queue, variant.kernel, dims, global, geometry, event, num_wait, wait_list);
+            }
+        }
+        WorkGeometry fallback;
+        fallback.pix_per_wi = variants[0].pix_per_wi;
+        return enqueue_geometry(queue, variants[0].kernel, dims, global, fallback, event, num_wait, wait_list);
+    }
+
+    // 单个内核（没有 PIX_PER_WI_Y 变体）
+    inline cl_int enqueue_tuned(cl_command_queue queue, cl_kernel kernel, cl_uint dims, const size_t *global, cl_event *event = nullptr,
+                                cl_uint num_wait = 0, const cl_event *wait_list = nullptr)
+    {
+        return enqueue_tuned(queue, std::vector<KernelVariant>{{1, kernel}}, dims, global, event, num_wait, wait_list);
+    }
+}
@@ -0,0 +1,448 @@
+#pragma once
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include "Image.h"
+#include "Sequence.h"
+
+// YUV4MPEG2（.y4m）的流式读写，让宽高、帧率、色度格式跟着数据走。
+//
+// 文件头：YUV4MPEG2 W<宽> H<高> F<分子>:<分母> I<p|t|b|m> A<分子>:<分母> C<色度> [X...]
+// 每帧：FRAME[ 参数]\n + 平面 Y、U、V 紧密排列。
+// 色度映射到 Image::Format：C420 / C420jpeg / C420paldv / C420mpeg2 -> YUV420，C422 -> YUV422，其他格式不支持。
+// 4:2:0 的帧也可以直接读进 / 写出 NV21、NV12 图像（U、V 平面与交织的色度平面之间逐行转换）。
+//
+// Y4mReader / Y4mWriter 的路径为 "-" 时使用标准输入 / 输出，可以直接接在解码器后面或者把结果管道给编码器。
+// 帧头逐字节读进固定大小的缓冲区，平面逐行读写到 Image 的行距上，每帧没有内存分配。
+
+namespace bos::mm
+{
+    struct Y4mHeader
+    {
+        size_t width = 0, height = 0;
+        Image::Format format = Image::Format::YUV420;
+        std::string chroma = "420jpeg"; // C 标签原文（不含 C）
+        int fps_num = 25, fps_den = 1;
+        char interlace = 'p';
+        int par_num = 0, par_den = 0; // 0:0 表示未知
+
+        // 一帧平面数据的字节数
+        size_t frame_size() const
+        {
+            std::vector<Image::PlaneLayout> layout;
+            return Image::compute_layout(format, width, height, Image::LayoutOptions(), layout);
+        }
+
+        // 文件头一行（含换行）
+        std::string to_string() const
+        {
+            char line[256];
+            snprintf(line, sizeof(line), "YUV4MPEG2 W%zu H%zu F%d:%d I%c A%d:%d C%s\n", width, height, fps_num, fps_den, interlace, par_num, par_den,
+                     chroma.c_str());
+            return line;
+        }
+
+        // 解析文件头一行（不含换行）；格式不对或色度不支持时抛出 std::invalid_argument
+        static Y4mHeader parse(const char *line)
+        {
+            const char magic[] = "YUV4MPEG2";
+            if (strncmp(line, magic, sizeof(magic) - 1) != 0)
+            {
+                throw std::invalid_argument("Not a YUV4MPEG2 stream.");
+            }
+            Y4mHeader header;
+            header.chroma = "420jpeg"; // 没有 C 标签时的默认值
+            const char *p = line + sizeof(magic) - 1;
+            while (*p)
+            {
+                while (*p == ' ')
+                {
+                    ++p;
+                }
+                const char *end = p;
+                while (*end && *end != ' ')
+                {
+                    ++end;
+                }
+                if (end == p)
+                {
+                    break;
+                }
+                std::string value(p + 1, end);
+                switch (*p)
+                {
+                case 'W':
+                    header.width = strtoul(value.c_str(), nullptr, 10);
+                    break;
+                case 'H':
+                    header.height = strtoul(value.c_str(), nullptr, 10);
+                    break;
+                case 'F':
+                    sscanf(value.c_str(), "%d:%d", &header.fps_num, &header.fps_den);
+                    break;
+                case 'I':
+                    header.interlace = value.empty() ? 'p' : value[0];
+                    break;
+                case 'A':
+                    sscanf(value.c_str(), "%d:%d", &header.par_num, &header.par_den);
+                    break;
+                case 'C':
+                    header.chroma = value;
+                    break;
+                default: // X 及未知标签忽略
+                    break;
+                }
+                p = end;
+            }
+            if (header.width == 0 || header.height == 0 || (header.width | header.height) & 1)
+            {
+                throw std::invalid_argument("Y4M width and height must be positive and even.");
+            }
+            header.format = format_of(header.chroma);
+            return header;
+        }
+
+        // 色度标签 -> Image::Format
+        static Image::Format format_of(const std::string &chroma)
+        {
+            if (chroma == "420" || chroma == "420jpeg" || chroma == "420paldv" || chroma == "420mpeg2")
+            {
+                return Image::Format::YUV420;
+            }
+            if (chroma == "422")
+            {
+                return Image::Format::YUV422;
+            }
+            throw std::invalid_argument("Unsupported Y4M chroma C" + chroma + ".");
+        }
+    };
+
+    // 逐行搬运平面数据时用到的公共部分
+    class Y4mStream
+    {
+    protected:
+        // image 能否承载 header 描述的帧：同宽高，且格式相同或是 4:2:0 对应的 NV21 / NV12
+        static void check(const Y4mHeader &header, const Image &image)
+        {
+            Image::Format format = image.get_format();
+            bool semi_planar = format == Image::Format::NV21 || format == Image::Format::NV12;
+            if (image.get_width() != header.width || image.get_height() != header.height ||
+                (format != header.format && !(semi_planar && header.format == Image::Format::YUV420)))
+            {
+                throw std::invalid_argument("Image does not match the Y4M stream geometry or chroma format.");
+            }
+        }
+
+        std::vector<uint8_t> u_plane, v_plane; // NV21 / NV12 与平面 U、V 之间转换用的色度平面，只分配一次
+    };
+
+    class Y4mReader : public Y4mStream
+    {
+    public:
+        // path 为 "-" 时读标准输入
+        explicit Y4mReader(const std::string &path) : path(path)
+        {
+            file = path == "-" ? stdin : fopen(path.c_str(), "rb");
+            if (file == nullptr)
+            {
+                throw std::runtime_error("Failed to open " + path + ".");
+            }
+            setvbuf(file, nullptr, _IOFBF, 1 << 20);
+            char line[1024];
+            if (!read_line(line, sizeof(line)))
+            {
+                close();
+                throw std::runtime_error(path + " has no YUV4MPEG2 header.");
+            }
+            try
+            {
+                header = Y4mHeader::parse(line);
+            }
+            catch (...)
+            {
+                close();
+                throw;
+            }
+            first_frame = ftello(file);
+        }
+
+        Y4mReader(const Y4mReader &) = delete;
+        Y4mReader &operator=(const Y4mReader &) = delete;
+
+        ~Y4mReader()
+        {
+            close();
+        }
+
+        const Y4mHeader &get_header() const { return header; }
+
+        // 读下一帧到 image；流正常结束时返回 false，帧头损坏或帧不完整时抛出 std::runtime_error
+        bool read_frame(Image &image)
+        {
+            check(header, image);
+            char line[256];
+            if (!read_line(line, sizeof(line)))
+            {
+                return false;
+            }
+            if (strncmp(line, "FRAME", 5) != 0)
+            {
+                throw std::runtime_error("Corrupt Y4M frame header in " + path + ".");
+            }
+            const auto &planes = image.get_planes();
+            bool ok = read_plane(*planes[0], header.width);
+            if (planes.size() == 3)
+            {
+                ok = ok && read_plane(*planes[1], planes[1]->get_width()) && read_plane(*planes[2], planes[2]->get_width());
+            }
+            else
+            {
+                ok = ok && read_interleaved(*planes[1], image.get_format() == Image::Format::NV21);
+            }
+            if (!ok)
+            {
+                throw std::runtime_error("Truncated Y4M frame in " + path + ".");
+            }
+            ++frames;
+            return true;
+        }
+
+        // 回到第一帧；管道不能回退，返回 false
+        bool rewind()
+        {
+            if (file == stdin || fseeko(file, first_frame, SEEK_SET) != 0)
+            {
+                return false;
+            }
+            frames = 0;
+            return true;
+        }
+
+        // 从当前位置扫描到流末尾，返回每帧平面数据在文件中的起始偏移（帧索引），末尾不完整的帧忽略
+        std::vector<size_t> scan()
+        {
+            std::vector<size_t> offsets;
+            const off_t frame_size = static_cast<off_t>(header.frame_size());
+            struct stat st;
+            if (file == stdin || fstat(fileno(file), &st) != 0)
+            {
+                return offsets;
+            }
+            char line[256];
+            while (read_line(line, sizeof(line)) && strncmp(line, "FRAME", 5) == 0)
+            {
+                off_t offset = ftello(file);
+                if (offset + frame_size > st.st_size || fseeko(file, frame_size, SEEK_CUR) != 0)
+                {
+                    break;
+                }
+                offsets.push_back(static_cast<size_t>(offset));
+            }
+            return offsets;
+        }
+
+        // 已读的帧数
+        size_t get_frame_count() const { return frames; }
+
+    private:
+        // 读一行（不含换行）到 line；流结束返回 false，行过长抛出异常
+        bool read_line(char *line, size_t size)
+        {
+            size_t n = 0;
+            int c;
+            while ((c = getc(file)) != EOF && c != '\n')
+            {
+                if (n + 1 >= size)
+                {
+                    throw std::runtime_error("Y4M header line too long in " + path + ".");
+                }
+                line[n++] = static_cast<char>(c);
+            }
+            line[n] = '\0';
+            return c == '\n';
+        }
+
+        bool read_plane(Plane &plane, size_t row_bytes)
+        {
+            for (size_t y = 0; y < plane.get_height(); ++y)
+            {
+                if (fread(plane.get_data() + y * plane.get_stride(), 1, row_bytes, file) != row_bytes)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // 平面 U、V 交织成 NV21（VU）或 NV12（UV）
+        bool read_interleaved(Plane &plane, bool vu)
+        {
+            size_t cw = plane.get_width(), ch = plane.get_height();
+            u_plane.resize(cw * ch);
+            v_plane.resize(cw * ch);
+            if (fread(u_plane.data(), 1, u_plane.size(), file) != u_plane.size() || fread(v_plane.data(), 1, v_plane.size(), file) != v_plane.size())
+            {
+                return false;
+            }
+            for (size_t y = 0; y < ch; ++y)
+            {
+                uint8_t *row = plane.get_data() + y * plane.get_stride();
+                const uint8_t *u = u_plane.data() + y * cw, *v = v_plane.data() + y * cw;
+                for (size_t x = 0; x < cw; ++x)
+                {
+                    row[2 * x] = vu ? v[x] : u[x];
+                    row[2 * x + 1] = vu ? u[x] : v[x];
+                }
+            }
+            return true;
+        }
+
+        void close()
+        {
+            if (file && file != stdin)
+            {
+                fclose(file);
+            }
+            file = nullptr;
+        }
+
+        std::string path;
+        FILE *file = nullptr;
+        Y4mHeader header;
+        off_t first_frame = 0;
+        size_t frames = 0;
+    };
+
+    class Y4mWriter : public Y4mStream
+    {
+    public:
+        // path 为 "-" 时写标准输出；文件头立即写出
+        Y4mWriter(const std::string &path, const Y4mHeader &header) : path(path), header(header)
+        {
+            if (header.width == 0 || header.height == 0 || (header.width | header.height) & 1)
+            {
+                throw std::invalid_argument("Y4M width and height must be positive and even.");
+            }
+            Y4mHeader::format_of(header.chroma);
+            file = path == "-" ? stdout : fopen(path.c_str(), "wb");
+            if (file == nullptr)
+            {
+                throw std::runtime_error("Failed to open " + path + ".");
+            }
+            setvbuf(file, nullptr, _IOFBF, 1 << 20);
+            std::string line = header.to_string();
+            if (fwrite(line.data(), 1, line.size(), file) != line.size())
+            {
+                close();
+                throw std::runtime_error("Failed to write Y4M header to " + path + ".");
+            }
+        }
+
+        Y4mWriter(const Y4mWriter &) = delete;
+        Y4mWriter &operator=(const Y4mWriter &) = delete;
+
+        ~Y4mWriter()
+        {
+            close();
+        }
+
+        // 写一帧；下游关闭（管道断开）或磁盘写满时返回 false
+        bool write_frame(Image &image)
+        {
+            check(header, image);
+            static const char frame_line[] = "FRAME\n";
+            const auto &planes = image.get_planes();
+            bool ok = fwrite(frame_line, 1, sizeof(frame_line) - 1, file) == sizeof(frame_line) - 1 && write_plane(*planes[0], header.width);
+            if (planes.size() == 3)
+            {
+                ok = ok && write_plane(*planes[1], planes[1]->get_width()) && write_plane(*planes[2], planes[2]->get_width());
+            }
+            else
+            {
+                ok = ok && write_deinterleaved(*planes[1], image.get_format() == Image::Format::NV21);
+            }
+            frames += ok ? 1 : 0;
+            return ok;
+        }
+
+        bool flush()
+        {
+            return fflush(file) == 0;
+        }
+
+        size_t get_frame_count() const { return frames; }
+
+    private:
+        bool write_plane(Plane &plane, size_t row_bytes)
+        {
+            for (size_t y = 0; y < plane.get_height(); ++y)
+            {
+                if (fwrite(plane.get_data() + y * plane.get_stride(), 1, row_bytes, file) != row_bytes)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // NV21（VU）/ NV12（UV）拆成平面 U、V
+        bool write_deinterleaved(Plane &plane, bool vu)
+        {
+            size_t cw = plane.get_width(), ch = plane.get_height();
+            u_plane.resize(cw * ch);
+            v_plane.resize(cw * ch);
+            for (size_t y = 0; y < ch; ++y)
+            {
+                const uint8_t *row = plane.get_data() + y * plane.get_stride();
+                uint8_t *u = u_plane.data() + y * cw, *v = v_plane.data() + y * cw;
+                for (size_t x = 0; x < cw; ++x)
+                {
+                    u[x] = vu ? row[2 * x + 1] : row[2 * x];
+                    v[x] = vu ? row[2 * x] : row[2 * x + 1];
+                }
+            }
+            return fwrite(u_plane.data(), 1, u_plane.size(), file) == u_plane.size() && fwrite(v_plane.data(), 1, v_plane.size(), file) == v_plane.size();
+        }
+
+        void close()
+        {
+            if (file)
+            {
+                fflush(file);
+                if (file != stdout)
+                {
+                    fclose(file);
+                }
+            }
+            file = nullptr;
+        }
+
+        std::string path;
+        FILE *file = nullptr;
+        Y4mHeader header;
+        size_t frames = 0;
+    };
+
+    // 以 mmap 零拷贝方式随机访问 Y4M 文件：扫描帧头建立帧索引，之后与原始序列相同
+    inline std::unique_ptr<SequenceReader> open_y4m_sequence(const std::string &path, Y4mHeader *header = nullptr,
+                                                             const SequenceOptions &options = SequenceOptions())
+    {
+        Y4mReader reader(path);
+        std::vector<size_t> offsets = reader.scan();
+        if (offsets.empty())
+        {
+            throw std::invalid_argument(path + " has no complete Y4M frame.");
+        }
+        const Y4mHeader &h = reader.get_header();
+        if (header)
+        {
+            *header = h;
+        }
+        return std::make_unique<SequenceReader>(path, h.format, h.width, h.height, options, std::move(offsets));
+    }
+}
@@ -0,0 +1,1066 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <CL/cl.h>
+
+#include "ProgramCache.h"
+#include "Compose.h"
+#include "ResizeTables.h"
+#include "Resize.h"
+
+using namespace bos::mm;
+
+// 统一的内核基准测试：仓库里的每个内核注册为一个用例，按给定分辨率逐一测量。
+//   kernel：只统计内核本身，每次迭代为其 profiling 事件 START..END 之和；迭代之间不 clFinish，队列保持满载
+//   e2e   ：上传输入 + 内核 + 下载输出 + clFinish 的墙钟时间
+// GB/s 按 p50 计算：kernel 用内核读写的字节数，e2e 用主机与设备之间传输的字节数。
+//
+// 用法：bench [--device gpu|cpu|all] [--size WxH]... [--runs N] [--warmup N] [--filter 子串] [--json 文件] [--list]
+// 默认 GPU、1920x1080 和 3840x2160、100 次、预热 10 次，结果写入 bench.json；
+// 全程无交互，可直接在 POCL 的 CPU 设备上跑：bench --device cpu
+//
+// 分辨率的含义：compose / mosaic / remap 为输出画面，resize / color 为输入画面；
+// resize 默认缩小一半（resizeAREA 为 2/3，走非整数比例的系数表），*_x4 为缩小到 1/4（如 8K -> 1080p）
+
+// 输入、输出缓冲区末尾多分配的字节，vload3 / vload4 读三通道数据时会越过最后一个像素
+#define BUFFER_SLACK 64
+
+struct BenchEnv
+{
+    cl_context context;
+    cl_device_id device;
+    cl_command_queue queue;
+    bool image_support;
+    BufferPool pool{{}};
+    std::map<std::string, cl_program> programs; // (文件, 编译选项) -> program
+    std::unique_ptr<ResizeTableCache> tables;   // resize.cl 的系数表，常驻设备，不计入传输
+};
+
+// 一个用例在某个分辨率下准备好的一次迭代
+struct BenchRun
+{
+    std::function<void(std::vector<cl_event> &)> enqueue; // 只提交内核，事件追加到列表
+    std::vector<std::function<void()>> uploads;           // e2e：上传输入
+    std::vector<std::function<void()>> downloads;         // e2e：下载输出
+    size_t bytes = 0;                                     // 内核每次迭代读写的字节数
+    size_t transfer_bytes = 0;                            // 每次迭代上传和下载的字节数
+    std::vector<std::shared_ptr<void>> objects;           // Image、MosaicCompose 等，随用例一起释放
+    std::vector<cl_mem> mems;
+    std::vector<cl_kernel> kernels;
+
+    ~BenchRun()
+    {
+        for (cl_kernel kernel : kernels)
+        {
+            clReleaseKernel(kernel);
+        }
+        for (cl_mem mem : mems)
+        {
+            clReleaseMemObject(mem);
+        }
+    }
+};
+
+struct BenchCase
+{
+    std::string name;
+    const char *source; // 内核所在的 .cl 文件
+    bool needs_images;  // 需要 CL_DEVICE_IMAGE_SUPPORT
+    std::function<void(BenchEnv &, size_t, size_t, BenchRun &)> setup;
+};
+
+struct Stats
+{
+    double min, mean, p50, p90, p99, max; // 毫秒
+};
+
+static void check(cl_int err, const char *what)
+{
+    if (err != CL_SUCCESS)
+    {
+        throw std::runtime_error(std::string(what) + " failed: " + std::to_string(err));
+    }
+}
+
+static void randomFill(unsigned char *data, size_t size)
+{
+    static std::mt19937 rng(12345);
+    for (size_t i = 0; i < size; ++i)
+    {
+        data[i] = static_cast<unsigned char>(rng());
+    }
+}
+
+static size_t nv21Bytes(size_t width, size_t height)
+{
+    return width * height * 3 / 2;
+}
+
+template <typename... Args>
+static void setArgs(cl_kernel kernel, const Args &...args)
+{
+    cl_uint index = 0;
+    cl_int err = CL_SUCCESS;
+    ((err |= clSetKernelArg(kernel, index++, sizeof(args), &args)), ...);
+    check(err, "clSetKernelArg");
+}
+
+static void launch(BenchEnv &env, cl_kernel kernel, size_t global_x, size_t global_y, std::vector<cl_event> &events)
+{
+    size_t global_size[2] = {global_x, global_y};
+    cl_event event;
+    check(enqueue_tuned(env.queue, kernel, 2, global_size, &event), "enqueue_tuned");
+    events.push_back(event);
+}
+
+// 带 PIX_PER_WI_Y 变体的内核：global_y 以“每个工作项一行”计，由调优器选变体
+static void launchVariants(BenchEnv &env, const std::vector<KernelVariant> &variants, size_t global_x, size_t global_y,
+                           std::vector<cl_event> &events)
+{
+    size_t global_size[2] = {global_x, global_y};
+    cl_event event;
+    check(enqueue_tuned(env.queue, variants, 2, global_size, &event), "enqueue_tuned");
+    events.push_back(event);
+}
+
+// 同一 (文件, 选项) 只构建一次，并走磁盘上的程序缓存
+static cl_kernel buildKernel(BenchEnv &env, BenchRun &run, const char *file, const std::string &options, const char *name)
+{
+    std::string key = std::string(file) + "|" + options;
+    cl_program &program = env.programs[key];
+    if (program == NULL)
+    {
+        cl_int err;
+        program = program_cache_build(env.context, env.device, file, options.c_str(), NULL, &err);
+        check(err, file);
+    }
+    cl_int err;
+    cl_kernel kernel = clCreateKernel(program, name, &err);
+    check(err, name);
+    run.kernels.push_back(kernel);
+    return kernel;
+}
+
+// 设备缓冲区。input 为 true 时用随机数据初始化并登记为 e2e 的上传，否则登记为下载
+static cl_mem deviceBuffer(BenchEnv &env, BenchRun &run, size_t size, bool input)
+{
+    cl_int err;
+    cl_mem mem = clCreateBuffer(env.context, input ? CL_MEM_READ_ONLY : CL_MEM_READ_WRITE, size + BUFFER_SLACK, NULL, &err);
+    check(err, "clCreateBuffer");
+    run.mems.push_back(mem);
+    run.transfer_bytes += size;
+
+    auto host = std::make_shared<std::vector<unsigned char>>(size);
+    cl_command_queue queue = env.queue;
+    if (input)
+    {
+        randomFill(host->data(), size);
+        check(clEnqueueWriteBuffer(queue, mem, CL_TRUE, 0, size, host->data(), 0, NULL, NULL), "clEnqueueWriteBuffer");
+        run.uploads.push_back([=]()
+                              { check(clEnqueueWriteBuffer(queue, mem, CL_FALSE, 0, size, host->data(), 0, NULL, NULL), "clEnqueueWriteBuffer"); });
+    }
+    else
+    {
+        run.downloads.push_back([=]()
+                                { check(clEnqueueReadBuffer(queue, mem, CL_FALSE, 0, size, host->data(), 0, NULL, NULL), "clEnqueueReadBuffer"); });
+    }
+    return mem;
+}
+
+// 设备上的 image2d，规则同 deviceBuffer
+static cl_mem deviceImage(BenchEnv &env, BenchRun &run, cl_channel_order order, cl_channel_type type,
+                          size_t width, size_t height, bool input)
+{
+    size_t pixel = order == CL_R ? 1 : order == CL_RG ? 2 : 4;
+    cl_image_format format = {order, type};
+    cl_image_desc desc = {};
+    desc.image_type = CL_MEM_OBJECT_IMAGE2D;
+    desc.image_width = width;
+    desc.image_height = height;
+    cl_int err;
+    cl_mem mem = clCreateImage(env.context, input ? CL_MEM_READ_ONLY : CL_MEM_WRITE_ONLY, &format, &desc, NULL, &err);
+    check(err, "clCreateImage");
+    run.mems.push_back(mem);
+    run.transfer_bytes += width * height * pixel;
+
+    auto host = std::make_shared<std::vector<unsigned char>>(width * height * pixel);
+    cl_command_queue queue = env.queue;
+    auto transfer = [=](cl_bool blocking)
+    {
+        size_t origin[3] = {0, 0, 0};
+        size_t region[3] = {width, height, 1};
+        if (input)
+        {
+            check(clEnqueueWriteImage(queue, mem, blocking, origin, region, 0, 0, host->data(), 0, NULL, NULL), "clEnqueueWriteImage");
+        }
+        else
+        {
+            check(clEnqueueReadImage(queue, mem, blocking, origin, region, 0, 0, host->data(), 0, NULL, NULL), "clEnqueueReadImage");
+        }
+    };
+    if (input)
+    {
+        randomFill(host->data(), host->size());
+        transfer(CL_TRUE);
+        run.uploads.push_back([=]()
+                              { transfer(CL_FALSE); });
+    }
+    else
+    {
+        run.downloads.push_back([=]()
+                                { transfer(CL_FALSE); });
+    }
+    return mem;
+}
+
+// 池中分配的 NV21 Image（USE_HOST_PTR，两个平面是整帧上的子缓冲区），e2e 的传输即 map/unmap 同步
+static Image &nv21Image(BenchEnv &env, BenchRun &run, size_t width, size_t height, bool input)
+{
+    auto image = std::make_shared<Image>(Image::Format::NV21, width, height, env.pool);
+    run.objects.push_back(image);
+    run.transfer_bytes += nv21Bytes(width, height);
+
+    Image *raw = image.get();
+    cl_context context = env.context;
+    cl_command_queue queue = env.queue;
+    if (input)
+    {
+        randomFill(image->get_data(), image->get_size());
+        check(image->sync_to_device(context, queue), "sync_to_device");
+        run.uploads.push_back([=]()
+                              { check(raw->sync_to_device(context, queue), "sync_to_device"); });
+    }
+    else
+    {
+        run.downloads.push_back([=]()
+                                { check(raw->sync_to_host(context, queue), "sync_to_host"); });
+    }
+    return *image;
+}
+
+static cl_mem planeMem(BenchEnv &env, Image &image, size_t plane)
+{
+    cl_mem mem = image.get_planes()[plane]->to_cl_mem(env.context, env.queue);
+    if (mem == NULL)
+    {
+        throw std::runtime_error("Failed to create plane buffer");
+    }
+    return mem;
+}
+
+static int planeStep(Image &image)
+{
+    return static_cast<int>(image.get_planes()[0]->get_stride());
+}
+
+static void requireEven(size_t width, size_t height, size_t multiple)
+{
+    if (width % multiple || height % multiple)
+    {
+        throw std::invalid_argument("size must be a multiple of " + std::to_string(multiple));
+    }
+}
+
+// ---------------------------------------------------------------------------------------------
+// 用例
+// ---------------------------------------------------------------------------------------------
+
+// 两张 W/2 x H 的 NV21 左右拼接成 W x H
+static void setupComposeBuffer(BenchEnv &env, size_t width, size_t height, BenchRun &run)
+{
+    requireEven(width, height, 4);
+    int width1 = static_cast<int>(width / 2), width2 = width1, rows = static_cast<int>(height);
+    Image &in1 = nv21Image(env, run, width1, height, true);
+    Image &in2 = nv21Image(env, run, width2, height, true);
+    Image &out = nv21Image(env, run, width, height, false);
+    cl_kernel kernel = buildKernel(env, run, "compose_nv21_buffer.cl", "", "compose_nv21_buffer");
+    setArgs(kernel, planeMem(env, in1, 0), planeMem(env, in1, 1), planeStep(in1), planeMem(env, in2, 0), planeMem(env, in2, 1),
+            planeStep(in2), planeMem(env, out, 0), planeMem(env, out, 1), planeStep(out), width1, width2, rows);
+    run.bytes = 2 * nv21Bytes(width, height);
+    run.enqueue = [&env, kernel, width, height](std::vector<cl_event> &events)
+    { launch(env, kernel, width, height, events); };
+}
+
+// 同上，compose_nv21_plane 每个工作项 16 字节，Y、UV 各一次启动
+static void setupComposePlane(BenchEnv &env, size_t width, size_t height, BenchRun &run)
+{
+    requireEven(width, height, 4);
+    int width1 = static_cast<int>(width / 2), width2 = width1;
+    Image &in1 = nv21Image(env, run, width1, height, true);
+    Image &in2 = nv21Image(env, run, width2, height, true);
+    Image &out = nv21Image(env, run, width, height, false);
+    cl_kernel kernel = buildKernel(env, run, "compose_nv21_buffer.cl", "", "compose_nv21_plane");
+    cl_mem planes[2][3];
+    for (size_t p = 0; p < 2; ++p)
+    {
+        planes[p][0] = planeMem(env, in1, p);
+        planes[p][1] = planeMem(env, in2, p);
+        planes[p][2] = planeMem(env, out, p);
+    }
+    int steps[3] = {planeStep(in1), planeStep(in2), planeStep(out)};
+    run.bytes = 2 * nv21Bytes(width, height);
+    run.enqueue = [&env, kernel, planes, steps, width1, width2, width, height](std::vector<cl_event> &events)
+    {
+        const size_t vec = 16;
+        for (int p = 0; p < 2; ++p)
+        {
+            int rows = static_cast<int>(p == 0 ? height : height / 2);
+            setArgs(kernel, planes[p][0], steps[0], planes[p][1], steps[1], planes[p][2], steps[2], width1, width2, rows);
+            launch(env, kernel, (width + vec - 1) / vec, rows, events);
+        }
+    };
+}
+
+// compose_nv21_image2d.cl：Y 为 CL_R、UV 为 CL_RG 的 image2d，内核用 read_imageui，所以用 UNSIGNED_INT8
+static void setupComposeImage2d(BenchEnv &env, size_t width, size_t height, BenchRun &run)
+{
+    requireEven(width, height, 4);
+    int width1 = static_cast<int>(width / 2), width2 = width1, rows = static_cast<int>(height);
+    cl_mem in_y1 = deviceImage(env, run, CL_R, CL_UNSIGNED_INT8, width1, height, true);
+    cl_mem in_uv1 = deviceImage(env, run, CL_RG, CL_UNSIGNED_INT8, width1 / 2, height / 2, true);
+    cl_mem in_y2 = deviceImage(env, run, CL_R, CL_UNSIGNED_INT8, width2, height, true);
+    cl_mem in_uv2 = deviceImage(env, run, CL_RG, CL_UNSIGNED_INT8, width2 / 2, height / 2, true);
+    cl_mem out_y = deviceImage(env, run, CL_R, CL_UNSIGNED_INT8, width, height, false);
+    cl_mem out_uv = deviceImage(env, run, CL_RG, CL_UNSIGNED_INT8, width / 2, height / 2, false);
+    cl_kernel kernel = buildKernel(env, run, "compose_nv21_image2d.cl", "", "compose_nv21");
+    setArgs(kernel, in_y1, in_uv1, in_y2, in_uv2, out_y, out_uv, width1, width2, rows);
+    run.bytes = 2 * nv21Bytes(width, height);
+    run.enqueue = [&env, kernel, width, height](std::vector<cl_event> &events)
+    { launch(env, kernel, width, height, events); };
+}
+
+// 2x2 宫格，一次启动写完整张输出（MosaicCompose 内核路径）
+static void setupMosaic(BenchEnv &env, size_t width, size_t height, BenchRun &run)
+{
+    requireEven(width, height, 4);
+    auto mosaic = std::make_shared<MosaicCompose>(env.context, env.device, width, height,
+                                                  MosaicCompose::grid(2, 2, width / 2, height / 2), env.pool,
+                                                  ImageLayoutOptions(), LayoutBackend::KERNEL);
+    run.objects.push_back(mosaic);
+    MosaicCompose *raw = mosaic.get();
+    const auto &source = mosaic->get_source_buffer();
+    randomFill(source->get_data(), source->get_size());
+    check(mosaic->sync_sources_to_device(env.queue), "sync_sources_to_device");
+
+    cl_context context = env.context;
+    cl_command_queue queue = env.queue;
+    run.uploads.push_back([=]()
+                          { check(raw->sync_sources_to_device(queue), "sync_sources_to_device"); });
+    run.downloads.push_back([=]()
+                            { check(raw->get_output().sync_to_host(context, queue), "sync_to_host"); });
+    run.bytes = 2 * nv21Bytes(width, height);
+    run.transfer_bytes = run.bytes;
+    run.enqueue = [raw, queue](std::vector<cl_event> &events)
+    {
+        cl_event event;
+        check(raw->compose(queue, &event), "compose");
+        events.push_back(event);
+    };
+}
+
+// 3/4 宽的源画面分 4 块按 3,4,1,2 重排，四周及块间补黑边（TileRemap 内核路径）
+static void setupRemap(BenchEnv &env, size_t width, size_t height, BenchRun &run)
+{
+    requireEven(width, height, 4);
+    size_t side = width / 20 & ~size_t(1);
+    size_t block = (width - 5 * side) / 4 & ~size_t(1);
+    size_t top = height / 8 & ~size_t(1);
+    size_t src_width = block * 4, src_height = height - 2 * top;
+    Image &src = nv21Image(env, run, src_width, src_height, true);
+    Image &dst = nv21Image(env, run, width, height, false);
+    auto remap = std::make_shared<TileRemap>(env.context, env.device,
+                                             RemapLayout::block_permutation(src_width, src_height, {2, 3, 0, 1}, width, height),
+                                             LayoutBackend::KERNEL);
+    run.objects.push_back(remap);
+    TileRemap *raw = remap.get();
+    Image *src_raw = &src, *dst_raw = &dst;
+    cl_command_queue queue = env.queue;
+    run.bytes = nv21Bytes(src_width, src_height) + nv21Bytes(width, height);
+    run.enqueue = [raw, src_raw, dst_raw, queue](std::vector<cl_event> &events)
+    {
+        cl_event event;
+        check(raw->run(queue, *src_raw, *dst_raw, &event), "TileRemap::run");
+        events.push_back(event);
+    };
+}
+
+// resize_nv21.cl：Y / UV 为 UNORM image2d，采样器双线性，缩小一半
+static void setupResizeNv21(BenchEnv &env, size_t width, size_t height, BenchRun &run)
+{
+    requireEven(width, height, 4);
+    int src_w = static_cast<int>(width), src_h = static_cast<int>(height);
+    int dst_w = src_w / 2 & ~1, dst_h = src_h / 2 & ~1;
+    cl_mem in_y = deviceImage(env, run, CL_R, CL_UNORM_INT8, width, height, true);
+    cl_mem in_uv = deviceImage(env, run, CL_RG, CL_UNORM_INT8, width / 2, height / 2, true);
+    cl_mem out_y = deviceImage(env, run, CL_R, CL_UNORM_INT8, dst_w, dst_h, false);
+    cl_mem out_uv = deviceImage(env, run, CL_RG, CL_UNORM_INT8, dst_w / 2, dst_h / 2, false);
+    cl_kernel kernel = buildKernel(env, run, "resize_nv21.cl", "", "resize_nv21");
+    setArgs(kernel, in_y, in_uv, out_y, out_uv, src_w, src_h, dst_w, dst_h);
+    run.bytes = nv21Bytes(width, height) + nv21Bytes(dst_w, dst_h);
+    run.enqueue = [&env, kernel, dst_w, dst_h](std::vector<cl_event> &events)
+    { launch(env, kernel, dst_w, dst_h, events); };
+}
+
+// resize_nv21_bilinear_image2d.cl：内核用 read_imageui，所以用 UNSIGNED_INT8
+static void setupResizeNv21Bilinear(BenchEnv &env, size_t width, size_t height, BenchRun &run)
+{
+    requireEven(width, height, 4);
+    size_t dst_w = width / 2 & ~size_t(1), dst_h = height / 2 & ~size_t(1);
+    cl_mem in_y = deviceImage(env, run, CL_R, CL_UNSIGNED_INT8, width, height, true);
+    cl_mem in_uv = deviceImage(env, run, CL_RG, CL_UNSIGNED_INT8, width / 2, height / 2, true);
+    cl_mem out_y = deviceImage(env, run, CL_R, CL_UNSIGNED_INT8, dst_w, dst_h, false);
+    cl_mem out_uv = deviceImage(env, run, CL_RG, CL_UNSIGNED_INT8, dst_w / 2, dst_h / 2, false);
+    cl_kernel kernel = buildKernel(env, run, "resize_nv21_bilinear_image2d.cl", "", "resize_nv21_bilinear");
+    float scale_x = (float)width / dst_w, scale_y = (float)height / dst_h;
+    setArgs(kernel, in_y, in_uv, out_y, out_uv, scale_x, scale_y);
+    run.bytes = nv21Bytes(width, height) + nv21Bytes(dst_w, dst_h);
+    run.enqueue = [&env, kernel, dst_w, dst_h](std::vector<cl_event> &events)
+    { launch(env, kernel, dst_w, dst_h, events); };
+}
+
+// resize_nvx.cl 整数路径（Nv21Resizer::resize）：整帧紧密排列在一个缓冲区，亮度、色度各一次启动，缩小一半
+static void setupResizeNvxInteger(BenchEnv &env, size_t width, size_t height, BenchRun &run)
+{
+    requireEven(width, height, 4);
+    int src_w = static_cast<int>(width), src_h = static_cast<int>(height);
+    int dst_w = src_w / 2 & ~1, dst_h = src_h / 2 & ~1;
+    cl_mem in = deviceBuffer(env, run, nv21Bytes(width, height), true);
+    cl_mem out = deviceBuffer(env, run, nv21Bytes(dst_w, dst_h), false);
+    cl_kernel luma = buildKernel(env, run, "resize_nvx.cl", "", "resize_nvx_luma");
+    cl_kernel chroma = buildKernel(env, run, "resize_nvx.cl", "", "resize_nvx_chroma");
+    const int luma_vec = 4; // resize_nvx.cl 的 LUMA_VEC
+    for (int p = 0; p < 2; ++p)
+    {
+        int sw = src_w >> p, sh = src_h >> p, dw = dst_w >> p, dh = dst_h >> p;
+        int src_offset = p ? src_w * src_h : 0, dst_offset = p ? dst_w * dst_h : 0;
+        int scale_x = (sw << 16) / dw, scale_y = (sh << 16) / dh;
+        setArgs(p ? chroma : luma, in, src_w, src_offset, sw, sh, out, dst_w, dst_offset, dw, dh, scale_x, scale_y);
+    }
+    run.bytes = nv21Bytes(width, height) + nv21Bytes(dst_w, dst_h);
+    run.enqueue = [&env, luma, chroma, dst_w, dst_h](std::vector<cl_event> &events)
+    {
+        launch(env, luma, (dst_w + luma_vec - 1) / luma_vec, dst_h, events);
+        launch(env, chroma, dst_w / 2, dst_h / 2, events);
+    };
+}
+
+// resize_nvx.cl 采样器路径（Nv21Resizer::resize_image）：Y 为 CL_R、UV 为 CL_RG 的 UNORM image2d，每个平面一次启动
+static void setupResizeNvxSampler(BenchEnv &env, size_t width, size_t height, BenchRun &run)
+{
+    requireEven(width, height, 4);
+    size_t dst_w = width / 2 & ~size_t(1), dst_h = height / 2 & ~size_t(1);
+    cl_mem in_y = deviceImage(env, run, CL_R, CL_UNORM_INT8, width, height, true);
+    cl_mem in_uv = deviceImage(env, run, CL_RG, CL_UNORM_INT8, width / 2, height / 2, true);
+    cl_mem out_y = deviceImage(env, run, CL_R, CL_UNORM_INT8, dst_w, dst_h, false);
+    cl_mem out_uv = deviceImage(env, run, CL_RG, CL_UNORM_INT8, dst_w / 2, dst_h / 2, false);
+    cl_kernel kernel = buildKernel(env, run, "resize_nvx.cl", "", "resize_nvx_image");
+    float ifx = (float)width / dst_w, ify = (float)height / dst_h;
+    run.bytes = nv21Bytes(width, height) + nv21Bytes(dst_w, dst_h);
+    run.enqueue = [&env, kernel, in_y, in_uv, out_y, out_uv, ifx, ify, dst_w, dst_h](std::vector<cl_event> &events)
+    {
+        setArgs(kernel, in_y, out_y, ifx, ify);
+        launch(env, kernel, dst_w, dst_h, events);
+        setArgs(kernel, in_uv, out_uv, ifx, ify);
+        launch(env, kernel, dst_w / 2, dst_h / 2, events);
+    };
+}
+
+// resize_rgb_bilinear.cl：紧密排列的 RGB
+static void setupResizeRgb(BenchEnv &env, size_t width, size_t height, BenchRun &run)
+{
+    int src_w = static_cast<int>(width), src_h = static_cast<int>(height);
+    int dst_w = src_w / 2, dst_h = src_h / 2;
+    cl_mem in = deviceBuffer(env, run, width * height * 3, true);
+    cl_mem out = deviceBuffer(env, run, dst_w * dst_h * 3, false);
+    cl_kernel kernel = buildKernel(env, run, "resize_rgb_bilinear.cl", "", "resize_rgb_bilinear");
+    setArgs(kernel, in, out, src_w, src_h, dst_w, dst_h);
+    run.bytes = width * height * 3 + dst_w * dst_h * 3;
+    run.enqueue = [&env, kernel, dst_w, dst_h](std::vector<cl_event> &events)
+    { launch(env, kernel, dst_w, dst_h, events); };
+}
+
+// resize_rgb_bilinear.cl 的定点版本：channels 为 3（RGB）或 4（RGBA，与 image2d 版本的数据量相同），
+// 每个工作项 4 个像素
+static void setupResizeRgbFixed(BenchEnv &env, size_t width, size_t height, BenchRun &run, int channels)
+{
+    int src_w = static_cast<int>(width), src_h = static_cast<int>(height);
+    int dst_w = src_w / 2, dst_h = src_h / 2;
+    int src_step = src_w * channels, dst_step = dst_w * channels;
+    cl_mem in = deviceBuffer(env, run, (size_t)src_step * src_h, true);
+    cl_mem out = deviceBuffer(env, run, (size_t)dst_step * dst_h, false);
+    cl_kernel kernel = buildKernel(env, run, "resize_rgb_bilinear.cl", "-D CN=" + std::to_string(channels) + " -D PIX_PER_WI=4",
+                                   "resize_rgb_bilinear_fixed");
+    setArgs(kernel, in, src_step, out, dst_step, src_w, src_h, dst_w, dst_h);
+    run.bytes = (size_t)src_step * src_h + (size_t)dst_step * dst_h;
+    size_t global_x = (dst_w + 3) / 4;
+    run.enqueue = [&env, kernel, global_x, dst_h](std::vector<cl_event> &events)
+    { launch(env, kernel, global_x, dst_h, events); };
+}
+
+// resize_rgb_bilinear_image2d.cl：RGBA image2d
+static void setupResizeRgbImage2d(BenchEnv &env, size_t width, size_t height, BenchRun &run)
+{
+    size_t dst_w = width / 2, dst_h = height / 2;
+    cl_mem in = deviceImage(env, run, CL_RGBA, CL_UNORM_INT8, width, height, true);
+    cl_mem out = deviceImage(env, run, CL_RGBA, CL_UNORM_INT8, dst_w, dst_h, false);
+    cl_kernel kernel = buildKernel(env, run, "resize_rgb_bilinear_image2d.cl", "", "resize_rgb_bilinear");
+    float scale_x = (float)width / dst_w, scale_y = (float)height / dst_h;
+    setArgs(kernel, in, out, scale_x, scale_y);
+    run.bytes = (width * height + dst_w * dst_h) * 4;
+    run.enqueue = [&env, kernel, dst_w, dst_h](std::vector<cl_event> &events)
+    { launch(env, kernel, dst_w, dst_h, events); };
+}
+
+// resize.cl 的各个变体，8UC3
+#define RESIZE_RGB_OPTIONS "-D SRC_DEPTH=0 -D T=uchar3 -D T1=uchar -D CN=3"
+#define RESIZE_LINEAR_OPTIONS " -D WT=int3 -D CONVERT_TO_WT=convert_int3 -D CONVERT_TO_DT=convert_uchar3_sat -D INTER_RESIZE_COEF_BITS=11"
+
+enum class ResizeVariant
+{
+    LINEAR,
+    LINEAR_INTEGER,
+    LINEAR_TILED,
+    NEAREST,
+    AREA_FAST,
+    AREA
+};
+
+// divisor 为缩小倍数（resizeAREA 固定为 2/3）
+static void setupResizeCl(BenchEnv &env, size_t width, size_t height, BenchRun &run, ResizeVariant variant, int divisor)
+{
+    int src_w = static_cast<int>(width), src_h = static_cast<int>(height);
+    int dst_w = src_w / divisor, dst_h = src_h / divisor;
+    if (variant == ResizeVariant::AREA)
+    {
+        dst_w = src_w * 2 / 3, dst_h = src_h * 2 / 3;
+    }
+    int src_step = src_w * 3, dst_step = dst_w * 3, offset = 0;
+    float ifx = (float)src_w / dst_w, ify = (float)src_h / dst_h;
+    cl_mem in = deviceBuffer(env, run, width * height * 3, true);
+    cl_mem out = deviceBuffer(env, run, dst_w * dst_h * 3, false);
+    run.bytes = width * height * 3 + dst_w * dst_h * 3;
+
+    cl_kernel kernel = NULL;
+    switch (variant)
+    {
+    case ResizeVariant::LINEAR:
+        kernel = buildKernel(env, run, "resize.cl", RESIZE_RGB_OPTIONS " -D INTER_LINEAR" RESIZE_LINEAR_OPTIONS, "resizeLN");
+        setArgs(kernel, in, src_step, offset, src_h, src_w, out, dst_step, offset, dst_h, dst_w, ifx, ify);
+        break;
+    case ResizeVariant::LINEAR_INTEGER:
+    {
+        cl_mem table = env.tables->get(src_w, src_h, dst_w, dst_h, ResizeInterpolation::LINEAR).coeffs;
+        kernel = buildKernel(env, run, "resize.cl", RESIZE_RGB_OPTIONS " -D INTER_LINEAR_INTEGER" RESIZE_LINEAR_OPTIONS, "resizeLN");
+        setArgs(kernel, in, src_step, offset, src_h, src_w, out, dst_step, offset, dst_h, dst_w, table);
+        break;
+    }
+    case ResizeVariant::LINEAR_TILED:
+    {
+        // 工作组尺寸由 reqd_work_group_size 固定，直接启动
+        if (!Resizer::tiled_fits(src_w, dst_w, 3))
+        {
+            throw std::invalid_argument("scale too large for resizeLN_tiled");
+        }
+        cl_mem table = env.tables->get(src_w, src_h, dst_w, dst_h, ResizeInterpolation::LINEAR).coeffs;
+        kernel = buildKernel(env, run, "resize.cl", Resizer::build_options(ResizeKernel::LN_TILED, 3, src_w, src_h, dst_w, dst_h),
+                             "resizeLN_tiled");
+        setArgs(kernel, in, src_step, offset, src_h, src_w, out, dst_step, offset, dst_h, dst_w, table);
+        size_t local[2] = {Resizer::TILE_W, Resizer::TILE_H};
+        size_t global[2] = {(size_t)(dst_w + Resizer::TILE_W - 1) / Resizer::TILE_W * Resizer::TILE_W,
+                            (size_t)(dst_h + Resizer::TILE_H - 1) / Resizer::TILE_H * Resizer::TILE_H};
+        run.enqueue = [&env, kernel, local, global](std::vector<cl_event> &events)
+        {
+            cl_event event;
+            check(clEnqueueNDRangeKernel(env.queue, kernel, 2, NULL, global, local, 0, NULL, &event), "clEnqueueNDRangeKernel");
+            events.push_back(event);
+        };
+        return;
+    }
+    case ResizeVariant::NEAREST:
+        kernel = buildKernel(env, run, "resize.cl", RESIZE_RGB_OPTIONS " -D INTER_NEAREST", "resizeNN");
+        setArgs(kernel, in, src_step, offset, src_h, src_w, out, dst_step, offset, dst_h, dst_w, ifx, ify);
+        break;
+    case ResizeVariant::AREA_FAST:
+        kernel = buildKernel(env, run, "resize.cl",
+                             RESIZE_RGB_OPTIONS " -D INTER_AREA -D INTER_AREA_FAST -D XSCALE=2 -D YSCALE=2 -D SCALE=0.25f"
+                                                " -D WTV=int3 -D CONVERT_TO_WTV=convert_int3 -D WT2V=float3"
+                                                " -D CONVERT_TO_WT2V=convert_float3 -D CONVERT_TO_T=convert_uchar3_sat_rte",
+                             "resizeAREA_FAST");
+        setArgs(kernel, in, src_step, offset, src_h, src_w, out, dst_step, offset, dst_h, dst_w);
+        break;
+    case ResizeVariant::AREA:
+    {
+        ResizeTables tables = env.tables->get(src_w, src_h, dst_w, dst_h, ResizeInterpolation::AREA);
+        kernel = buildKernel(env, run, "resize.cl",
+                             RESIZE_RGB_OPTIONS " -D INTER_AREA -D WTV=float3 -D CONVERT_TO_WTV=convert_float3"
+                                                " -D CONVERT_TO_T=convert_uchar3_sat_rte",
+                             "resizeAREA");
+        setArgs(kernel, in, src_step, offset, src_h, src_w, out, dst_step, offset, dst_h, dst_w, ifx, ify, tables.ofs, tables.map, tables.alpha);
+        run.objects.push_back(std::make_shared<ResizeTables>(std::move(tables))); // 每次迭代都会提交，表随用例一起释放
+        break;
+    }
+    }
+    run.enqueue = [&env, kernel, dst_w, dst_h](std::vector<cl_event> &events)
+    { launch(env, kernel, dst_w, dst_h, events); };
+}
+
+// resize.cl 的 resizeSampler：单通道 image2d 输入（Y 平面），输出到缓冲区
+static void setupResizeSampler(BenchEnv &env, size_t width, size_t height, BenchRun &run)
+{
+    int dst_w = static_cast<int>(width / 2), dst_h = static_cast<int>(height / 2), offset = 0;
+    float ifx = (float)width / dst_w, ify = (float)height / dst_h;
+    cl_mem in = deviceImage(env, run, CL_R, CL_UNORM_INT8, width, height, true);
+    cl_mem out = deviceBuffer(env, run, dst_w * dst_h, false);
+    cl_kernel kernel = buildKernel(env, run, "resize.cl",
+                                   "-D USE_SAMPLER -D SRC_DEPTH=0 -D T=uchar -D T1=uchar -D CONVERT_TO_DT=convert_uchar_sat -D CN=1",
+                                   "resizeSampler");
+    setArgs(kernel, in, out, dst_w, offset, dst_h, dst_w, ifx, ify);
+    run.bytes = width * height + dst_w * dst_h;
+    run.enqueue = [&env, kernel, dst_w, dst_h](std::vector<cl_event> &events)
+    { launch(env, kernel, dst_w, dst_h, events); };
+}
+
+// color_yuv.cl 中 (src, src_step, src_offset, dst, dst_step, dst_offset, rows, cols) 形式的转换内核。
+// 尺寸都以 W x H 画面为单位：*_step_per_px 为每像素行距，*_rows_x2 为行数的两倍（YUV420 为 3），
+// 内核的 rows / cols 参数与 OpenCV 一致取输出的尺寸；px_per_item_x / y 为每个工作项覆盖的像素数
+struct ColorCase
+{
+    const char *kernel;
+    const char *options;
+    int src_step_per_px, src_rows_x2;
+    int dst_step_per_px, dst_rows_x2;
+    int px_per_item_x, px_per_item_y;
+};
+
+#define COLOR_OPTIONS "-D SRC_DEPTH=0 -D BIDX=2"
+
+static void setupColor(BenchEnv &env, size_t width, size_t height, BenchRun &run, const ColorCase &c)
+{
+    requireEven(width, height, 2);
+    int cols = static_cast<int>(width), offset = 0;
+    int src_step = cols * c.src_step_per_px, dst_step = cols * c.dst_step_per_px;
+    size_t src_size = (size_t)src_step * height * c.src_rows_x2 / 2;
+    size_t dst_size = (size_t)dst_step * height * c.dst_rows_x2 / 2;
+    int rows = static_cast<int>(height * c.dst_rows_x2 / 2);
+    cl_mem in = deviceBuffer(env, run, src_size, true);
+    cl_mem out = deviceBuffer(env, run, dst_size, false);
+    // 每个工作项处理 1、2、4 行各编译一份，计时的是调优器选中的那一份
+    std::vector<KernelVariant> variants;
+    for (int pix_per_wi : {1, 2, 4})
+    {
+        std::string options = "-D PIX_PER_WI_Y=" + std::to_string(pix_per_wi) + " " COLOR_OPTIONS " " + c.options;
+        cl_kernel kernel = buildKernel(env, run, "color_yuv.cl", options, c.kernel);
+        setArgs(kernel, in, src_step, offset, out, dst_step, offset, rows, cols);
+        variants.push_back({pix_per_wi, kernel});
+    }
+    run.bytes = src_size + dst_size;
+    size_t global_x = width / c.px_per_item_x, global_y = height / c.px_per_item_y;
+    run.enqueue = [&env, variants, global_x, global_y](std::vector<cl_event> &events)
+    { launchVariants(env, variants, global_x, global_y, events); };
+}
+
+// NV21 直接缩小一半输出 RGB（YUV2RGB_NVx_resizeLN，与 main.c 相同的调用方式）
+static void setupColorResize(BenchEnv &env, size_t width, size_t height, BenchRun &run)
+{
+    requireEven(width, height, 2);
+    int src_w = static_cast<int>(width), src_h = static_cast<int>(height);
+    int dst_w = src_w / 2, dst_h = src_h / 2, offset = 0, dst_step = dst_w * 3;
+    cl_mem in = deviceBuffer(env, run, nv21Bytes(width, height), true);
+    cl_mem out = deviceBuffer(env, run, (size_t)dst_step * dst_h, false);
+    cl_mem table = env.tables->get(src_w, src_h, dst_w, dst_h, ResizeInterpolation::LINEAR).coeffs;
+    cl_kernel kernel = buildKernel(env, run, "color_yuv.cl", "-D PIX_PER_WI_Y=1 " COLOR_OPTIONS " -D SCN=1 -D DCN=3 -D UIDX=1", "YUV2RGB_NVx_resizeLN");
+    setArgs(kernel, in, src_w, offset, src_h, src_w, out, dst_step, offset, dst_h, dst_w, table);
+    run.bytes = nv21Bytes(width, height) + (size_t)dst_step * dst_h;
+    run.enqueue = [&env, kernel, dst_w, dst_h](std::vector<cl_event> &events)
+    { launch(env, kernel, dst_w, dst_h, events); };
+}
+
+static std::vector<BenchCase> registerCases()
+{
+    using namespace std::placeholders;
+    std::vector<BenchCase> cases = {
+        {"compose.nv21_buffer", "compose_nv21_buffer.cl", false, setupComposeBuffer},
+        {"compose.nv21_plane", "compose_nv21_buffer.cl", false, setupComposePlane},
+        {"compose.nv21_image2d", "compose_nv21_image2d.cl", true, setupComposeImage2d},
+        {"compose.mosaic_2x2", "compose_mosaic.cl", false, setupMosaic},
+        {"remap.block_permutation", "rearrange.cl", false, setupRemap},
+        {"resize.nv21_image2d", "resize_nv21.cl", true, setupResizeNv21},
+        {"resize.nv21_bilinear_image2d", "resize_nv21_bilinear_image2d.cl", true, setupResizeNv21Bilinear},
+        {"resize.nvx_integer", "resize_nvx.cl", false, setupResizeNvxInteger},
+        {"resize.nvx_sampler", "resize_nvx.cl", true, setupResizeNvxSampler},
+        {"resize.rgb_bilinear", "resize_rgb_bilinear.cl", false, setupResizeRgb},
+        {"resize.rgb_bilinear_image2d", "resize_rgb_bilinear_image2d.cl", true, setupResizeRgbImage2d},
+        {"resize.rgb_bilinear_fixed", "resize_rgb_bilinear.cl", false, std::bind(setupResizeRgbFixed, _1, _2, _3, _4, 3)},
+        {"resize.rgba_bilinear_fixed", "resize_rgb_bilinear.cl", false, std::bind(setupResizeRgbFixed, _1, _2, _3, _4, 4)},
+        {"resize.LN", "resize.cl", false, std::bind(setupResizeCl, _1, _2, _3, _4, ResizeVariant::LINEAR, 2)},
+        {"resize.LN_integer", "resize.cl", false, std::bind(setupResizeCl, _1, _2, _3, _4, ResizeVariant::LINEAR_INTEGER, 2)},
+        {"resize.LN_tiled", "resize.cl", false, std::bind(setupResizeCl, _1, _2, _3, _4, ResizeVariant::LINEAR_TILED, 2)},
+        {"resize.LN_integer_x4", "resize.cl", false, std::bind(setupResizeCl, _1, _2, _3, _4, ResizeVariant::LINEAR_INTEGER, 4)},
+        {"resize.LN_tiled_x4", "resize.cl", false, std::bind(setupResizeCl, _1, _2, _3, _4, ResizeVariant::LINEAR_TILED, 4)},
+        {"resize.NN", "resize.cl", false, std::bind(setupResizeCl, _1, _2, _3, _4, ResizeVariant::NEAREST, 2)},
+        {"resize.AREA_FAST", "resize.cl", false, std::bind(setupResizeCl, _1, _2, _3, _4, ResizeVariant::AREA_FAST, 2)},
+        {"resize.AREA", "resize.cl", false, std::bind(setupResizeCl, _1, _2, _3, _4, ResizeVariant::AREA, 2)},
+        {"resize.sampler", "resize.cl", true, setupResizeSampler},
+        {"color.YUV2RGB_NVx_resizeLN", "color_yuv.cl", false, setupColorResize},
+    };
+
+    // color_yuv.cl 的其余转换内核；三通道输入用 vload4 读取时会越过最后一个像素，由 BUFFER_SLACK 兜底
+    const ColorCase colors[] = {
+        {"YUV2RGB_NVx", "-D SCN=1 -D DCN=3 -D UIDX=1", 1, 3, 3, 2, 2, 2},
+        {"YUV2RGB_YV12_IYUV", "-D SCN=1 -D DCN=3 -D UIDX=0 -D SRC_CONT", 1, 3, 3, 2, 2, 2},
+        {"RGB2YUV_YV12_IYUV", "-D SCN=3 -D DCN=1 -D UIDX=0", 3, 2, 1, 3, 2, 2},
+        {"RGB2YUV", "-D SCN=3 -D DCN=3", 3, 2, 3, 2, 1, 1},
+        {"YUV2RGB", "-D SCN=3 -D DCN=3", 3, 2, 3, 2, 1, 1},
+        {"YUV2RGB_422", "-D SCN=2 -D DCN=3 -D UIDX=1 -D YIDX=0", 2, 2, 3, 2, 2, 1},
+        {"RGB2YUV_422", "-D SCN=3 -D DCN=2 -D UIDX=1 -D YIDX=0", 3, 2, 2, 2, 2, 1},
+        {"RGB2YCrCb", "-D SCN=3 -D DCN=3", 3, 2, 3, 2, 1, 1},
+        {"YCrCb2RGB", "-D SCN=3 -D DCN=3", 3, 2, 3, 2, 1, 1},
+    };
+    for (const ColorCase &c : colors)
+    {
+        cases.push_back({std::string("color.") + c.kernel, "color_yuv.cl", false,
+                         [c](BenchEnv &env, size_t width, size_t height, BenchRun &run)
+                         { setupColor(env, width, height, run, c); }});
+    }
+    return cases;
+}
+
+// ---------------------------------------------------------------------------------------------
+// 计时与统计
+// ---------------------------------------------------------------------------------------------
+
+static double eventDuration(cl_event event)
+{
+    cl_ulong start, end;
+    check(clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_START, sizeof(start), &start, NULL), "clGetEventProfilingInfo");
+    check(clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END, sizeof(end), &end, NULL), "clGetEventProfilingInfo");
+    return static_cast<double>(end - start);
+}
+
+static void releaseEvents(std::vector<cl_event> &events)
+{
+    for (cl_event event : events)
+    {
+        clReleaseEvent(event);
+    }
+    events.clear();
+}
+
+// 每次迭代的内核时间（纳秒）：全部迭代连续提交，最后统一等待再读 profiling 信息
+static std::vector<double> measureKernel(BenchEnv &env, BenchRun &run, int runs)
+{
+    std::vector<cl_event> events;
+    std::vector<size_t> marks;
+    for (int i = 0; i < runs; ++i)
+    {
+        marks.push_back(events.size());
+        run.enqueue(events);
+    }
+    marks.push_back(events.size());
+    check(clFinish(env.queue), "clFinish");
+
+    std::vector<double> samples;
+    for (int i = 0; i < runs; ++i)
+    {
+        double ns = 0;
+        for (size_t e = marks[i]; e < marks[i + 1]; ++e)
+        {
+            ns += eventDuration(events[e]);
+        }
+        samples.push_back(ns);
+    }
+    releaseEvents(events);
+    return samples;
+}
+
+// 每次迭代的端到端墙钟时间（纳秒）：上传、内核、下载，等待全部完成
+static std::vector<double> measureEndToEnd(BenchEnv &env, BenchRun &run, int runs)
+{
+    std::vector<cl_event> events;
+    std::vector<double> samples;
+    for (int i = 0; i < runs; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (auto &upload : run.uploads)
+        {
+            upload();
+        }
+        run.enqueue(events);
+        for (auto &download : run.downloads)
+        {
+            download();
+        }
+        check(clFinish(env.queue), "clFinish");
+        samples.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+        releaseEvents(events);
+    }
+    return samples;
+}
+
+// 最近秩百分位
+static double percentile(const std::vector<double> &sorted, double p)
+{
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+}
+
+static Stats summarize(std::vector<double> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double s : samples)
+    {
+        sum += s;
+    }
+    return {samples.front() / 1e6, sum / samples.size() / 1e6, percentile(samples, 50) / 1e6,
+            percentile(samples, 90) / 1e6, percentile(samples, 99) / 1e6, samples.back() / 1e6};
+}
+
+// ---------------------------------------------------------------------------------------------
+// 输出
+// ---------------------------------------------------------------------------------------------
+
+static std::string jsonString(const std::string &s)
+{
+    std::string out = "\"";
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+        }
+        if (static_cast<unsigned char>(c) >= 0x20)
+        {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+static std::string jsonStats(const Stats &s)
+{
+    std::ostringstream out;
+    out << "{\"min\": " << s.min << ", \"mean\": " << s.mean << ", \"p50\": " << s.p50 << ", \"p90\": " << s.p90
+        << ", \"p99\": " << s.p99 << ", \"max\": " << s.max << "}";
+    return out.str();
+}
+
+static std::string deviceString(cl_device_id device, cl_device_info param)
+{
+    char value[256] = {0};
+    clGetDeviceInfo(device, param, sizeof(value) - 1, value, NULL);
+    return value;
+}
+
+static void usage()
+{
+    std::cout << "Usage: bench [--device gpu|cpu|all] [--size WxH]... [--runs N] [--warmup N] [--filter NAME] [--json FILE] [--list]"
+              << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    cl_device_type device_type = CL_DEVICE_TYPE_GPU;
+    std::vector<std::pair<size_t, size_t>> sizes;
+    int runs = 100;
+    int warmup = 10;
+    std::string filter;
+    std::string json_path = "bench.json";
+    bool list = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--device" && has_value)
+        {
+            std::string type = argv[++i];
+            device_type = type == "cpu" ? CL_DEVICE_TYPE_CPU : type == "all" ? CL_DEVICE_TYPE_ALL : CL_DEVICE_TYPE_GPU;
+        }
+        else if (arg == "--size" && has_value)
+        {
+            size_t width = 0, height = 0;
+            if (sscanf(argv[++i], "%zux%zu", &width, &height) != 2 || width == 0 || height == 0)
+            {
+                usage();
+                return 1;
+            }
+            sizes.push_back({width, height});
+        }
+        else if (arg == "--runs" && has_value)
+        {
+            runs = std::max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--warmup" && has_value)
+        {
+            warmup = std::max(0, atoi(argv[++i]));
+        }
+        else if (arg == "--filter" && has_value)
+        {
+            filter = argv[++i];
+        }
+        else if (arg == "--json" && has_value)
+        {
+            json_path = argv[++i];
+        }
+        else if (arg == "--list")
+        {
+            list = true;
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+    if (sizes.empty())
+    {
+        sizes = {{1920, 1080}, {3840, 2160}};
+    }
+
+    std::vector<BenchCase> cases = registerCases();
+    if (list)
+    {
+        for (const auto &c : cases)
+        {
+            std::cout << c.name << "  (" << c.source << ")" << std::endl;
+        }
+        return 0;
+    }
+
+    // 在所有平台中找第一个指定类型的设备（POCL 通常是单独的平台）
+    cl_uint num_platforms = 0;
+    cl_int err = clGetPlatformIDs(0, NULL, &num_platforms);
+    if (err != CL_SUCCESS || num_platforms == 0)
+    {
+        std::cerr << "No OpenCL platform found (" << err << ")" << std::endl;
+        return 1;
+    }
+    std::vector<cl_platform_id> platforms(num_platforms);
+    clGetPlatformIDs(num_platforms, platforms.data(), NULL);
+    cl_device_id device = NULL;
+    for (cl_platform_id platform : platforms)
+    {
+        if (clGetDeviceIDs(platform, device_type, 1, &device, NULL) == CL_SUCCESS)
+        {
+            break;
+        }
+        device = NULL;
+    }
+    if (device == NULL)
+    {
+        std::cerr << "No OpenCL device of the requested type" << std::endl;
+        return 1;
+    }
+
+    BenchEnv env;
+    env.device = device;
+    env.context = clCreateContext(NULL, 1, &device, NULL, NULL, &err);
+    if (err != CL_SUCCESS)
+    {
+        std::cerr << "clCreateContext failed: " << err << std::endl;
+        return 1;
+    }
+    env.tables = std::make_unique<ResizeTableCache>(env.context);
+    cl_queue_properties properties[] = {CL_QUEUE_PROPERTIES, CL_QUEUE_PROFILING_ENABLE, 0};
+    env.queue = clCreateCommandQueueWithProperties(env.context, device, properties, &err);
+    if (err != CL_SUCCESS)
+    {
+        std::cerr << "clCreateCommandQueueWithProperties failed: " << err << std::endl;
+        return 1;
+    }
+    cl_bool image_support = CL_FALSE;
+    clGetDeviceInfo(device, CL_DEVICE_IMAGE_SUPPORT, sizeof(image_support), &image_support, NULL);
+    env.image_support = image_support == CL_TRUE;
+
+    std::string device_name = deviceString(device, CL_DEVICE_NAME);
+    std::cout << "Device: " << device_name << " (" << deviceString(device, CL_DRIVER_VERSION) << ")" << std::endl;
+    std::cout << "Runs: " << runs << ", warmup: " << warmup << "; times in ms, GB/s at p50" << std::endl;
+    printf("%-30s %11s  %8s %8s %8s %8s  %8s %8s %8s\n", "case", "size", "k.p50", "k.p90", "k.p99", "k.GB/s",
+           "e2e.p50", "e2e.p99", "e2e.GB/s");
+
+    std::ostringstream results;
+    bool first = true;
+    for (const auto &size : sizes)
+    {
+        for (const auto &c : cases)
+        {
+            if (!filter.empty() && c.name.find(filter) == std::string::npos)
+            {
+                continue;
+            }
+            std::ostringstream result;
+            result << "{\"case\": " << jsonString(c.name) << ", \"source\": " << jsonString(c.source)
+                   << ", \"width\": " << size.first << ", \"height\": " << size.second;
+            char label[32];
+            snprintf(label, sizeof(label), "%zux%zu", size.first, size.second);
+            try
+            {
+                if (c.needs_images && !env.image_support)
+                {
+                    throw std::invalid_argument("device has no image support");
+                }
+                BenchRun run;
+                c.setup(env, size.first, size.second, run);
+                for (int i = 0; i < warmup; ++i)
+                {
+                    std::vector<cl_event> events;
+                    run.enqueue(events);
+                    check(clFinish(env.queue), "clFinish");
+                    releaseEvents(events);
+                }
+                Stats kernel = summarize(measureKernel(env, run, runs));
+                measureEndToEnd(env, run, std::min(warmup, runs));
+                Stats e2e = summarize(measureEndToEnd(env, run, runs));
+                double kernel_gbps = run.bytes / (kernel.p50 * 1e6);
+                double e2e_gbps = run.transfer_bytes / (e2e.p50 * 1e6);
+
+                printf("%-30s %11s  %8.3f %8.3f %8.3f %8.2f  %8.3f %8.3f %8.2f\n", c.name.c_str(), label, kernel.p50,
+                       kernel.p90, kernel.p99, kernel_gbps, e2e.p50, e2e.p99, e2e_gbps);
+                result << ", \"bytes\": " << run.bytes << ", \"transfer_bytes\": " << run.transfer_bytes
+                       << ", \"kernel_ms\": " << jsonStats(kernel) << ", \"kernel_gbps\": " << kernel_gbps
+                       << ", \"e2e_ms\": " << jsonStats(e2e) << ", \"e2e_gbps\": " << e2e_gbps << "}";
+            }
+            catch (const std::exception &e)
+            {
+                // 单个用例失败（设备不支持、尺寸不合法、编译失败）不影响其余用例
+                printf("%-30s %11s  skipped: %s\n", c.name.c_str(), label, e.what());
+                clFinish(env.queue);
+                result << ", \"skipped\": " << jsonString(e.what()) << "}";
+            }
+            results << (first ? "\n    " : ",\n    ") << result.str();
+            first = false;
+        }
+    }
+
+    std::ofstream json(json_path);
+    json << "{\n  \"device\": " << jsonString(device_name) << ",\n  \"driver\": "
+         << jsonString(deviceString(device, CL_DRIVER_VERSION)) << ",\n  \"runs\": " << runs
+         << ",\n  \"warmup\": " << warmup << ",\n  \"results\": [" << results.str() << "\n  ]\n}\n";
+    if (!json)
+    {
+        std::cerr << "Failed to write " << json_path << std::endl;
+        return 1;
+    }
+    std::cout << "Results written to " << json_path << std::endl;
+
+    for (auto &program : env.programs)
+    {
+        clReleaseProgram(program.second);
+    }
+    env.tables.reset();
+    clReleaseCommandQueue(env.queue);
+    clReleaseContext(env.context);
+    return 0;
+}
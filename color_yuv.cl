@@ -319,6 +319,71 @@ __kernel void YUV2RGB_NVx(__global const uchar* srcptr, int src_step, int src_of
     }
 }
 
+// 按 YUV2RGB_NVx 的系数转换 (x, y) 处的单个像素，分量顺序与 dst 一致
+inline int3 NVx2RGB_pix(__global const uchar* srcptr, int src_step, int src_offset, int rows, int x, int y)
+{
+    __global const uchar* usrc = srcptr + mad24(rows + (y >> 1), src_step, (x & ~1) + src_offset);
+
+    float Y = srcptr[mad24(y, src_step, x + src_offset)];
+    float U = ((float)usrc[UIDX]) - HALF_MAX_NUM;
+    float V = ((float)usrc[1-UIDX]) - HALF_MAX_NUM;
+
+    __constant float* coeffs = c_YUV2RGBCoeffs_420;
+    float ruv = fma(coeffs[4], V, 0.5f);
+    float guv = fma(coeffs[3], V, fma(coeffs[2], U, 0.5f));
+    float buv = fma(coeffs[1], U, 0.5f);
+
+    Y = max(0.f, Y - 16.f) * coeffs[0];
+    int r = convert_uchar_sat(Y + ruv);
+    int g = convert_uchar_sat(Y + guv);
+    int b = convert_uchar_sat(Y + buv);
+#if BIDX == 0
+    return (int3)(b, g, r);
+#else
+    return (int3)(r, g, b);
+#endif
+}
+
+// NVx -> RGB 与 resizeLN (INTER_LINEAR_INTEGER) 融合：只在目标网格的采样点上做颜色转换，
+// 不产生全分辨率的 RGB 中间图。buffer 与 resizeLN 使用同一张插值表
+// (xofs[dst_cols], yofs[dst_rows], ialpha[dst_cols * 2], ibeta[dst_rows * 2])，结果与两步执行逐位一致
+__kernel void YUV2RGB_NVx_resizeLN(__global const uchar* srcptr, int src_step, int src_offset, int src_rows, int src_cols,
+                                   __global uchar* dstptr, int dst_step, int dt_offset, int dst_rows, int dst_cols,
+                                   __global const uchar* buffer)
+{
+    int dx = get_global_id(0);
+    int dy = get_global_id(1);
+
+    if (dx < dst_cols && dy < dst_rows)
+    {
+        __global const int * xofs = (__global const int *)(buffer), * yofs = xofs + dst_cols;
+        __global const short * ialpha = (__global const short *)(yofs + dst_rows);
+        __global const short * ibeta = ialpha + ((dst_cols + dy) << 1);
+        ialpha += dx << 1;
+
+        int sx0 = xofs[dx], sx1 = min(sx0 + 1, src_cols - 1);
+        int sy0 = clamp(yofs[dy], 0, src_rows - 1), sy1 = clamp(yofs[dy] + 1, 0, src_rows - 1);
+        int a0 = ialpha[0], a1 = ialpha[1];
+        int b0 = ibeta[0], b1 = ibeta[1];
+
+        int3 data0 = NVx2RGB_pix(srcptr, src_step, src_offset, src_rows, sx0, sy0);
+        int3 data1 = NVx2RGB_pix(srcptr, src_step, src_offset, src_rows, sx1, sy0);
+        int3 data2 = NVx2RGB_pix(srcptr, src_step, src_offset, src_rows, sx0, sy1);
+        int3 data3 = NVx2RGB_pix(srcptr, src_step, src_offset, src_rows, sx1, sy1);
+
+        int3 val = ( (((data0 * a0 + data1 * a1) >> 4) * b0) >> 16) +
+                   ( (((data2 * a0 + data3 * a1) >> 4) * b1) >> 16);
+        uchar3 pix = convert_uchar3_sat((val + 2) >> 2);
+
+        __global uchar* dst = dstptr + mad24(dy, dst_step, mad24(dx, DCN, dt_offset));
+#if DCN == 4
+        vstore4((uchar4)(pix, 255), 0, dst);
+#else
+        vstore3(pix, 0, dst);
+#endif
+    }
+}
+
 #if UIDX < 2
 
 __kernel void YUV2RGB_YV12_IYUV(__global const uchar* srcptr, int src_step, int src_offset,
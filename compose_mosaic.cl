@@ -0,0 +1,68 @@
+// N 路 NV21 画面拼接（多画面墙），一次启动写完整张输出。
+//
+// 所有输入画面放在同一个源缓冲区中，每路的位置由 tile 描述表给出，描述表放在常量内存里。
+// NDRange 为三维：
+//   x = 行内第几段（每段 COMPOSE_VEC 字节）
+//   y = 行号：[0, height) 为 Y 平面的行，[height, height * 3 / 2) 为交错 UV 平面的行
+//   z = tile 序号
+// 全局 y 按最高的 tile 取，矮的 tile 多出的工作项直接返回
+
+#ifndef COMPOSE_VEC
+#define COMPOSE_VEC 16
+#endif
+
+#if COMPOSE_VEC == 8
+#define VLOAD vload8
+#define VSTORE vstore8
+#else
+#define VLOAD vload16
+#define VSTORE vstore16
+#endif
+
+// 与主机端 MosaicTileDesc 一一对应，全部为 int，没有填充
+typedef struct
+{
+    int src_y_offset;  // Y 平面在源缓冲区中的偏移（字节）
+    int src_uv_offset; // UV 平面在源缓冲区中的偏移（字节）
+    int src_step;      // 源行距（Y 与 UV 相同）
+    int width;         // tile 宽度（偶数）
+    int height;        // tile 高度（偶数）
+    int dst_x;         // 在输出中的左上角（偶数）
+    int dst_y;
+    int reserved;
+} mosaic_tile;
+
+__kernel void compose_mosaic(
+    __global const uchar* src,         // 所有输入画面所在的源缓冲区
+    __global uchar* dst_y,             // 输出 Y 平面
+    __global uchar* dst_uv,            // 输出 UV 平面
+    int dst_step,                      // 输出行距（Y 与 UV 相同）
+    __constant mosaic_tile* tiles      // tile 描述表
+)
+{
+    int x = get_global_id(0) * COMPOSE_VEC;
+    int row = get_global_id(1);
+    __constant mosaic_tile* tile = &tiles[get_global_id(2)];
+
+    if (x >= tile->width || row >= tile->height * 3 / 2) return;
+
+    __global const uchar* in;
+    __global uchar* out;
+    if (row < tile->height) {
+        in = src + tile->src_y_offset + row * tile->src_step;
+        out = dst_y + (tile->dst_y + row) * dst_step + tile->dst_x;
+    } else {
+        int uv_row = row - tile->height;
+        in = src + tile->src_uv_offset + uv_row * tile->src_step;
+        out = dst_uv + (tile->dst_y / 2 + uv_row) * dst_step + tile->dst_x;
+    }
+
+    if (x + COMPOSE_VEC <= tile->width) {
+        VSTORE(VLOAD(0, in + x), 0, out + x);
+    } else {
+        // 行尾不足一段：逐字节处理
+        for (int i = x; i < tile->width; i++) {
+            out[i] = in[i];
+        }
+    }
+}
@@ -1,10 +1,15 @@
+// 两张 NV21 图像左右拼接。每张图像的 Y 和 UV 平面行距相同，由 *_step（字节）给出，
+// 行距可以大于宽度（行对齐或相机驱动输出的带 padding 的帧）
 __kernel void compose_nv21_buffer(
     __global const uchar* input_y1,  // 第一张图像的 Y 通道
     __global const uchar* input_uv1, // 第一张图像的 UV 通道
+    int src1_step,                   // 第一张图像的行距
     __global const uchar* input_y2,  // 第二张图像的 Y 通道
     __global const uchar* input_uv2, // 第二张图像的 UV 通道
+    int src2_step,                   // 第二张图像的行距
     __global uchar* output_y,        // 输出 Y 通道
     __global uchar* output_uv,       // 输出 UV 通道
+    int dst_step,                    // 输出图像的行距
     int width1,                      // 第一张图像的宽度
     int width2,                      // 第二张图像的宽度
     int height                       // 图像高度
@@ -13,18 +18,16 @@ __kernel void compose_nv21_buffer(
     int x = get_global_id(0); // 输出图像的 x 坐标
     int y = get_global_id(1); // 输出图像的 y 坐标
 
-    int output_width = width1 + width2; // 输出图像的宽度
-
-    // 确保 y 坐标在图像高度范围内
-    if (y >= height) return;
+    // 确保坐标在图像范围内
+    if (x >= width1 + width2 || y >= height) return;
 
     // 处理 Y 通道
     if (x < width1) {
         // 从第一张图像读取 Y 通道
-        output_y[y * output_width + x] = input_y1[y * width1 + x];
+        output_y[y * dst_step + x] = input_y1[y * src1_step + x];
     } else {
         // 从第二张图像读取 Y 通道
-        output_y[y * output_width + x] = input_y2[y * width2 + (x - width1)];
+        output_y[y * dst_step + x] = input_y2[y * src2_step + (x - width1)];
     }
 
     // 处理 UV 通道（UV 通道的宽度是 Y 通道的一半）
@@ -32,16 +35,66 @@ __kernel void compose_nv21_buffer(
         int uv_x = x / 2;
         int uv_y = y / 2;
 
-        int output_uv_width = output_width / 2;
-
         if (uv_x < width1 / 2) {
             // 从第一张图像读取 UV 通道
-            output_uv[uv_y * output_uv_width * 2 + uv_x * 2] = input_uv1[uv_y * width1 + uv_x * 2];     // U
-            output_uv[uv_y * output_uv_width * 2 + uv_x * 2 + 1] = input_uv1[uv_y * width1 + uv_x * 2 + 1]; // V
+            output_uv[uv_y * dst_step + uv_x * 2] = input_uv1[uv_y * src1_step + uv_x * 2];         // U
+            output_uv[uv_y * dst_step + uv_x * 2 + 1] = input_uv1[uv_y * src1_step + uv_x * 2 + 1]; // V
         } else {
             // 从第二张图像读取 UV 通道
-            output_uv[uv_y * output_uv_width * 2 + uv_x * 2] = input_uv2[uv_y * width2 + (uv_x - width1 / 2) * 2];     // U
-            output_uv[uv_y * output_uv_width * 2 + uv_x * 2 + 1] = input_uv2[uv_y * width2 + (uv_x - width1 / 2) * 2 + 1]; // V
+            output_uv[uv_y * dst_step + uv_x * 2] = input_uv2[uv_y * src2_step + (uv_x - width1 / 2) * 2];         // U
+            output_uv[uv_y * dst_step + uv_x * 2 + 1] = input_uv2[uv_y * src2_step + (uv_x - width1 / 2) * 2 + 1]; // V
+        }
+    }
+}
+
+// 每个工作项处理的字节数（8 或 16），编译时可用 -D COMPOSE_VEC=8 覆盖
+#ifndef COMPOSE_VEC
+#define COMPOSE_VEC 16
+#endif
+
+#if COMPOSE_VEC == 8
+#define VLOAD vload8
+#define VSTORE vstore8
+#define UCHARN uchar8
+#else
+#define VLOAD vload16
+#define VSTORE vstore16
+#define UCHARN uchar16
+#endif
+
+// 单个平面的向量化拼接：每个工作项搬运一行中的 COMPOSE_VEC 个字节。
+// Y 平面和交错的 UV 平面每行字节数都等于图像宽度，所以同一个内核分两次启动：
+// Y 用 rows = height，UV 用 rows = height / 2，不再需要 x % 2 / y % 2 的分支。
+// width1 为偶数，UV 对不会跨越两张图像的边界
+__kernel void compose_nv21_plane(
+    __global const uchar* src1, int src1_step, // 第一张图像的平面及行距
+    __global const uchar* src2, int src2_step, // 第二张图像的平面及行距
+    __global uchar* dst, int dst_step,         // 输出平面及行距
+    int width1,                                // 第一张图像每行字节数
+    int width2,                                // 第二张图像每行字节数
+    int rows                                   // 平面行数
+)
+{
+    int x = get_global_id(0) * COMPOSE_VEC;
+    int y = get_global_id(1);
+    int dst_width = width1 + width2;
+    if (x >= dst_width || y >= rows) return;
+
+    __global uchar* out = dst + y * dst_step;
+    __global const uchar* row1 = src1 + y * src1_step;
+    __global const uchar* row2 = src2 + y * src2_step;
+
+    if (x + COMPOSE_VEC <= width1) {
+        // 整段都来自第一张图像
+        VSTORE(VLOAD(0, row1 + x), 0, out + x);
+    } else if (x >= width1 && x + COMPOSE_VEC <= dst_width) {
+        // 整段都来自第二张图像
+        VSTORE(VLOAD(0, row2 + x - width1), 0, out + x);
+    } else {
+        // 跨越拼接边界或位于行尾：逐字节处理
+        int end = min(x + COMPOSE_VEC, dst_width);
+        for (int i = x; i < end; i++) {
+            out[i] = i < width1 ? row1[i] : row2[i - width1];
         }
     }
 }
@@ -14,7 +14,7 @@ __kernel void compose_nv21(
 
     int output_width = width1 + width2;
 
-    if (y >= height) return;
+    if (x >= output_width || y >= height) return;
 
     sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE |
                         CLK_ADDRESS_CLAMP_TO_EDGE |
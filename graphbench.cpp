@@ -0,0 +1,151 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include <chrono>
+#include <CL/cl.h>
+
+#include "ProgramCache.h"
+#include "Graph.h"
+
+using namespace bos::mm;
+
+// 检查 OpenCL 错误
+#define CHECK_CL_ERROR(err)                                                           \
+    if (err != CL_SUCCESS)                                                            \
+    {                                                                                 \
+        std::cerr << "OpenCL error: " << err << " at line " << __LINE__ << std::endl; \
+        exit(1);                                                                      \
+    }
+
+// input1.nv21 左右拼接 -> NV21 放大 -> 转 RGB -> RGB 缩小，三个中间结果都只在图内部
+void buildChain(KernelGraph &graph, Image &input, Image &output)
+{
+    size_t width = input.get_width(), height = input.get_height();
+    size_t src = graph.add_image(input);
+    size_t dst = graph.add_image(output);
+    size_t wide = graph.add_intermediate(Image::Format::NV21, width * 2, height);
+    size_t large = graph.add_intermediate(Image::Format::NV21, width * 2, height * 2);
+    size_t rgb = graph.add_intermediate(Image::Format::RGB, width * 2, height * 2);
+    graph.compose(src, src, wide);
+    graph.resize_nv21(wide, large);
+    graph.yuv2rgb_nvx(large, rgb);
+    graph.resize_linear(rgb, dst);
+}
+
+// input1.nv21 连续四次 NV21 缩小（960x540 -> 800x450 -> 640x360 -> 480x270 -> 320x180）。
+// 第三个中间结果与第一个复用地址，它的 UV 平面落在第一个的 Y 平面上，
+// 色度写节点必须等第一个中间结果的亮度读节点结束
+void buildDownscaleChain(KernelGraph &graph, Image &input, Image &output)
+{
+    size_t src = graph.add_image(input);
+    size_t dst = graph.add_image(output);
+    size_t a = graph.add_intermediate(Image::Format::NV21, 800, 450);
+    size_t b = graph.add_intermediate(Image::Format::NV21, 640, 360);
+    size_t c = graph.add_intermediate(Image::Format::NV21, 480, 270);
+    graph.resize_nv21(src, a);
+    graph.resize_nv21(a, b);
+    graph.resize_nv21(b, c);
+    graph.resize_nv21(c, dst);
+}
+
+// 每次 run() 的墙钟时间（毫秒），第一次包含编译和分配，不计入
+double runTime(KernelGraph &graph, int runs)
+{
+    cl_int err = graph.run();
+    CHECK_CL_ERROR(err);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < runs; ++i)
+    {
+        err = graph.run();
+        CHECK_CL_ERROR(err);
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / runs;
+}
+
+// 同一条链分别在复用中间结果和每条边独占内存的图上运行，输出必须逐字节一致
+bool compareAliasing(const char *name, cl_context context, cl_device_id device, void (*build)(KernelGraph &, Image &, Image &),
+                     Image &input, Image &output, Image &reference, int runs)
+{
+    KernelGraph graph(context, device);
+    build(graph, input, output);
+    double aliased_ms = runTime(graph, runs);
+
+    KernelGraph separate(context, device);
+    separate.set_aliasing(false);
+    build(separate, input, reference);
+    double separate_ms = runTime(separate, runs);
+
+    printf("== %s\n", name);
+    for (size_t n = 0; n < graph.get_node_count(); ++n)
+    {
+        printf("node %zu %-20s waits on", n, graph.get_node_name(n).c_str());
+        for (size_t dep : graph.get_dependencies(n))
+        {
+            printf(" %zu", dep);
+        }
+        printf("\n");
+    }
+    printf("intermediates: %zu bytes, widest cut: %zu bytes\n", graph.get_intermediate_bytes(), graph.get_peak_live_bytes());
+    printf("device memory: aliased %zu bytes (%.3f ms/run), separate %zu bytes (%.3f ms/run)\n", graph.get_arena_bytes(), aliased_ms,
+           separate.get_arena_bytes(), separate_ms);
+    unsigned long long aliased_sum = program_cache_fnv1a(14695981039346656037ULL, output.get_data(), output.get_size());
+    unsigned long long separate_sum = program_cache_fnv1a(14695981039346656037ULL, reference.get_data(), reference.get_size());
+    bool match = aliased_sum == separate_sum && std::memcmp(output.get_data(), reference.get_data(), output.get_size()) == 0;
+    printf("checksum: aliased %016llx, separate %016llx, match: %s\n", aliased_sum, separate_sum, match ? "yes" : "NO");
+    return match;
+}
+
+int main(int argc, char **argv)
+{
+    cl_platform_id platform;
+    cl_device_id device;
+    cl_int err = clGetPlatformIDs(1, &platform, NULL);
+    CHECK_CL_ERROR(err);
+    cl_device_type device_type = CL_DEVICE_TYPE_GPU;
+    if (argc > 1 && std::string(argv[1]) == "cpu")
+    {
+        device_type = CL_DEVICE_TYPE_CPU;
+    }
+    else if (argc > 1 && std::string(argv[1]) == "all")
+    {
+        device_type = CL_DEVICE_TYPE_ALL;
+    }
+    err = clGetDeviceIDs(platform, device_type, 1, &device, NULL);
+    CHECK_CL_ERROR(err);
+    cl_context context = clCreateContext(NULL, 1, &device, NULL, NULL, &err);
+    CHECK_CL_ERROR(err);
+
+    // 输入 input1.nv21（960x540）
+    const size_t width = 960;
+    const size_t height = 540;
+    BufferPool pool({});
+    // compose 按平面绑定输入，UV 平面起点要满足设备的子缓冲区对齐（960x540 紧密排列时 UV 偏移 518400 不是 512 的倍数）
+    ImageLayoutOptions input_layout;
+    input_layout.plane_alignment = KernelGraph::plane_alignment(device);
+    Image input(Image::Format::NV21, width, height, pool, input_layout);
+    std::ifstream file("input1.nv21", std::ios::binary);
+    for (const auto &plane : input.get_planes())
+    {
+        if (!file.read(reinterpret_cast<char *>(plane->get_data()), plane->get_size()))
+        {
+            std::cerr << "Failed to read input1.nv21" << std::endl;
+            return 1;
+        }
+    }
+    Image output(Image::Format::RGB, width, height, pool);
+    Image reference(Image::Format::RGB, width, height, pool);
+    Image small(Image::Format::NV21, 320, 180, pool);
+    Image small_reference(Image::Format::NV21, 320, 180, pool);
+
+    const int num_runs = 50;
+    bool match = compareAliasing("compose -> resize_nv21 -> yuv2rgb_nvx -> resize_linear", context, device, buildChain, input, output,
+                                 reference, num_runs);
+    match = compareAliasing("resize_nv21 x4 downscale", context, device, buildDownscaleChain, input, small, small_reference, num_runs) && match;
+
+    std::ofstream out("graph.rgb", std::ios::binary);
+    out.write(reinterpret_cast<const char *>(output.get_data()), output.get_size());
+
+    clReleaseContext(context);
+    return match ? 0 : 1;
+}
@@ -2,6 +2,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+
+#include "ProgramCache.h"
+#include "WorkSizeTuner.h"
+#include "ResizeTables.h"
+#include "Resize.h"
+#include "Sequence.h"
+#include "Y4m.h"
+#include "ResizeNvx.h"
 
 #define CHECK_ERROR(err, msg)                               \
     if (err != CL_SUCCESS)                                  \
@@ -10,23 +19,6 @@
         exit(EXIT_FAILURE);                                 \
     }
 
-// 读取文件到内存
-void read_file(const char *filename, unsigned char **data, size_t *size)
-{
-    FILE *file = fopen(filename, "rb");
-    if (!file)
-    {
-        fprintf(stderr, "Failed to open file: %s\n", filename);
-        exit(EXIT_FAILURE);
-    }
-    fseek(file, 0, SEEK_END);
-    *size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    *data = (unsigned char *)malloc(*size);
-    fread(*data, 1, *size, file);
-    fclose(file);
-}
-
 // 保存内存数据到文件
 void write_file(const char *filename, const unsigned char *data, size_t size)
 {
@@ -40,38 +32,104 @@ void write_file(const char *filename, const unsigned char *data, size_t size)
     fclose(file);
 }
 
-// 加载 OpenCL kernel 文件
-char *load_kernel_source(const char *filename, size_t *size)
+// NV21/NV12 直接缩放输出 RGB (YUV2RGB_NVx_resizeLN)，src 为设备上的原始帧，不经过主机中转
+cl_int yuv2rgb_resize(cl_command_queue queue, cl_kernel kernel,
+                      cl_mem src, int src_step, int src_rows, int src_cols,
+                      cl_mem dst, int dst_step, int dst_rows, int dst_cols,
+                      cl_mem tables, cl_event *event)
 {
-    FILE *file = fopen(filename, "r");
-    if (!file)
+    int offset = 0;
+    cl_int err = CL_SUCCESS;
+    err |= clSetKernelArg(kernel, 0, sizeof(cl_mem), &src);
+    err |= clSetKernelArg(kernel, 1, sizeof(int), &src_step);
+    err |= clSetKernelArg(kernel, 2, sizeof(int), &offset);
+    err |= clSetKernelArg(kernel, 3, sizeof(int), &src_rows);
+    err |= clSetKernelArg(kernel, 4, sizeof(int), &src_cols);
+    err |= clSetKernelArg(kernel, 5, sizeof(cl_mem), &dst);
+    err |= clSetKernelArg(kernel, 6, sizeof(int), &dst_step);
+    err |= clSetKernelArg(kernel, 7, sizeof(int), &offset);
+    err |= clSetKernelArg(kernel, 8, sizeof(int), &dst_rows);
+    err |= clSetKernelArg(kernel, 9, sizeof(int), &dst_cols);
+    err |= clSetKernelArg(kernel, 10, sizeof(cl_mem), &tables);
+    if (err != CL_SUCCESS)
     {
-        fprintf(stderr, "Failed to open kernel file: %s\n", filename);
-        exit(EXIT_FAILURE);
+        return err;
     }
-    fseek(file, 0, SEEK_END);
-    *size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    char *source = (char *)malloc(*size + 1);
-    fread(source, 1, *size, file);
-    source[*size] = '\0';
-    fclose(file);
-    return source;
+
+    size_t global_work_size[2] = {(size_t)dst_cols, (size_t)dst_rows};
+    return bos::mm::enqueue_tuned(queue, kernel, 2, global_work_size, event);
+}
+
+// 路径以 .y4m 结尾或为 "-"（标准输入 / 输出）时按 Y4M 处理
+static bool is_y4m(const char *path)
+{
+    size_t length = strlen(path);
+    return strcmp(path, "-") == 0 || (length > 4 && strcmp(path + length - 4, ".y4m") == 0);
 }
 
-int main()
+// 用法：main [input.yuv | input.y4m | - [scale.y4m | -]]
+// 默认读 input.yuv（1280x720 NV21，无文件头）；Y4M（4:2:0）输入的宽高取自文件头。RGB 输出只取第一帧。
+// 给出 Y4M 输出时，输入的每一帧都经 resize_nvx 缩放到同样的 640x480 写成 Y4M（Y4M 输入读到流结束，原始序列读到最后一帧），
+// "-" 表示标准输出（可直接管道给编码器，报告改写到标准错误）
+int main(int argc, char **argv)
 {
     // 1. 读取 YUV 或 RGB 文件
-    const char *input_filename = "input.yuv";         // 输入文件
+    const char *input_filename = argc > 1 ? argv[1] : "input.yuv"; // 输入文件
     const char *output_filename = "output.rgb";       // 输出文件
     const char *output_resize_filename = "scale.rgb"; // 输出文件
-    unsigned char *input_data;
-    size_t input_size;
-    read_file(input_filename, &input_data, &input_size);
+    const char *output_auto_filename = "scale_auto.rgb"; // 输出文件
+    const char *output_y4m_filename = argc > 2 ? argv[2] : NULL; // 缩放后的 NV21 帧（Y4M），可选
+    if (output_y4m_filename && !is_y4m(output_y4m_filename))
+    {
+        fprintf(stderr, "Output %s must be a .y4m file or -\n", output_y4m_filename);
+        exit(EXIT_FAILURE);
+    }
+    FILE *report = output_y4m_filename && strcmp(output_y4m_filename, "-") == 0 ? stderr : stdout;
 
     // 假设输入是 NV21 格式的 YUV 图像
     int width = 1280;               // 图像宽度
     int height = 720;               // 图像高度
+
+    // 原始文件的第一帧直接取自文件映射，不读入、不复制；Y4M 的平面 U、V 读入时交织成 NV21
+    bos::mm::BufferPool pool({});
+    bos::mm::Y4mHeader y4m_header;
+    std::unique_ptr<bos::mm::Y4mReader> y4m_reader;
+    std::unique_ptr<bos::mm::SequenceReader> sequence;
+    std::unique_ptr<bos::mm::Image> y4m_frame;
+    std::shared_ptr<bos::mm::Buffer> input_frame;
+    try
+    {
+        if (is_y4m(input_filename))
+        {
+            y4m_reader = std::make_unique<bos::mm::Y4mReader>(input_filename);
+            y4m_header = y4m_reader->get_header();
+            if (y4m_header.format != bos::mm::Image::Format::YUV420)
+            {
+                fprintf(stderr, "%s is not 4:2:0\n", input_filename);
+                exit(EXIT_FAILURE);
+            }
+            width = (int)y4m_header.width;
+            height = (int)y4m_header.height;
+            y4m_frame = std::make_unique<bos::mm::Image>(bos::mm::Image::Format::NV21, width, height, pool);
+            if (!y4m_reader->read_frame(*y4m_frame))
+            {
+                fprintf(stderr, "%s has no frame\n", input_filename);
+                exit(EXIT_FAILURE);
+            }
+            input_frame = y4m_frame->get_buffer();
+        }
+        else
+        {
+            sequence = std::make_unique<bos::mm::SequenceReader>(input_filename, bos::mm::Image::Format::NV21, width, height);
+            input_frame = sequence->frame_buffer(0);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        fprintf(stderr, "%s\n", e.what());
+        exit(EXIT_FAILURE);
+    }
+    unsigned char *input_data = input_frame->get_data();
     size_t y_size = width * height; // Y 分量大小
     size_t uv_size = y_size / 2;    // UV 分量大小
 
@@ -80,9 +138,8 @@ int main()
     cl_device_id device;
     cl_context context;
     cl_command_queue queue;
-    cl_program program;
-    cl_kernel kernel;
-    cl_program program_resize;
+    cl_program programs[3];
+    cl_kernel kernels[3];
     cl_kernel kernel_resize;
     cl_int err;
 
@@ -100,56 +157,25 @@ int main()
     queue = clCreateCommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE, &err);
     CHECK_ERROR(err, "Failed to create command queue");
 
-    char options[128];
-    sprintf(options, "-D PIX_PER_WI_Y=1 -D SCN=1 -D DCN=3 -D BIDX=2 -D UIDX=1 -D SRC_DEPTH=0");
-
-    // 3. 加载 kernel 文件
-    size_t kernel_size;
-    char *kernel_source = load_kernel_source("color_yuv.cl", &kernel_size);
-
-    // 创建和编译程序
-    program = clCreateProgramWithSource(context, 1, (const char **)&kernel_source, &kernel_size, &err);
-    CHECK_ERROR(err, "Failed to create program");
-
-    err = clBuildProgram(program, 1, &device, options, NULL, NULL);
-    if (err != CL_SUCCESS)
-    {
-        size_t log_size;
-        clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, 0, NULL, &log_size);
-        char *log = (char *)malloc(log_size);
-        clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, log_size, log, NULL);
-        fprintf(stderr, "Build log:\n%s\n", log);
-        free(log);
-        exit(EXIT_FAILURE);
-    }
-
-    // 4. 创建内核
-    kernel = clCreateKernel(program, "YUV2RGB_NVx", &err); // 使用 YUV 转 RGB 的 kernel
-    CHECK_ERROR(err, "Failed to create kernel");
-
-    // 3. 加载 kernel 文件
-    size_t kernel_resize_size;
-    char *kernel_resize_source = load_kernel_source("resize.cl", &kernel_resize_size);
-
-    // 创建和编译程序
-    program_resize = clCreateProgramWithSource(context, 1, (const char **)&kernel_resize_source, &kernel_resize_size, &err);
-    CHECK_ERROR(err, "Failed to create program 2");
-    char options2[128];
-    sprintf(options2, "-D SRC_DEPTH=0 -D INTER_LINEAR_INTEGER -D T=uchar  -D WT=int3 -D CONVERT_TO_WT=convert_int3 -D CONVERT_TO_DT=convert_uchar -D CN=3 -D T1=uchar ");
-    err = clBuildProgram(program_resize, 1, &device, options2, NULL, NULL);
-    if (err != CL_SUCCESS)
+    // 3. 加载并编译 kernel（命中磁盘缓存时直接加载二进制）
+    // 按每个工作项处理 1、2、4 行各编译一份，由调优器按设备选出最快的一份
+    const int pix_per_wi[3] = {1, 2, 4};
+    for (int i = 0; i < 3; ++i)
     {
-        size_t log_size;
-        clGetProgramBuildInfo(program_resize, device, CL_PROGRAM_BUILD_LOG, 0, NULL, &log_size);
-        char *log = (char *)malloc(log_size);
-        clGetProgramBuildInfo(program_resize, device, CL_PROGRAM_BUILD_LOG, log_size, log, NULL);
-        fprintf(stderr, "Build log 2:\n%s\n", log);
-        free(log);
-        exit(EXIT_FAILURE);
+        char options[128];
+        sprintf(options, "-D PIX_PER_WI_Y=%d -D SCN=1 -D DCN=3 -D BIDX=2 -D UIDX=1 -D SRC_DEPTH=0", pix_per_wi[i]);
+        int from_cache = 0;
+        programs[i] = program_cache_build(context, device, "color_yuv.cl", options, &from_cache, &err);
+        CHECK_ERROR(err, "Failed to build program");
+        fprintf(report, "color_yuv.cl (PIX_PER_WI_Y=%d): %s\n", pix_per_wi[i], from_cache ? "loaded from binary cache" : "compiled from source");
+
+        // 4. 创建内核
+        kernels[i] = clCreateKernel(programs[i], "YUV2RGB_NVx", &err); // 使用 YUV 转 RGB 的 kernel
+        CHECK_ERROR(err, "Failed to create kernel");
     }
 
-    // 4. 创建内核
-    kernel_resize = clCreateKernel(program_resize, "resizeLN", &err);
+    // 同一个 program 中的融合 kernel：NVx -> RGB + 缩放
+    kernel_resize = clCreateKernel(programs[0], "YUV2RGB_NVx_resizeLN", &err);
     CHECK_ERROR(err, "Failed to create kernel 2");
 
     // 设置kernel参数
@@ -159,7 +185,6 @@ int main()
     int dst_step = cols * 3; // RGB图像的步长（假设为3通道）
     int src_offset = 0;      // YUV图像的偏移量
     int dt_offset = 0;       // RGB图像的偏移量
-    int PIX_PER_WI_Y = 1;    // 每个工作项处理的像素行数
 
     // 分配内存
     size_t src_size = rows * src_step * 3 / 2;
@@ -172,34 +197,24 @@ int main()
     cl_mem dst_buffer = clCreateBuffer(context, CL_MEM_WRITE_ONLY, dst_size, NULL, &err);
     CHECK_ERROR(err, "Failed to create destination buffer");
 
-    // 设置kernel参数
-    err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &src_buffer);
-    CHECK_ERROR(err, "Failed to set kernel argument 0");
-
-    err = clSetKernelArg(kernel, 1, sizeof(int), &src_step);
-    CHECK_ERROR(err, "Failed to set kernel argument 1");
-
-    err = clSetKernelArg(kernel, 2, sizeof(int), &src_offset);
-    CHECK_ERROR(err, "Failed to set kernel argument 2");
-
-    err = clSetKernelArg(kernel, 3, sizeof(cl_mem), &dst_buffer);
-    CHECK_ERROR(err, "Failed to set kernel argument 3");
-
-    err = clSetKernelArg(kernel, 4, sizeof(int), &dst_step);
-    CHECK_ERROR(err, "Failed to set kernel argument 4");
-
-    err = clSetKernelArg(kernel, 5, sizeof(int), &dt_offset);
-    CHECK_ERROR(err, "Failed to set kernel argument 5");
-
-    err = clSetKernelArg(kernel, 6, sizeof(int), &rows);
-    CHECK_ERROR(err, "Failed to set kernel argument 6");
-
-    err = clSetKernelArg(kernel, 7, sizeof(int), &cols);
-    CHECK_ERROR(err, "Failed to set kernel argument 7");
+    // 设置kernel参数（三个变体相同）
+    for (int i = 0; i < 3; ++i)
+    {
+        err = clSetKernelArg(kernels[i], 0, sizeof(cl_mem), &src_buffer);
+        err |= clSetKernelArg(kernels[i], 1, sizeof(int), &src_step);
+        err |= clSetKernelArg(kernels[i], 2, sizeof(int), &src_offset);
+        err |= clSetKernelArg(kernels[i], 3, sizeof(cl_mem), &dst_buffer);
+        err |= clSetKernelArg(kernels[i], 4, sizeof(int), &dst_step);
+        err |= clSetKernelArg(kernels[i], 5, sizeof(int), &dt_offset);
+        err |= clSetKernelArg(kernels[i], 6, sizeof(int), &rows);
+        err |= clSetKernelArg(kernels[i], 7, sizeof(int), &cols);
+        CHECK_ERROR(err, "Failed to set kernel arguments");
+    }
     cl_event kernel_event;
-    // 执行kernel
-    size_t global_work_size[2] = {cols / 2, rows / 2 / PIX_PER_WI_Y};
-    err = clEnqueueNDRangeKernel(queue, kernel, 2, NULL, global_work_size, NULL, 0, NULL, &kernel_event);
+    // 执行kernel：每个工作项处理 2x2 像素，按调优结果选择变体和工作组尺寸（第一次运行时调优）
+    std::vector<bos::mm::KernelVariant> variants = {{1, kernels[0]}, {2, kernels[1]}, {4, kernels[2]}};
+    size_t global_work_size[2] = {(size_t)cols / 2, (size_t)rows / 2};
+    err = bos::mm::enqueue_tuned(queue, variants, 2, global_work_size, &kernel_event);
     CHECK_ERROR(err, "Failed to enqueue kernel");
 
     // 等待 Kernel 完成
@@ -218,128 +233,42 @@ int main()
     double elapsed_time_ms = elapsed_time / 1e6;   // 毫秒
     double elapsed_time_s = elapsed_time / 1e9;    // 秒
 
-    printf("Kernel execution time: %f ms\n", elapsed_time_ms);
+    fprintf(report, "Kernel execution time: %f ms\n", elapsed_time_ms);
 
-    // 8. 读取结果
+    // 8. 读取结果：全分辨率 RGB 只为写出 output.rgb 而读回，下面的缩放不依赖这次读回
+    // （融合内核直接读设备上的 NV21 帧，RGB 缩放直接用设备上的 dst_buffer）
     err = clEnqueueReadBuffer(queue, dst_buffer, CL_TRUE, 0, dst_size, rgb_data, 0, NULL, NULL);
     CHECK_ERROR(err, "Failed to read RGB buffer");
 
     // 9. 保存结果
     write_file(output_filename, rgb_data, dst_size);
 
-    // 4. 准备输入数
-    const int INTER_RESIZE_COEF_SCALE = 2048; // Example value, adjust as needed
+    // 4. 准备输入数据：直接从设备上的 NV21 帧缩放，不再读回全分辨率 RGB 再上传
     int src_rows = height;                    // 输入图像的行数
     int src_cols = width;                     // 输入图像的列数
-    int src_step_resize = src_cols * 3;       // 输入图像的列数
     int dst_rows = 480;                      // 输出图像的行数
     int dst_cols = 640;                      // 输出图像的列数
     int dst_step_resize = dst_cols * 3;
     int scale_size = dst_rows * dst_step_resize;
     unsigned char *rgb_data_resize = (unsigned char *)malloc(scale_size);
-    const float inv_fx = (float)src_cols / dst_cols; // 输入宽度 / 输出宽度
-    const float inv_fy = (float)src_rows / dst_rows; // 输入高度 / 输出高度
-
-    // Calculate buffer size
-    size_t buffer_size = (dst_cols + dst_rows) * sizeof(int) + (dst_cols + dst_rows) * 2 * sizeof(short);
-    unsigned char *buffer_data = (unsigned char *)malloc(buffer_size);
-
-    // Cast pointers to the appropriate types
-    int *xofs = (int *)buffer_data;
-    int *yofs = xofs + dst_cols;
-    short *ialpha = (short *)(yofs + dst_rows);
-    short *ibeta = ialpha + dst_cols * 2;
-
-    // Calculate xofs and ialpha
-    for (int dx = 0; dx < dst_cols; dx++)
-    {
-        float fxx = (float)((dx + 0.5) * inv_fx - 0.5);
-        int sx = (int)floor(fxx);
-        fxx -= sx;
-
-        if (sx < 0)
-        {
-            fxx = 0, sx = 0;
-        }
-        if (sx >= src_cols - 1)
-        {
-            fxx = 0, sx = src_cols - 1;
-        }
-
-        xofs[dx] = sx;
-        ialpha[dx * 2 + 0] = (short)((1.f - fxx) * INTER_RESIZE_COEF_SCALE);
-        ialpha[dx * 2 + 1] = (short)(fxx * INTER_RESIZE_COEF_SCALE);
-    }
-
-    // Calculate yofs and ibeta
-    for (int dy = 0; dy < dst_rows; dy++)
-    {
-        float fyy = (float)((dy + 0.5) * inv_fy - 0.5);
-        int sy = (int)floor(fyy);
-        fyy -= sy;
-
-        yofs[dy] = sy;
-        ibeta[dy * 2 + 0] = (short)((1.f - fyy) * INTER_RESIZE_COEF_SCALE);
-        ibeta[dy * 2 + 1] = (short)(fyy * INTER_RESIZE_COEF_SCALE);
-    }
-
-    cl_mem src_buffer_resize = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, dst_size, rgb_data, &err);
-    CHECK_ERROR(err, "Failed to create source buffer");
 
     cl_mem dst_buffer_resize = clCreateBuffer(context, CL_MEM_WRITE_ONLY, scale_size, NULL, &err);
     CHECK_ERROR(err, "Failed to create destination buffer");
 
-    cl_mem buffer_mem = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, buffer_size, buffer_data, &err);
-    CHECK_ERROR(err, "Failed to create coefficients buffer");
-
-    int default_z = 0;
-
-    // 6. 设置 kernel 参数
-    // Set kernel arguments
-    err = clSetKernelArg(kernel_resize, 0, sizeof(cl_mem), &src_buffer_resize);
-    CHECK_ERROR(err, "Failed to set kernel_resize argument 0");
-
-    err = clSetKernelArg(kernel_resize, 1, sizeof(int), &src_step_resize);
-    CHECK_ERROR(err, "Failed to set kernel_resize argument 1");
-
-    err = clSetKernelArg(kernel_resize, 2, sizeof(int), &src_offset);
-    CHECK_ERROR(err, "Failed to set kernel_resize argument 2");
-
-    err = clSetKernelArg(kernel_resize, 3, sizeof(int), &src_rows);
-    CHECK_ERROR(err, "Failed to set kernel_resize argument 3");
-
-    err = clSetKernelArg(kernel_resize, 4, sizeof(int), &src_cols);
-    CHECK_ERROR(err, "Failed to set kernel_resize argument 4");
-
-    err = clSetKernelArg(kernel_resize, 5, sizeof(cl_mem), &dst_buffer_resize);
-    CHECK_ERROR(err, "Failed to set kernel_resize argument 5");
-
-    err = clSetKernelArg(kernel_resize, 6, sizeof(int), &dst_step_resize);
-    CHECK_ERROR(err, "Failed to set kernel_resize argument 6");
-
-    err = clSetKernelArg(kernel_resize, 7, sizeof(int), &dt_offset);
-    CHECK_ERROR(err, "Failed to set kernel_resize argument 7");
-
-    err = clSetKernelArg(kernel_resize, 8, sizeof(int), &dst_rows);
-    CHECK_ERROR(err, "Failed to set kernel_resize argument 8");
-
-    err = clSetKernelArg(kernel_resize, 9, sizeof(int), &dst_cols);
-    CHECK_ERROR(err, "Failed to set kernel_resize argument 9");
-
-    err = clSetKernelArg(kernel_resize, 10, sizeof(cl_mem), &buffer_mem);
-    CHECK_ERROR(err, "Failed to set kernel_resize argument 10");
+    // 插值表按几何缓存在设备上：同一几何的后续帧不再计算和上传
+    bos::mm::ResizeTableCache resize_tables(context);
+    bos::mm::ResizeTables linear_tables = resize_tables.get(src_cols, src_rows, dst_cols, dst_rows, bos::mm::ResizeInterpolation::LINEAR);
+    cl_mem buffer_mem = linear_tables.coeffs;
 
     cl_event kernel_event_resize;
-    // 执行kernel
-    size_t global_work_size_resize[2] = {dst_cols, dst_rows};
-    err = clEnqueueNDRangeKernel(queue, kernel_resize, 2, NULL, global_work_size_resize, NULL, 0, NULL, &kernel_event_resize);
+    err = yuv2rgb_resize(queue, kernel_resize, src_buffer, src_step, src_rows, src_cols,
+                         dst_buffer_resize, dst_step_resize, dst_rows, dst_cols, buffer_mem, &kernel_event_resize);
     CHECK_ERROR(err, "Failed to enqueue kernel");
 
     // 等待 Kernel 完成
     clWaitForEvents(1, &kernel_event_resize);
 
     // 获取时间戳
-    // cl_ulong start_time, end_time;
     err = clGetEventProfilingInfo(kernel_event_resize, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start_time, NULL);
     CHECK_ERROR(err, "Failed to get start time");
 
@@ -350,7 +279,7 @@ int main()
     elapsed_time = end_time - start_time; // 纳秒
     elapsed_time_ms = elapsed_time / 1e6; // 毫秒
 
-    printf("Kernel execution time: %f ms\n", elapsed_time_ms);
+    fprintf(report, "Kernel execution time: %f ms\n", elapsed_time_ms);
 
     // 8. 读取结果
     err = clEnqueueReadBuffer(queue, dst_buffer_resize, CL_TRUE, 0, scale_size, rgb_data_resize, 0, NULL, NULL);
@@ -359,20 +288,84 @@ int main()
     // 9. 保存结果
     write_file(output_resize_filename, rgb_data_resize, scale_size);
 
+    // 同样的尺寸从全分辨率 RGB 缩放，内核变体由前端按缩放比例选择（默认的 1280x720 为非整数倍缩小，走 resizeAREA）
+    bos::mm::Resizer resizer(context, device);
+    bos::mm::ResizeKernel chosen = resizer.select(cols, rows, dst_cols, dst_rows, bos::mm::ResizeMethod::AUTO, false);
+    err = resizer.resize(queue, dst_buffer, dst_step, cols, rows, dst_buffer_resize, dst_step_resize, dst_cols, dst_rows, 3);
+    CHECK_ERROR(err, "Failed to enqueue resize");
+    err = clEnqueueReadBuffer(queue, dst_buffer_resize, CL_TRUE, 0, scale_size, rgb_data_resize, 0, NULL, NULL);
+    CHECK_ERROR(err, "Failed to read RGB buffer");
+    fprintf(report, "RGB resize: %s\n", bos::mm::resize_kernel_name(chosen));
+    write_file(output_auto_filename, rgb_data_resize, scale_size);
+
+    // Y4M 输出：设备上的 NV21 帧经 resize_nvx 缩放后写出，宽高、帧率随文件头一起交给下游。
+    // 第一帧已经在 src_buffer 上，之后的帧逐帧读入并上传到同一块设备缓冲区
+    if (output_y4m_filename)
+    {
+        bos::mm::Nv21Resizer nv21_resizer(context, device);
+        bos::mm::Image scaled(bos::mm::Image::Format::NV21, dst_cols, dst_rows, pool);
+        bos::mm::Nv21Target from = {src_buffer, src_buffer, 0, y_size, (size_t)src_step};
+        y4m_header.width = dst_cols;
+        y4m_header.height = dst_rows;
+        y4m_header.format = bos::mm::Image::Format::YUV420;
+        try
+        {
+            bos::mm::Y4mWriter writer(output_y4m_filename, y4m_header);
+            for (size_t index = 0;; ++index)
+            {
+                if (index > 0)
+                {
+                    if (y4m_reader ? !y4m_reader->read_frame(*y4m_frame) : index >= sequence->get_frame_count())
+                    {
+                        break;
+                    }
+                    if (sequence)
+                    {
+                        input_frame = sequence->frame_buffer(index);
+                    }
+                    err = clEnqueueWriteBuffer(queue, src_buffer, CL_TRUE, 0, src_size, input_frame->get_data(), 0, NULL, NULL);
+                    CHECK_ERROR(err, "Failed to upload NV21 frame");
+                }
+                err = nv21_resizer.resize(queue, from, src_cols, src_rows, bos::mm::nv21_target(scaled, context, queue), dst_cols, dst_rows);
+                CHECK_ERROR(err, "Failed to enqueue NV21 resize");
+                err = scaled.sync_to_host(context, queue);
+                CHECK_ERROR(err, "Failed to read NV21 frame");
+                if (!writer.write_frame(scaled))
+                {
+                    fprintf(stderr, "Failed to write %s\n", output_y4m_filename);
+                    exit(EXIT_FAILURE);
+                }
+            }
+            if (!writer.flush())
+            {
+                fprintf(stderr, "Failed to write %s\n", output_y4m_filename);
+                exit(EXIT_FAILURE);
+            }
+            fprintf(report, "Y4M output: %zu frame(s)\n", writer.get_frame_count());
+        }
+        catch (const std::exception &e)
+        {
+            fprintf(stderr, "%s\n", e.what());
+            exit(EXIT_FAILURE);
+        }
+    }
+
     // 10. 清理资源
     clReleaseMemObject(src_buffer);
     clReleaseMemObject(dst_buffer);
-    clReleaseMemObject(src_buffer_resize);
     clReleaseMemObject(dst_buffer_resize);
-    clReleaseKernel(kernel);
-    clReleaseProgram(program);
+    clReleaseKernel(kernel_resize);
+    for (int i = 0; i < 3; ++i)
+    {
+        clReleaseKernel(kernels[i]);
+        clReleaseProgram(programs[i]);
+    }
     clReleaseCommandQueue(queue);
     clReleaseContext(context);
 
-    free(input_data);
     free(rgb_data);
-    free(kernel_source);
+    free(rgb_data_resize);
 
-    printf("Processing complete!\n");
+    fprintf(report, "Processing complete!\n");
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,229 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include <chrono>
+#include <CL/cl.h>
+
+#include "ProgramCache.h"
+#include "Compose.h"
+
+using namespace bos::mm;
+
+// 检查 OpenCL 错误
+#define CHECK_CL_ERROR(err)                                                           \
+    if (err != CL_SUCCESS)                                                            \
+    {                                                                                 \
+        std::cerr << "OpenCL error: " << err << " at line " << __LINE__ << std::endl; \
+        exit(1);                                                                      \
+    }
+
+// 把紧密排列的 NV21 帧逐行写入 Y、UV 两个平面
+void fillPlanes(const std::vector<unsigned char> &frame, size_t width, size_t height,
+                const std::vector<std::shared_ptr<Plane>> &planes)
+{
+    const unsigned char *src = frame.data();
+    for (const auto &plane : planes)
+    {
+        size_t rows = plane == planes[0] ? height : height / 2;
+        for (size_t row = 0; row < rows; ++row, src += width)
+        {
+            std::memcpy(plane->get_data() + row * plane->get_stride(), src, width);
+        }
+    }
+}
+
+// 每帧的墙钟时间（纳秒）：enqueue 一帧的全部命令并等待完成，拷贝路径的提交开销也计算在内
+template <typename F>
+double frameTime(cl_command_queue queue, int runs, F enqueue)
+{
+    enqueue();
+    clFinish(queue);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < runs; ++i)
+    {
+        enqueue();
+        clFinish(queue);
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / runs;
+}
+
+// 现有做法：每行先用 compose_nv21_plane 两两横向拼接（中间结果写入临时图像），
+// 再把各行按平面拷贝到输出中
+void runPairwiseChain(cl_context context, cl_command_queue queue, cl_kernel kernel,
+                          std::vector<Image> &feeds, std::vector<Image> &partials, Image &output, size_t cols, size_t rows)
+{
+    const int vec = 16;
+    size_t tile_height = feeds[0].get_height();
+    for (size_t r = 0; r < rows; ++r)
+    {
+        // partials[c - 1] 为本行前 c + 1 路的拼接结果
+        Image *left = &feeds[r * cols];
+        for (size_t c = 1; c < cols; ++c)
+        {
+            Image &right = feeds[r * cols + c];
+            Image &out = partials[c - 1];
+            int width1 = static_cast<int>(left->get_width());
+            int width2 = static_cast<int>(right.get_width());
+            for (int p = 0; p < 2; ++p)
+            {
+                cl_mem src1 = left->get_planes()[p]->to_cl_mem(context, queue);
+                cl_mem src2 = right.get_planes()[p]->to_cl_mem(context, queue);
+                cl_mem dst = out.get_planes()[p]->to_cl_mem(context, queue);
+                int src1_step = static_cast<int>(left->get_planes()[p]->get_stride());
+                int src2_step = static_cast<int>(right.get_planes()[p]->get_stride());
+                int dst_step = static_cast<int>(out.get_planes()[p]->get_stride());
+                int plane_rows = static_cast<int>(out.get_planes()[p]->get_height());
+                cl_int err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &src1);
+                err |= clSetKernelArg(kernel, 1, sizeof(int), &src1_step);
+                err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &src2);
+                err |= clSetKernelArg(kernel, 3, sizeof(int), &src2_step);
+                err |= clSetKernelArg(kernel, 4, sizeof(cl_mem), &dst);
+                err |= clSetKernelArg(kernel, 5, sizeof(int), &dst_step);
+                err |= clSetKernelArg(kernel, 6, sizeof(int), &width1);
+                err |= clSetKernelArg(kernel, 7, sizeof(int), &width2);
+                err |= clSetKernelArg(kernel, 8, sizeof(int), &plane_rows);
+                CHECK_CL_ERROR(err);
+
+                size_t global_size[2] = {static_cast<size_t>((width1 + width2 + vec - 1) / vec), static_cast<size_t>(plane_rows)};
+                err = enqueue_tuned(queue, kernel, 2, global_size);
+                CHECK_CL_ERROR(err);
+            }
+            left = &out;
+        }
+
+        // 整行拼好后按平面拷贝到输出的对应行
+        for (int p = 0; p < 2; ++p)
+        {
+            const auto &src_plane = left->get_planes()[p];
+            const auto &dst_plane = output.get_planes()[p];
+            size_t plane_rows = src_plane->get_height();
+            size_t src_origin[3] = {0, 0, 0};
+            size_t dst_origin[3] = {0, r * (p == 0 ? tile_height : tile_height / 2), 0};
+            size_t region[3] = {left->get_width(), plane_rows, 1};
+            cl_int err = clEnqueueCopyBufferRect(queue, src_plane->to_cl_mem(context, queue), dst_plane->to_cl_mem(context, queue),
+                                                 src_origin, dst_origin, region, src_plane->get_stride(), 0,
+                                                 dst_plane->get_stride(), 0, 0, NULL, NULL);
+            CHECK_CL_ERROR(err);
+        }
+    }
+}
+
+// 用法：mosaicbench [gpu|cpu|all]，默认 GPU；设置 OCL_LAYOUT_VERBOSE 可打印实测的拷贝/内核分界点
+int main(int argc, char **argv)
+{
+    cl_platform_id platform;
+    cl_device_id device;
+    cl_int err = clGetPlatformIDs(1, &platform, NULL);
+    CHECK_CL_ERROR(err);
+    cl_device_type device_type = CL_DEVICE_TYPE_GPU;
+    if (argc > 1 && std::string(argv[1]) == "cpu")
+    {
+        device_type = CL_DEVICE_TYPE_CPU;
+    }
+    else if (argc > 1 && std::string(argv[1]) == "all")
+    {
+        device_type = CL_DEVICE_TYPE_ALL;
+    }
+    err = clGetDeviceIDs(platform, device_type, 1, &device, NULL);
+    CHECK_CL_ERROR(err);
+
+    cl_context context = clCreateContext(NULL, 1, &device, NULL, NULL, &err);
+    CHECK_CL_ERROR(err);
+    cl_command_queue queue = clCreateCommandQueueWithProperties(context, device, NULL, &err);
+    CHECK_CL_ERROR(err);
+
+    cl_program program = program_cache_build(context, device, "compose_nv21_buffer.cl", NULL, NULL, &err);
+    CHECK_CL_ERROR(err);
+    cl_kernel pair_kernel = clCreateKernel(program, "compose_nv21_plane", &err);
+    CHECK_CL_ERROR(err);
+
+    // 每路输入都是 input1.nv21（960x540）
+    const size_t tile_width = 960;
+    const size_t tile_height = 540;
+    std::vector<unsigned char> frame(tile_width * tile_height * 3 / 2);
+    std::ifstream file("input1.nv21", std::ios::binary);
+    if (!file.read(reinterpret_cast<char *>(frame.data()), frame.size()))
+    {
+        std::cerr << "Failed to read input1.nv21" << std::endl;
+        return 1;
+    }
+
+    const int num_runs = 100;
+    const size_t grids[] = {2, 3, 4};
+    std::cout << "Times are wall-clock per frame; GB/s counts reading all feeds plus writing the mosaic" << std::endl;
+    std::cout << "grid   feeds  output       kernel(ms)  (GB/s)  copy(ms)  (GB/s)  chain(ms)  (GB/s)  auto    match" << std::endl;
+    for (size_t n : grids)
+    {
+        size_t out_width = tile_width * n;
+        size_t out_height = tile_height * n;
+        size_t frame_bytes = out_width * out_height * 3 / 2;
+        BufferPool pool({});
+        auto tiles = MosaicCompose::grid(n, n, tile_width, tile_height);
+
+        // 单次启动的拼接内核，以及同样布局的拷贝引擎路径
+        MosaicCompose mosaic(context, device, out_width, out_height, tiles, pool, ImageLayoutOptions(), LayoutBackend::KERNEL);
+        MosaicCompose mosaic_copy(context, device, out_width, out_height, tiles, pool, ImageLayoutOptions(), LayoutBackend::COPY);
+        MosaicCompose mosaic_auto(context, device, out_width, out_height, tiles, pool);
+        for (MosaicCompose *m : {&mosaic, &mosaic_copy})
+        {
+            for (size_t i = 0; i < m->get_tile_count(); ++i)
+            {
+                fillPlanes(frame, tile_width, tile_height, m->get_source(i));
+            }
+            err = m->sync_sources_to_device(queue);
+            CHECK_CL_ERROR(err);
+        }
+
+        double kernel_ns = frameTime(queue, num_runs, [&]()
+                                     { cl_int e = mosaic.compose(queue); CHECK_CL_ERROR(e); });
+        double copy_ns = frameTime(queue, num_runs, [&]()
+                                   { cl_int e = mosaic_copy.compose(queue); CHECK_CL_ERROR(e); });
+
+        // 两两拼接链：每路独立的图像 + 每行的中间结果
+        std::vector<Image> feeds;
+        feeds.reserve(n * n);
+        for (size_t i = 0; i < n * n; ++i)
+        {
+            feeds.emplace_back(Image::Format::NV21, tile_width, tile_height, pool);
+            fillPlanes(frame, tile_width, tile_height, feeds.back().get_planes());
+            err = feeds.back().sync_to_device(context, queue);
+            CHECK_CL_ERROR(err);
+        }
+        std::vector<Image> partials;
+        partials.reserve(n - 1);
+        for (size_t c = 1; c < n; ++c)
+        {
+            partials.emplace_back(Image::Format::NV21, tile_width * (c + 1), tile_height, pool);
+        }
+        Image chain_output(Image::Format::NV21, out_width, out_height, pool);
+
+        double chain_ns = frameTime(queue, num_runs, [&]()
+                                    { runPairwiseChain(context, queue, pair_kernel, feeds, partials, chain_output, n, n); });
+
+        // 三种做法的输出必须逐字节一致（都是紧密排列）
+        bool match = true;
+        for (Image *image : {&mosaic.get_output(), &mosaic_copy.get_output(), &chain_output})
+        {
+            err = image->sync_to_host(context, queue);
+            CHECK_CL_ERROR(err);
+            match = match && std::memcmp(mosaic.get_output().get_data(), image->get_data(), frame_bytes) == 0;
+        }
+
+        const char *choice = mosaic_auto.get_backend() == LayoutBackend::COPY ? "copy" : "kernel";
+        printf("%zux%zu  %5zu  %5zux%-5zu  %10.3f  %6.2f  %8.3f  %6.2f  %9.3f  %6.2f  %-6s  %s\n", n, n, n * n, out_width, out_height,
+               kernel_ns / 1e6, 2.0 * frame_bytes / kernel_ns, copy_ns / 1e6, 2.0 * frame_bytes / copy_ns,
+               chain_ns / 1e6, 2.0 * frame_bytes / chain_ns, choice, match ? "yes" : "NO");
+        if (n == 2)
+        {
+            std::ofstream out("output.nv21", std::ios::binary);
+            out.write(reinterpret_cast<const char *>(mosaic.get_output().get_data()), frame_bytes);
+        }
+    }
+
+    clReleaseKernel(pair_kernel);
+    clReleaseProgram(program);
+    clReleaseCommandQueue(queue);
+    clReleaseContext(context);
+    return 0;
+}
@@ -0,0 +1,178 @@
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+#include "BufferPool.h"
+
+using namespace bos::mm;
+
+// 统计堆分配次数，用来验证稳态下获取/归还不分配内存
+static std::atomic<size_t> g_allocations{0};
+
+// 所有形式都经由不内联的 counted_alloc/counted_free，编译器看不到 new 与 free 直接配对（-Wmismatched-new-delete）
+__attribute__((noinline)) static void *counted_alloc(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) static void counted_free(void *p) noexcept { std::free(p); }
+
+void *operator new(size_t size) { return counted_alloc(size); }
+void *operator new[](size_t size) { return counted_alloc(size); }
+void operator delete(void *p) noexcept { counted_free(p); }
+void operator delete[](void *p) noexcept { counted_free(p); }
+void operator delete(void *p, size_t) noexcept { counted_free(p); }
+void operator delete[](void *p, size_t) noexcept { counted_free(p); }
+
+// 尺寸分级与水位裁剪：相近的 NV21/RGB 尺寸必须共享缓冲区，空闲内存超过 high_watermark 后回落到 low_watermark 以内
+bool checkSizeClasses(const char *name, const BufferPoolOptions &options)
+{
+    const size_t nv21_1080 = 1920 * 1080 * 3 / 2;
+    const size_t nv21_1088 = 1920 * 1088 * 3 / 2;
+    const size_t rgb_720 = 1280 * 720 * 3;
+    const size_t rgb_736 = 1280 * 736 * 3;
+    const size_t near_sizes[][2] = {{nv21_1080, nv21_1088}, {rgb_720, rgb_736}, {nv21_1080, rgb_720}};
+    bool ok = true;
+
+    for (auto &pair : near_sizes)
+    {
+        BufferPool pool({}, 0, options);
+        uint8_t *first = pool.get_buffer(Buffer::Type::NORMAL, pair[0])->get_data();
+        auto second = pool.get_buffer(Buffer::Type::NORMAL, pair[1]);
+        if (pool.get_size_class(pair[0]) != pool.get_size_class(pair[1]) || second->get_data() != first ||
+            pool.get_allocated_count() != 1)
+        {
+            printf("%s: sizes %zu and %zu do not share a buffer\n", name, pair[0], pair[1]);
+            ok = false;
+        }
+    }
+
+    BufferPoolOptions trimmed = options;
+    size_t capacity = BufferPool({}, 0, options).get_size_class(nv21_1080);
+    trimmed.high_watermark = capacity * 7 / 2;
+    trimmed.low_watermark = capacity;
+    BufferPool pool({}, 0, trimmed);
+    std::vector<BufferPool::Handle> held;
+    for (int i = 0; i < 5; ++i)
+    {
+        held.push_back(pool.get_buffer(Buffer::Type::NORMAL, i % 2 ? rgb_720 : nv21_1080));
+    }
+    bool trim_seen = false;
+    for (auto &handle : held)
+    {
+        size_t before = pool.get_idle_bytes();
+        handle.reset();
+        size_t after = pool.get_idle_bytes();
+        if (after > trimmed.high_watermark)
+        {
+            printf("%s: idle bytes %zu exceed high watermark %zu\n", name, after, trimmed.high_watermark);
+            ok = false;
+        }
+        if (after < before + capacity)
+        {
+            trim_seen = true;
+            if (after > trimmed.low_watermark)
+            {
+                printf("%s: trim left %zu idle bytes, low watermark is %zu\n", name, after, trimmed.low_watermark);
+                ok = false;
+            }
+        }
+    }
+    if (!trim_seen || pool.get_total_bytes() != pool.get_idle_bytes())
+    {
+        printf("%s: releasing past the high watermark did not trim\n", name);
+        ok = false;
+    }
+
+    printf("%-12s class(NV21 1080p) = %zu bytes, size classes and watermark trim: %s\n", name, capacity, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main()
+{
+    BufferPoolOptions power_of_two;
+    power_of_two.size_class = BufferPoolOptions::SizeClass::POWER_OF_TWO;
+    BufferPoolOptions geometric;
+    geometric.size_class = BufferPoolOptions::SizeClass::GEOMETRIC;
+    bool classes_ok = checkSizeClasses("POWER_OF_TWO", power_of_two);
+    classes_ok = checkSizeClasses("GEOMETRIC", geometric) && classes_ok;
+    if (!classes_ok)
+    {
+        return 1;
+    }
+
+    // 1080p NV21：Y 平面 + UV 平面，每帧获取并归还两个缓冲区
+    const size_t width = 1920;
+    const size_t height = 1080;
+    const size_t y_size = width * height;
+    const size_t uv_size = width * height / 2;
+    const int frames_per_thread = 200000;
+    const int thread_counts[] = {1, 2, 4, 8, 16};
+
+    BufferPool pool({y_size, uv_size});
+
+    std::cout << "threads  ns/frame  frames/s     allocs(timed)  buffers" << std::endl;
+    for (int threads : thread_counts)
+    {
+        // 预热：让每个线程各自需要的缓冲区和控制块都分配出来
+        {
+            std::vector<BufferPool::Handle> warm;
+            for (int i = 0; i < threads; ++i)
+            {
+                warm.push_back(pool.get_buffer(Buffer::Type::NORMAL, y_size));
+                warm.push_back(pool.get_buffer(Buffer::Type::NORMAL, uv_size));
+            }
+        }
+
+        std::atomic<int> ready{0};
+        std::atomic<bool> go{false};
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&]()
+                                 {
+                ready.fetch_add(1);
+                while (!go.load(std::memory_order_acquire))
+                {
+                }
+                for (int i = 0; i < frames_per_thread; ++i)
+                {
+                    auto y = pool.get_buffer(Buffer::Type::NORMAL, y_size);
+                    auto uv = pool.get_buffer(Buffer::Type::NORMAL, uv_size);
+                    y->get_data()[0] = static_cast<uint8_t>(i);
+                    uv->get_data()[0] = static_cast<uint8_t>(i);
+                } });
+        }
+        while (ready.load() != threads)
+        {
+        }
+
+        size_t allocations_before = g_allocations.load();
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+        auto end = std::chrono::steady_clock::now();
+        size_t allocations = g_allocations.load() - allocations_before;
+
+        double total_ns = std::chrono::duration<double, std::nano>(end - start).count();
+        double total_frames = static_cast<double>(frames_per_thread) * threads;
+        // 每帧的墙钟时间 × 线程数 = 单个线程看到的每帧开销
+        double ns_per_frame = total_ns * threads / total_frames;
+        printf("%7d  %8.1f  %11.0f  %13zu  %7zu\n", threads, ns_per_frame, total_frames / (total_ns / 1e9),
+               allocations, pool.get_allocated_count());
+    }
+
+    return 0;
+}
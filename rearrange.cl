@@ -1,74 +1,84 @@
-// 定义采样器
-constant sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP | CLK_FILTER_NEAREST;
+// 通用 NV21 分块重排：把源图像中的若干矩形搬到输出中的指定位置，其余指定区域填充黑边。
+//
+// 布局在编译时通过 -D 常量给出（每种布局编译一份，程序缓存按编译选项区分）：
+//   NUM_ENTRIES   条目数
+//   ENTRIES       条目列表，每项为 (int8)(src_x, src_y, width, height, dst_x, dst_y, fill, 0)，
+//                 fill 非 0 时忽略 src_x/src_y，用 FILL_Y / FILL_UV 填充该矩形
+//   FILL_Y        填充的 Y 值，默认 0
+//   FILL_UV       填充的 U/V 值，默认 128
+//   REMAP_VEC     每个工作项处理的字节数（8 或 16），默认 16
+// 所有坐标和尺寸都是偶数（NV21 色度按 2x2 采样）。
+//
+// NDRange 为三维：x = 行内第几段，y = 行号（[0, height) 为 Y 行，[height, height * 3 / 2) 为 UV 行），
+// z = 条目序号。同一条目内的工作项走相同分支，没有逐像素的分块判断
 
-__kernel void rearrange_nv21(
-    __read_only image2d_t y_image,       // Y 分量图像
-    __read_only image2d_t uv_image,      // UV 分量图像
-    __global uchar* output,              // 输出图像数据
-    int input_width,                     // 输入图像宽度
-    int input_height,                    // 输入图像高度
-    int output_width,                    // 输出图像宽度
-    int output_height,                   // 输出图像高度
-    int side_margin,                     // 左右及中间黑边宽度
-    int top_bottom_margin                // 上下黑边高度
-) {
-    int x = get_global_id(0); // 当前像素的 x 坐标
-    int y = get_global_id(1); // 当前像素的 y 坐标
+#ifndef FILL_Y
+#define FILL_Y 0
+#endif
 
-    // 计算输出图像的 Y 分量位置
-    int out_y_index = y * output_width + x;
+#ifndef FILL_UV
+#define FILL_UV 128
+#endif
 
-    // 计算输出图像的 UV 分量位置
-    int out_uv_index = output_width * output_height + (y / 2) * output_width + (x / 2) * 2;
+#ifndef REMAP_VEC
+#define REMAP_VEC 16
+#endif
 
-    // 判断是否需要填充黑边
-    int is_black = (x < side_margin || x >= output_width - side_margin ||
-                    y < top_bottom_margin || y >= output_height - top_bottom_margin ||
-                    (x >= side_margin + 1920 && x < side_margin + 1920 + side_margin) ||
-                    (x >= side_margin + 1920 * 2 + side_margin && x < side_margin + 1920 * 2 + side_margin * 2) ||
-                    (x >= side_margin + 1920 * 3 + side_margin * 2 && x < side_margin + 1920 * 3 + side_margin * 3));
+#if REMAP_VEC == 8
+#define VLOAD vload8
+#define VSTORE vstore8
+#define UCHARN uchar8
+#else
+#define VLOAD vload16
+#define VSTORE vstore16
+#define UCHARN uchar16
+#endif
 
-    if (is_black) {
-        // 填充黑边
-        output[out_y_index] = 0; // Y 分量黑边
-        if (x % 2 == 0 && y % 2 == 0) {
-            output[out_uv_index] = 128;     // U 分量黑边
-            output[out_uv_index + 1] = 128; // V 分量黑边
-        }
-    } else {
-        // 计算输入图像的块索引
-        int block_width = 1920; // 每个块的宽度
-        int in_x, in_y;         // 输入图像的像素坐标
-
-        if (x < side_margin + block_width) {
-            // 第 3 块（原图的第 3 块，索引 2）
-            in_x = x - side_margin + block_width * 2;
-        } else if (x < side_margin + block_width * 2 + side_margin) {
-            // 第 4 块（原图的第 4 块，索引 3）
-            in_x = x - side_margin - block_width - side_margin + block_width * 3;
-        } else if (x < side_margin + block_width * 3 + side_margin * 2) {
-            // 第 1 块（原图的第 1 块，索引 0）
-            in_x = x - side_margin - block_width * 2 - side_margin * 2 + block_width * 0;
-        } else {
-            // 第 2 块（原图的第 2 块，索引 1）
-            in_x = x - side_margin - block_width * 3 - side_margin * 3 + block_width * 1;
-        }
+__constant int8 entries[NUM_ENTRIES] = { ENTRIES };
 
-        in_y = y - top_bottom_margin; // 输入图像的 y 坐标
+__kernel void remap_nv21(
+    __global const uchar* src_y,  // 源 Y 平面
+    __global const uchar* src_uv, // 源 UV 平面
+    int src_step,                 // 源行距（Y 与 UV 相同）
+    __global uchar* dst_y,        // 输出 Y 平面
+    __global uchar* dst_uv,       // 输出 UV 平面
+    int dst_step                  // 输出行距（Y 与 UV 相同）
+)
+{
+    int x = get_global_id(0) * REMAP_VEC;
+    int row = get_global_id(1);
+    int8 e = entries[get_global_id(2)];
+    int width = e.s2;
+    int height = e.s3;
 
-        // 读取 Y 分量
-        float y_value = read_imagef(y_image, sampler, (int2)(in_x, in_y)).x * 255.0f;
+    if (x >= width || row >= height * 3 / 2) return;
 
-        // 读取 UV 分量
-        float2 uv_value = read_imagef(uv_image, sampler, (int2)(in_x / 2, in_y / 2)).xy * 255.0f;
+    int is_y = row < height;
+    int plane_row = is_y ? row : row - height;
+    int dst_row = is_y ? e.s5 + plane_row : e.s5 / 2 + plane_row;
+    __global uchar* out = (is_y ? dst_y : dst_uv) + dst_row * dst_step + e.s4 + x;
+    int n = min(REMAP_VEC, width - x);
 
-        // 复制 Y 分量
-        output[out_y_index] = (uchar)y_value;
+    if (e.s6) {
+        // 黑边
+        uchar value = is_y ? FILL_Y : FILL_UV;
+        if (n == REMAP_VEC) {
+            VSTORE((UCHARN)(value), 0, out);
+        } else {
+            for (int i = 0; i < n; i++) {
+                out[i] = value;
+            }
+        }
+        return;
+    }
 
-        // 复制 UV 分量
-        if (x % 2 == 0 && y % 2 == 0) {
-            output[out_uv_index] = (uchar)uv_value.x;         // U 分量
-            output[out_uv_index + 1] = (uchar)uv_value.y;     // V 分量
+    int src_row = is_y ? e.s1 + plane_row : e.s1 / 2 + plane_row;
+    __global const uchar* in = (is_y ? src_y : src_uv) + src_row * src_step + e.s0 + x;
+    if (n == REMAP_VEC) {
+        VSTORE(VLOAD(0, in), 0, out);
+    } else {
+        for (int i = 0; i < n; i++) {
+            out[i] = in[i];
         }
     }
-}
\ No newline at end of file
+}
@@ -162,6 +162,101 @@ __kernel void resizeLN(__global const uchar * srcptr, int src_step, int src_offs
     }
 }
 
+#elif defined INTER_LINEAR_TILED
+
+// 分块可分离双线性（与 INTER_LINEAR_INTEGER 的 resizeLN 逐位一致，使用同一张系数表）。
+// 一个工作组输出 TILE_W x TILE_H 的块，工作组尺寸必须正好是 TILE_W x TILE_H：
+//   1. 块内每个输出行用到的两条源行（共 2 * TILE_H 条）中，块覆盖的列区间以 16 字节为单位合并读入局部内存，
+//      每个字节只从全局内存读一次；
+//   2. 水平方向：对每条源行、每个输出列做定点插值，结果写入局部内存；
+//   3. 垂直方向：每个工作项取两条水平结果插值，按 uchar3 / uchar4 写出一个像素。
+// 每条源行在局部内存中最多 TILE_SPAN 字节，主机端保证 ceil(TILE_W * ifx) + 3 个像素放得下
+
+#ifndef TILE_W
+#define TILE_W 32
+#endif
+#ifndef TILE_H
+#define TILE_H 8
+#endif
+#ifndef TILE_SPAN
+#define TILE_SPAN 1024
+#endif
+
+#if CN != 3
+#define loadlocal(addr)  *(__local const T *)(addr)
+#else
+#define loadlocal(addr)  vload3(0, (__local const T1 *)(addr))
+#endif
+
+__attribute__((reqd_work_group_size(TILE_W, TILE_H, 1)))
+__kernel void resizeLN_tiled(__global const uchar * srcptr, int src_step, int src_offset, int src_rows, int src_cols,
+                             __global uchar * dstptr, int dst_step, int dst_offset, int dst_rows, int dst_cols,
+                             __global const uchar * buffer)
+{
+    __local uchar rows[2 * TILE_H * TILE_SPAN];
+    __local WT hbuf[2 * TILE_H * TILE_W];
+
+    int lx = get_local_id(0), ly = get_local_id(1);
+    int lid = mad24(ly, TILE_W, lx);
+    int dx0 = get_group_id(0) * TILE_W, dy0 = get_group_id(1) * TILE_H;
+    // 尾部工作组中越界的工作项按最后一行 / 列参与装载和屏障，只是不写出
+    int dx = min(dx0 + lx, dst_cols - 1), dy = min(dy0 + ly, dst_rows - 1);
+
+    __global const int * xofs = (__global const int *)(buffer), * yofs = xofs + dst_cols;
+    __global const short * ialpha = (__global const short *)(yofs + dst_rows);
+    __global const short * ibeta = ialpha + (dst_cols << 1);
+
+    // 1. 块覆盖的源列区间 [x0, x0 + span)，越过行尾的部分取最后一个像素（对应的权重为 0）
+    int x0 = xofs[dx0];
+    int span = (xofs[min(dx0 + TILE_W, dst_cols) - 1] + 2 - x0) * TSIZE;
+    int row_bytes = src_cols * TSIZE;
+    int chunks = (span + 15) >> 4;
+    for (int i = lid; i < 2 * TILE_H * chunks; i += TILE_W * TILE_H)
+    {
+        int slot = i / chunks, chunk = i - slot * chunks;
+        int sy = clamp(yofs[min(dy0 + (slot >> 1), dst_rows - 1)] + (slot & 1), 0, src_rows - 1);
+        __global const uchar * src_row = srcptr + mad24(sy, src_step, src_offset);
+        __local uchar * local_row = rows + slot * TILE_SPAN;
+        int bx = mad24(x0, TSIZE, chunk << 4);
+        if (bx + 16 <= row_bytes)
+        {
+            vstore16(vload16(0, src_row + bx), 0, local_row + (chunk << 4));
+        }
+        else
+        {
+            for (int j = 0; j < 16; j++)
+            {
+                int b = bx + j;
+                int px = min(b / TSIZE, src_cols - 1);
+                local_row[(chunk << 4) + j] = src_row[mad24(px, TSIZE, b % TSIZE)];
+            }
+        }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    // 2. 水平插值：每个工作项负责本列的两个槽位（ly 与 ly + TILE_H）
+    int sx = xofs[dx] - x0;
+    short a0 = ialpha[dx << 1], a1 = ialpha[(dx << 1) + 1];
+    for (int slot = ly; slot < 2 * TILE_H; slot += TILE_H)
+    {
+        __local const uchar * local_row = rows + slot * TILE_SPAN + sx * TSIZE;
+        WT data0 = CONVERT_TO_WT(loadlocal(local_row));
+        WT data1 = CONVERT_TO_WT(loadlocal(local_row + TSIZE));
+        hbuf[mad24(slot, TILE_W, lx)] = (data0 * a0 + data1 * a1) >> 4;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    // 3. 垂直插值
+    if (dx0 + lx < dst_cols && dy0 + ly < dst_rows)
+    {
+        short b0 = ibeta[dy << 1], b1 = ibeta[(dy << 1) + 1];
+        WT h0 = hbuf[mad24(ly << 1, TILE_W, lx)];
+        WT h1 = hbuf[mad24((ly << 1) + 1, TILE_W, lx)];
+        WT val = ((h0 * b0) >> 16) + ((h1 * b1) >> 16);
+        storepix(CONVERT_TO_DT((val + 2) >> 2), dstptr + mad24(dy, dst_step, mad24(dx, TSIZE, dst_offset)));
+    }
+}
+
 #elif defined INTER_LINEAR
 
 __kernel void resizeLN(__global const uchar * srcptr, int src_step, int src_offset, int src_rows, int src_cols,
@@ -0,0 +1,46 @@
+// 定点双线性缩放共用的源坐标计算。resize_nvx.cl、resize_rgb_bilinear.cl 用 #include 引入
+// （ProgramCache 读入时展开），ResizeNvx.h 的主机端参考实现也直接包含它，三处逐位一致：
+//   scale = (src << 16) / dst，f = d * scale + scale / 2 - 0.5（16.16 定点），
+//   s = f >> 16，权重取小数部分的高 RESIZE_COEF_BITS 位；s < 0 时取 0 且权重为 0，s + 1 越界时取最后一个像素且权重为 0
+
+#ifndef RESIZE_COORD_CL
+#define RESIZE_COORD_CL
+
+#define RESIZE_COEF_BITS 11
+#define RESIZE_COEF_ONE (1 << RESIZE_COEF_BITS)
+
+#ifdef __OPENCL_VERSION__
+#define RESIZE_COORD_INLINE inline
+#else
+#define RESIZE_COORD_INLINE static inline
+#endif
+
+// 第 d 个输出像素的源坐标整数部分 s 与权重 w
+RESIZE_COORD_INLINE void resize_fixed_coord(int d, int scale, int src_size, int *s, int *w)
+{
+    int f = d * scale + (scale >> 1) - (1 << 15);
+    *s = f >> 16;
+    *w = (f >> (16 - RESIZE_COEF_BITS)) & (RESIZE_COEF_ONE - 1);
+    if (*s < 0)
+    {
+        *s = 0;
+        *w = 0;
+    }
+    if (*s >= src_size - 1)
+    {
+        *s = src_size - 1;
+        *w = 0;
+    }
+}
+
+#ifdef __OPENCL_VERSION__
+// 内核里的写法：(s, w) 打包成 int2
+inline int2 resize_source_coord(int d, int scale, int src_size)
+{
+    int s, w;
+    resize_fixed_coord(d, scale, src_size, &s, &w);
+    return (int2)(s, w);
+}
+#endif
+
+#endif
@@ -0,0 +1,99 @@
+// NV21 / NV12 缩放（双线性，半像素中心对齐）。
+//
+// 亮度和色度分两次启动，各自按输出平面的分辨率铺 NDRange，每个工作项只写自己的输出，没有写冲突：
+//   亮度：一个工作项输出 LUMA_VEC 个连续像素
+//   色度：UV 平面按 (dst_w / 2) x (dst_h / 2) 的色度网格独立计算坐标（而不是亮度坐标除以 2），
+//         一个工作项输出一对交织的 UV；NV21 与 NV12 只是 U、V 的顺序不同，缩放方式相同
+//
+// 整数路径（resize_nvx_luma / resize_nvx_chroma）与主机端参考实现 resize_nvx_reference 逐位一致：
+//   源坐标与权重见 resize_coord.cl（与 resize_rgb_bilinear.cl、主机端共用），
+//   输出 = (横向插值 * 纵向权重 + 舍入) >> (2 * RESIZE_COEF_BITS)
+//
+// 采样器路径（resize_nvx_image，每个平面启动一次）用硬件双线性滤波，精度由硬件决定，
+// 直接读写归一化的浮点值，不做 *255 / 255 的往返
+
+#include "resize_coord.cl"
+
+#ifndef LUMA_VEC
+#define LUMA_VEC 4
+#endif
+
+__kernel void resize_nvx_luma(
+    __global const uchar* src, int src_step, int src_offset, int src_w, int src_h,
+    __global uchar* dst, int dst_step, int dst_offset, int dst_w, int dst_h,
+    int scale_x, int scale_y)
+{
+    int dx0 = get_global_id(0) * LUMA_VEC;
+    int dy = get_global_id(1);
+    if (dx0 >= dst_w || dy >= dst_h) return;
+
+    int2 sy = resize_source_coord(dy, scale_y, src_h);
+    __global const uchar* row0 = src + mad24(sy.x, src_step, src_offset);
+    __global const uchar* row1 = row0 + (sy.y ? src_step : 0);
+    int wy0 = RESIZE_COEF_ONE - sy.y, wy1 = sy.y;
+
+    uchar out[LUMA_VEC];
+    for (int i = 0; i < LUMA_VEC; i++)
+    {
+        int2 sx = resize_source_coord(min(dx0 + i, dst_w - 1), scale_x, src_w);
+        int x1 = sx.x + (sx.y ? 1 : 0);
+        int wx0 = RESIZE_COEF_ONE - sx.y, wx1 = sx.y;
+        int top = row0[sx.x] * wx0 + row0[x1] * wx1;
+        int bottom = row1[sx.x] * wx0 + row1[x1] * wx1;
+        out[i] = (uchar)((top * wy0 + bottom * wy1 + (1 << (2 * RESIZE_COEF_BITS - 1))) >> (2 * RESIZE_COEF_BITS));
+    }
+
+    __global uchar* dst_row = dst + mad24(dy, dst_step, dst_offset) + dx0;
+    if (dx0 + LUMA_VEC <= dst_w)
+    {
+#if LUMA_VEC == 4
+        vstore4((uchar4)(out[0], out[1], out[2], out[3]), 0, dst_row);
+#else
+        for (int i = 0; i < LUMA_VEC; i++) dst_row[i] = out[i];
+#endif
+    }
+    else
+    {
+        for (int i = 0; i < dst_w - dx0; i++) dst_row[i] = out[i];
+    }
+}
+
+// 色度平面：src_cw x src_ch 对交织的 UV -> dst_cw x dst_ch 对
+__kernel void resize_nvx_chroma(
+    __global const uchar* src, int src_step, int src_offset, int src_cw, int src_ch,
+    __global uchar* dst, int dst_step, int dst_offset, int dst_cw, int dst_ch,
+    int scale_x, int scale_y)
+{
+    int dx = get_global_id(0);
+    int dy = get_global_id(1);
+    if (dx >= dst_cw || dy >= dst_ch) return;
+
+    int2 sy = resize_source_coord(dy, scale_y, src_ch);
+    int2 sx = resize_source_coord(dx, scale_x, src_cw);
+    __global const uchar* row0 = src + mad24(sy.x, src_step, src_offset);
+    __global const uchar* row1 = row0 + (sy.y ? src_step : 0);
+    int x0 = sx.x << 1, x1 = (sx.x + (sx.y ? 1 : 0)) << 1;
+    int wx0 = RESIZE_COEF_ONE - sx.y, wx1 = sx.y, wy0 = RESIZE_COEF_ONE - sy.y, wy1 = sy.y;
+
+    int2 p00 = convert_int2(vload2(0, row0 + x0)), p01 = convert_int2(vload2(0, row0 + x1));
+    int2 p10 = convert_int2(vload2(0, row1 + x0)), p11 = convert_int2(vload2(0, row1 + x1));
+    int2 top = p00 * wx0 + p01 * wx1;
+    int2 bottom = p10 * wx0 + p11 * wx1;
+    int2 value = (top * wy0 + bottom * wy1 + (1 << (2 * RESIZE_COEF_BITS - 1))) >> (2 * RESIZE_COEF_BITS);
+    vstore2(convert_uchar2(value), 0, dst + mad24(dy, dst_step, dst_offset) + (dx << 1));
+}
+
+// 采样器路径：亮度为 CL_R、色度为 CL_RG 的 CL_UNORM_INT8 图像
+__constant sampler_t nvx_sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_LINEAR;
+
+// 亮度、色度平面各启动一次
+__kernel void resize_nvx_image(__read_only image2d_t src, __write_only image2d_t dst, float ifx, float ify)
+{
+    int dx = get_global_id(0);
+    int dy = get_global_id(1);
+    if (dx >= get_image_width(dst) || dy >= get_image_height(dst)) return;
+
+    // 非归一化坐标下像素中心在 x + 0.5
+    float2 coord = (float2)((dx + 0.5f) * ifx, (dy + 0.5f) * ify);
+    write_imagef(dst, (int2)(dx, dy), read_imagef(src, nvx_sampler, coord));
+}
@@ -9,6 +9,9 @@ __kernel void resize_rgb_bilinear(
     int x = get_global_id(0);
     int y = get_global_id(1);
 
+    // 全局尺寸按工作组取整后的尾部工作项
+    if (x >= output_width || y >= output_height) return;
+
     float x_ratio = (float)(input_width - 1) / output_width;
     float y_ratio = (float)(input_height - 1) / output_height;
 
@@ -33,4 +36,65 @@ __kernel void resize_rgb_bilinear(
 
         output[(y * output_width + x) * 3 + i] = (uchar)value;
     }
+}
+
+// 定点双线性（替代上面的浮点逐通道版本）：半像素中心对齐，坐标为 16.16 定点，权重 11 位，
+// 边界像素按最后一行 / 列钳位；每个工作项输出 PIX_PER_WI 个连续像素，按 vload3 / vload4 读、vstore3 / vstore4 写。
+// CN = 3 为 RGB / BGR（通道顺序不影响结果），CN = 4 为 RGBA；行距以字节计
+
+#ifndef CN
+#define CN 3
+#endif
+
+#ifndef PIX_PER_WI
+#define PIX_PER_WI 4
+#endif
+
+#include "resize_coord.cl"
+
+#if CN == 4
+#define PIXEL_INT int4
+#define LOAD_PIXEL(p, x) convert_int4(vload4(x, p))
+#define STORE_PIXEL(v, p, x) vstore4(convert_uchar4(v), x, p)
+#else
+#define PIXEL_INT int3
+#define LOAD_PIXEL(p, x) convert_int3(vload3(x, p))
+#define STORE_PIXEL(v, p, x) vstore3(convert_uchar3(v), x, p)
+#endif
+
+__kernel void resize_rgb_bilinear_fixed(
+    __global const uchar* input,
+    int input_step,
+    __global uchar* output,
+    int output_step,
+    int input_width,
+    int input_height,
+    int output_width,
+    int output_height)
+{
+    int x0 = get_global_id(0) * PIX_PER_WI;
+    int y = get_global_id(1);
+
+    // 全局尺寸按工作组取整后的尾部工作项
+    if (x0 >= output_width || y >= output_height) return;
+
+    int scale_x = (input_width << 16) / output_width;
+    int scale_y = (input_height << 16) / output_height;
+    int2 sy = resize_source_coord(y, scale_y, input_height);
+    __global const uchar* row0 = input + sy.x * input_step;
+    __global const uchar* row1 = row0 + (sy.y ? input_step : 0);
+    int wy0 = RESIZE_COEF_ONE - sy.y, wy1 = sy.y;
+    __global uchar* out_row = output + y * output_step;
+
+    int n = min(PIX_PER_WI, output_width - x0);
+    for (int i = 0; i < n; i++)
+    {
+        int2 sx = resize_source_coord(x0 + i, scale_x, input_width);
+        int x1 = sx.x + (sx.y ? 1 : 0);
+        int wx0 = RESIZE_COEF_ONE - sx.y, wx1 = sx.y;
+        PIXEL_INT top = LOAD_PIXEL(row0, sx.x) * wx0 + LOAD_PIXEL(row0, x1) * wx1;
+        PIXEL_INT bottom = LOAD_PIXEL(row1, sx.x) * wx0 + LOAD_PIXEL(row1, x1) * wx1;
+        PIXEL_INT value = (top * wy0 + bottom * wy1 + (1 << (2 * RESIZE_COEF_BITS - 1))) >> (2 * RESIZE_COEF_BITS);
+        STORE_PIXEL(value, out_row, x0 + i);
+    }
 }
\ No newline at end of file
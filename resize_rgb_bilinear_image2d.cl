@@ -8,6 +8,9 @@ __kernel void resize_rgb_bilinear(
     int x = get_global_id(0);
     int y = get_global_id(1);
 
+    // 全局尺寸按工作组取整后的尾部工作项
+    if (x >= get_image_width(output) || y >= get_image_height(output)) return;
+
     // 计算输入图像中的对应坐标
     float in_x = (float)x * scale_x;
     float in_y = (float)y * scale_y;
@@ -0,0 +1,262 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstdint>
+#include <memory>
+#include <CL/cl.h>
+
+#include "ProgramCache.h"
+#include "ResizeNvx.h"
+#include "Stream.h"
+#include "Y4m.h"
+#include "FrameSink.h"
+
+using namespace bos::mm;
+
+// 检查 OpenCL 错误
+#define CHECK_CL_ERROR(err)                                                           \
+    if (err != CL_SUCCESS)                                                            \
+    {                                                                                 \
+        std::cerr << "OpenCL error: " << err << " at line " << __LINE__ << std::endl; \
+        exit(1);                                                                      \
+    }
+
+// 多帧原始 NV21 文件的顺序读取；文件帧数不足 frames 时从头循环
+class FrameFile
+{
+public:
+    FrameFile(const std::string &path, size_t frame_bytes, size_t frames) : file(path, std::ios::binary), frame_bytes(frame_bytes), frames(frames)
+    {
+        file.seekg(0, std::ios::end);
+        file_frames = file ? static_cast<size_t>(file.tellg()) / frame_bytes : 0;
+    }
+
+    size_t get_file_frames() const { return file_frames; }
+
+    bool read(uint8_t *data, size_t index)
+    {
+        if (index >= frames || file_frames == 0)
+        {
+            return false;
+        }
+        if (index % file_frames == 0)
+        {
+            file.clear();
+            file.seekg(0);
+        }
+        return static_cast<bool>(file.read(reinterpret_cast<char *>(data), frame_bytes));
+    }
+
+private:
+    std::ifstream file;
+    size_t frame_bytes;
+    size_t frames;
+    size_t file_frames = 0;
+};
+
+// 用法：streambench [gpu|cpu|all] [file.nv21 width height [out_width out_height [frames [out.nv21]]]]
+//       streambench [gpu|cpu|all] file.y4m [out_width out_height [out.y4m]]
+// 原始 NV21 默认把 input1.nv21（960x540）放大两倍，共 300 帧，文件帧数不足时循环。
+// Y4M（4:2:0）的宽高取自文件头，处理全部帧；输入为 "-" 时读标准输入，只跑一次 3 个槽的流水线。
+// 给出 out.y4m 时最后一次运行的结果写成 Y4M，"-" 表示标准输出（可直接管道给编码器，报告改写到标准错误）。
+// 给出 out.nv21 时最后一次运行的结果经 FrameSink 异步写出，输出 Image 直接交给写盘，写完才回到池中
+int main(int argc, char **argv)
+{
+    cl_platform_id platform;
+    cl_device_id device;
+    cl_int err = clGetPlatformIDs(1, &platform, NULL);
+    CHECK_CL_ERROR(err);
+    cl_device_type device_type = CL_DEVICE_TYPE_GPU;
+    int arg = 1;
+    if (argc > arg && std::string(argv[arg]) == "cpu")
+    {
+        device_type = CL_DEVICE_TYPE_CPU;
+        ++arg;
+    }
+    else if (argc > arg && std::string(argv[arg]) == "all")
+    {
+        device_type = CL_DEVICE_TYPE_ALL;
+        ++arg;
+    }
+    else if (argc > arg && std::string(argv[arg]) == "gpu")
+    {
+        ++arg;
+    }
+    err = clGetDeviceIDs(platform, device_type, 1, &device, NULL);
+    CHECK_CL_ERROR(err);
+
+    std::string path = argc > arg ? argv[arg] : "input1.nv21";
+    bool y4m = path == "-" || (path.size() > 4 && path.compare(path.size() - 4, 4, ".y4m") == 0);
+    std::unique_ptr<Y4mReader> y4m_input;
+    size_t width = 960, height = 540, frames = 300;
+    std::string output_path;
+    int next = arg + 1;
+    if (y4m)
+    {
+        try
+        {
+            y4m_input = std::make_unique<Y4mReader>(path);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        if (y4m_input->get_header().format != Image::Format::YUV420)
+        {
+            std::cerr << path << " is not 4:2:0" << std::endl;
+            return 1;
+        }
+        width = y4m_input->get_header().width;
+        height = y4m_input->get_header().height;
+        frames = SIZE_MAX;
+    }
+    else if (argc > arg + 2)
+    {
+        width = std::strtoul(argv[arg + 1], NULL, 10);
+        height = std::strtoul(argv[arg + 2], NULL, 10);
+        next = arg + 3;
+    }
+    size_t out_width = argc > next + 1 ? std::strtoul(argv[next], NULL, 10) : width * 2;
+    size_t out_height = argc > next + 1 ? std::strtoul(argv[next + 1], NULL, 10) : height * 2;
+    if (argc > next + 2)
+    {
+        if (y4m)
+        {
+            output_path = argv[next + 2];
+        }
+        else
+        {
+            frames = std::strtoul(argv[next + 2], NULL, 10);
+            output_path = argc > next + 3 ? argv[next + 3] : "";
+        }
+    }
+    if (width == 0 || height == 0 || out_width == 0 || out_height == 0 || (width | height | out_width | out_height) & 1)
+    {
+        std::cerr << "Width and height must be positive and even" << std::endl;
+        return 1;
+    }
+    size_t frame_bytes = width * height * 3 / 2;
+    size_t out_bytes = out_width * out_height * 3 / 2;
+
+    // 结果写到标准输出时，报告改写到标准错误
+    FILE *report = output_path == "-" ? stderr : stdout;
+    std::unique_ptr<Y4mWriter> y4m_output;
+    std::unique_ptr<FrameSink> raw_output;
+    if (!output_path.empty() && !y4m)
+    {
+        try
+        {
+            raw_output = std::make_unique<FrameSink>(output_path);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+    else if (!output_path.empty())
+    {
+        Y4mHeader header = y4m_input->get_header();
+        header.width = out_width;
+        header.height = out_height;
+        y4m_output = std::make_unique<Y4mWriter>(output_path, header);
+    }
+
+    cl_context context = clCreateContext(NULL, 1, &device, NULL, NULL, &err);
+    CHECK_CL_ERROR(err);
+    Nv21Resizer resizer(context, device);
+    BufferPool pool({});
+
+    auto compute = [&](cl_command_queue queue, StreamFrame &frame, cl_event *event)
+    {
+        return resizer.resize(queue, stream_target(frame.input, frame.src), (int)width, (int)height,
+                              stream_target(frame.output, frame.dst), (int)out_width, (int)out_height, event);
+    };
+
+    // 同步（1 个槽）的每帧校验和作为基准，流水线的输出必须逐帧一致；管道输入只能读一遍
+    std::vector<unsigned long long> reference;
+    std::vector<size_t> slot_counts = {1, 2, 3, 4};
+    if (path == "-")
+    {
+        slot_counts = {3};
+    }
+    double sync_fps = 0;
+    fprintf(report, "%s: %zux%zu -> %zux%zu", path.c_str(), width, height, out_width, out_height);
+    fprintf(report, y4m ? ", all frames\n" : ", %zu frames\n", frames);
+    fprintf(report, "slots  frames   fps      ms/frame  speedup  upload(ms)  compute(ms)  download(ms)  match\n");
+    for (size_t slots : slot_counts)
+    {
+        std::unique_ptr<FrameFile> file;
+        if (y4m)
+        {
+            if (slots != slot_counts.front() && !y4m_input->rewind())
+            {
+                std::cerr << "Failed to rewind " << path << std::endl;
+                return 1;
+            }
+        }
+        else
+        {
+            file = std::make_unique<FrameFile>(path, frame_bytes, frames);
+            if (file->get_file_frames() == 0)
+            {
+                std::cerr << "Failed to read " << path << std::endl;
+                return 1;
+            }
+        }
+        StreamPipeline pipeline(context, device, Image::Format::NV21, width, height, Image::Format::NV21, out_width, out_height, pool, slots);
+
+        // 预热一帧（内容无关）：编译、工作组调优不计入
+        err = pipeline.run([](Image &, size_t index)
+                           { return index == 0; },
+                           compute, [](const std::shared_ptr<Image> &, size_t) {});
+        CHECK_CL_ERROR(err);
+
+        bool last = slots == slot_counts.back();
+        std::vector<unsigned long long> sums;
+        StreamStats stats;
+        try
+        {
+            err = pipeline.run([&](Image &input, size_t index)
+                               { return y4m ? y4m_input->read_frame(input) : file->read(input.get_data(), index); },
+                               compute, [&](const std::shared_ptr<Image> &output, size_t)
+                               {
+                                   sums.push_back(program_cache_fnv1a(1469598103934665603ULL, output->get_data(), out_bytes));
+                                   if (last && ((y4m_output && !y4m_output->write_frame(*output)) || (raw_output && !raw_output->write(output))))
+                                   {
+                                       throw std::runtime_error("Failed to write " + output_path);
+                                   }
+                               },
+                               &stats);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        CHECK_CL_ERROR(err);
+
+        if (slots == 1)
+        {
+            reference = sums;
+            sync_fps = stats.fps();
+        }
+        size_t n = stats.frames ? stats.frames : 1;
+        fprintf(report, "%5zu  %6zu  %7.1f  %8.3f  %7.2f  %10.3f  %11.3f  %12.3f  %s\n", slots, stats.frames, stats.fps(), stats.seconds * 1e3 / n,
+                sync_fps > 0 ? stats.fps() / sync_fps : 0.0, stats.upload_ms / n, stats.compute_ms / n, stats.download_ms / n,
+                reference.empty() || sums == reference ? "yes" : "NO");
+    }
+    y4m_output.reset();
+    if (raw_output && !raw_output->flush())
+    {
+        std::cerr << "Failed to write " << output_path << std::endl;
+        return 1;
+    }
+    raw_output.reset();
+
+    clReleaseContext(context);
+    return 0;
+}
@@ -3,6 +3,9 @@
 #include <fstream>
 #include <CL/cl.h>
 
+#include "ProgramCache.h"
+#include "WorkSizeTuner.h"
+
 // 检查 OpenCL 错误
 #define CHECK_CL_ERROR(err)                                                           \
     if (err != CL_SUCCESS)                                                            \
@@ -59,21 +62,9 @@ int main()
     queue = clCreateCommandQueueWithProperties(context, device, properties, &err);
     CHECK_CL_ERROR(err);
 
-    // 读取内核文件
-    std::string kernelSource = readFile("compose_nv21_image2d.cl");
-    const char *kernelSourcePtr = kernelSource.c_str();
-
-    // 创建程序对象
-    program = clCreateProgramWithSource(context, 1, &kernelSourcePtr, NULL, &err);
+    // 创建程序对象（命中磁盘缓存时直接加载二进制）
+    program = program_cache_build(context, device, "compose_nv21_image2d.cl", NULL, NULL, &err);
     CHECK_CL_ERROR(err);
-    err = clBuildProgram(program, 1, &device, NULL, NULL, NULL);
-    if (err != CL_SUCCESS)
-    {
-        char buildLog[16384];
-        clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, sizeof(buildLog), buildLog, NULL);
-        std::cerr << "Build log: " << buildLog << std::endl;
-        exit(1);
-    }
 
     // 创建内核对象
     kernel = clCreateKernel(program, "compose_nv21", &err);
@@ -184,7 +175,7 @@ int main()
         size_t global_size[2] = {static_cast<size_t>(output_width), static_cast<size_t>(height)};
 
         // 运行内核
-        err = clEnqueueNDRangeKernel(queue, kernel, 2, NULL, global_size, NULL, 0, NULL, &event);
+        err = bos::mm::enqueue_tuned(queue, kernel, 2, global_size, &event);
         CHECK_CL_ERROR(err);
 
         // 等待内核执行完成
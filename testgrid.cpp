@@ -3,77 +3,61 @@
 #include <fstream>
 #include <vector>
 #include <chrono>
+#include <memory>
 
-const char *rearrangeKernel = R"(
-__kernel void rearrange_nv21(
-    __global const uchar* inputY,   
-    __global const uchar* inputUV,  
-    __global uchar* outputY,       
-    __global uchar* outputUV,       
-    int inputWidth,                
-    int inputHeight)                
-{
-    int x = get_global_id(0);
-    int y = get_global_id(1);
-
-    int outputWidth = inputWidth / 2;   
-    int outputHeight = inputHeight * 2; 
-
-    // 处理 Y 分量
-    if (y < inputHeight) {
-        int srcX = x;
-        int srcY = y;
-        outputY[y * outputWidth + x] = inputY[srcY * inputWidth + srcX];
-    } else {
-        int srcX = x + outputWidth;
-        int srcY = y - inputHeight;
-        outputY[y * outputWidth + x] = inputY[srcY * inputWidth + srcX];
-    }
-
-    // 处理 UV 分量
-    if (y % 2 == 0) {
-        int uvX = x / 2;
-        int uvY = y / 2;
-
-        if (y < inputHeight) {
-            int srcIndexUV = uvY * inputWidth + uvX * 2;
-            int dstIndexUV = uvY * outputWidth + uvX * 2;
-            
-            outputUV[dstIndexUV] = inputUV[srcIndexUV];     // V 分量
-            outputUV[dstIndexUV + 1] = inputUV[srcIndexUV + 1]; // U 分量
-        } else {
-            int srcIndexUV = (uvY - inputHeight / 2) * inputWidth + (uvX + outputWidth / 2) * 2; 
-            int dstIndexUV = uvY * outputWidth + uvX * 2; 
-            
-            outputUV[dstIndexUV] = inputUV[srcIndexUV];     // V 分量
-            outputUV[dstIndexUV + 1] = inputUV[srcIndexUV + 1]; // U 分量
-        }
-    }
-}
-)";
+#include "ProgramCache.h"
+#include "Compose.h"
+#include "FrameSink.h"
+#include "Y4m.h"
 
+using namespace bos::mm;
 
+// Paths ending in .y4m, or "-" for stdin / stdout, are YUV4MPEG2 streams
+static bool isY4m(const std::string &path)
+{
+    return path == "-" || (path.size() > 4 && path.compare(path.size() - 4, 4, ".y4m") == 0);
+}
 
 void rearrangeNV21(const std::string &inputFile, const std::string &outputFile, int width, int height)
 {
-    // Calculate sizes
-    const size_t yPlaneSize = width * height;
-    const size_t uvPlaneSize = width * height / 2;
-    const size_t totalSize = yPlaneSize + uvPlaneSize;
-
-    // Read input NV21 file
-    std::ifstream inFile(inputFile, std::ios::binary);
-    if (!inFile)
+    // A Y4M input carries its own geometry, which overrides width x height; every frame is rearranged until the end of the stream
+    std::unique_ptr<Y4mReader> reader;
+    Y4mHeader header;
+    if (isY4m(inputFile))
     {
-        throw std::runtime_error("Failed to open input file: " + inputFile);
+        reader = std::make_unique<Y4mReader>(inputFile);
+        header = reader->get_header();
+        if (header.format != Image::Format::YUV420 || header.width % 4 != 0)
+        {
+            throw std::runtime_error(inputFile + " must be 4:2:0 with a width divisible by 4");
+        }
+        width = static_cast<int>(header.width / 2);
+        height = static_cast<int>(header.height * 2);
     }
-    std::vector<unsigned char> nv21Data(totalSize);
-    inFile.read(reinterpret_cast<char *>(nv21Data.data()), totalSize);
-    inFile.close();
 
-    // Split Y and UV planes
-    std::vector<unsigned char> yPlane(nv21Data.begin(), nv21Data.begin() + yPlaneSize);
-    std::vector<unsigned char> uvPlane(nv21Data.begin() + yPlaneSize, nv21Data.end());
+    // Y and UV live in one contiguous frame buffer, read from the file in a single call.
+    // The input is (width * 2) x (height / 2); its halves are stacked into width x height
+    const size_t totalSize = static_cast<size_t>(width) * height * 3 / 2;
+    BufferPool pool({totalSize});
+    Image input(Image::Format::NV21, width * 2, height / 2, pool);
+
+    if (reader)
+    {
+        if (!reader->read_frame(input))
+        {
+            throw std::runtime_error(inputFile + " has no frame");
+        }
+    }
+    else
+    {
+        std::ifstream inFile(inputFile, std::ios::binary);
+        if (!inFile)
+        {
+            throw std::runtime_error("Failed to open input file: " + inputFile);
+        }
+        inFile.read(reinterpret_cast<char *>(input.get_data()), input.get_size());
+        inFile.close();
+    }
 
     // Prepare OpenCL
     std::vector<cl::Platform> platforms;
@@ -90,65 +74,89 @@ void rearrangeNV21(const std::string &inputFile, const std::string &outputFile,
     cl_queue_properties properties[] = {CL_QUEUE_PROPERTIES, CL_QUEUE_PROFILING_ENABLE, 0};
     cl::CommandQueue queue(context, device, properties);
 
-    // Create buffers
-    cl::Buffer inputYBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, yPlaneSize, yPlane.data());
-    cl::Buffer outputYBuffer(context, CL_MEM_WRITE_ONLY, yPlaneSize);
-    cl::Buffer inputUVBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, uvPlaneSize, uvPlane.data());
-    cl::Buffer outputUVBuffer(context, CL_MEM_WRITE_ONLY, uvPlaneSize);
-
-    cl::Program::Sources sources;
-    sources.push_back({rearrangeKernel, strlen(rearrangeKernel)});
-    cl::Program program(context, sources);
-    program.build({device});
-
-    cl::Kernel kernel(program, "rearrange_nv21");
-
-    kernel.setArg(0, inputYBuffer);
-    kernel.setArg(1, inputUVBuffer);
-    kernel.setArg(2, outputYBuffer);
-    kernel.setArg(3, outputUVBuffer);
-    kernel.setArg(4, width * 2);
-    kernel.setArg(5, height / 2);
-
-    // Launch kernels and profile execution time
-    cl::Event event;
-    queue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(width, height), cl::NullRange, nullptr, &event);
-    queue.finish();
-
-    // Read back results
-    std::vector<unsigned char> outputYPlane(yPlaneSize);
-    std::vector<unsigned char> outputUVPlane(uvPlaneSize);
-
-    queue.enqueueReadBuffer(outputYBuffer, CL_TRUE, 0, yPlaneSize, outputYPlane.data());
-    queue.enqueueReadBuffer(outputUVBuffer, CL_TRUE, 0, uvPlaneSize, outputUVPlane.data());
-
-    // Combine Y and UV planes into output buffer
-    std::vector<unsigned char> outputNV21(totalSize);
-    std::copy(outputYPlane.begin(), outputYPlane.end(), outputNV21.begin());
-    std::copy(outputUVPlane.begin(), outputUVPlane.end(), outputNV21.begin() + yPlaneSize);
-
-    // Write to output NV21 file
-    std::ofstream outFile(outputFile, std::ios::binary);
-    if (!outFile)
+    // The split layout is compiled into rearrange.cl's remap_nv21 (loaded from the program cache on later runs)
+    TileRemap remap(context(), device(), RemapLayout::split_stack(width * 2, height / 2, 2));
+
+    // Y4M output keeps the input's frame rate and chroma tag, so it can be piped straight into an encoder.
+    // Raw output goes through the sink, which writes both planes straight from the pooled buffer
+    // and drops its reference once the write completes
+    std::unique_ptr<Y4mWriter> writer;
+    std::unique_ptr<FrameSink> sink;
+    if (isY4m(outputFile))
     {
-        throw std::runtime_error("Failed to create output file: " + outputFile);
+        header.width = width;
+        header.height = height;
+        header.format = Image::Format::YUV420;
+        writer = std::make_unique<Y4mWriter>(outputFile, header);
+    }
+    else
+    {
+        sink = std::make_unique<FrameSink>(outputFile);
+    }
+
+    size_t frames = 0;
+    double totalMs = 0;
+    do
+    {
+        if (input.sync_to_device(context(), queue()) != CL_SUCCESS)
+        {
+            throw std::runtime_error("Failed to upload input frame");
+        }
+
+        // Launch kernels and profile execution time
+        auto output = std::make_shared<Image>(Image::Format::NV21, width, height, pool);
+        cl_event rawEvent;
+        cl_int err = remap.run(queue(), input, *output, &rawEvent);
+        if (err != CL_SUCCESS)
+        {
+            throw std::runtime_error("Failed to launch remap_nv21: " + std::to_string(err));
+        }
+        cl::Event event(rawEvent);
+        queue.finish();
+
+        // Read back the whole output frame in one transfer
+        if (output->sync_to_host(context(), queue()) != CL_SUCCESS)
+        {
+            throw std::runtime_error("Failed to download output frame");
+        }
+
+        bool written = writer ? writer->write_frame(*output) : sink->write(std::move(output));
+        if (!written)
+        {
+            throw std::runtime_error("Failed to write output file: " + outputFile);
+        }
+
+        cl_ulong startTime, endTime;
+        event.getProfilingInfo(CL_PROFILING_COMMAND_START, &startTime);
+        event.getProfilingInfo(CL_PROFILING_COMMAND_END, &endTime);
+        totalMs += (endTime - startTime) / 1e6;
+        ++frames;
+    } while (reader && reader->read_frame(input));
+
+    if (writer ? !writer->flush() : !sink->flush())
+    {
+        throw std::runtime_error("Failed to write output file: " + outputFile);
     }
-    outFile.write(reinterpret_cast<const char *>(outputNV21.data()), outputNV21.size());
-    outFile.close();
 
     // Print profiling results
-    cl_ulong startTime, endTime;
-    event.getProfilingInfo(CL_PROFILING_COMMAND_START, &startTime);
-    event.getProfilingInfo(CL_PROFILING_COMMAND_END, &endTime);
-    std::cout << "NV21 rearrange time: " << (endTime - startTime) / 1e6 << " ms" << std::endl;
+    // With the frames going to stdout, the report goes to stderr
+    std::ostream &report = outputFile == "-" ? std::cerr : std::cout;
+    report << "NV21 rearrange time: " << totalMs / frames << " ms";
+    if (frames > 1)
+    {
+        report << " per frame, " << frames << " frames";
+    }
+    report << std::endl;
 }
 
-int main()
+// Usage: testgrid [input.nv21 | input.y4m | - [output.nv21 | output.y4m | -]]
+// A raw input is 7680x1300 NV21; a 4:2:0 Y4M input of W x H becomes (W / 2) x (H * 2)
+int main(int argc, char **argv)
 {
     try
     {
-        const std::string inputFile = "input.nv21";
-        const std::string outputFile = "output.nv21";
+        const std::string inputFile = argc > 1 ? argv[1] : "input.nv21";
+        const std::string outputFile = argc > 2 ? argv[2] : "output.nv21";
         const int width = 7680 / 2;  // Split width
         const int height = 1300 * 2; // Double height after rearrange
 
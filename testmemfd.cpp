@@ -0,0 +1,196 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include <CL/cl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "ProgramCache.h"
+#include "BufferPool.h"
+#include "WorkSizeTuner.h"
+
+using namespace bos::mm;
+
+// 检查 OpenCL 错误
+#define CHECK_CL_ERROR(err)                                                           \
+    if (err != CL_SUCCESS)                                                            \
+    {                                                                                 \
+        std::cerr << "OpenCL error: " << err << " at line " << __LINE__ << std::endl; \
+        exit(1);                                                                      \
+    }
+
+// 通过 UNIX socket 发送 fd 和附带的大小（SCM_RIGHTS）
+bool sendFd(int sock, int fd, uint64_t size)
+{
+    char control[CMSG_SPACE(sizeof(int))] = {};
+    iovec iov = {&size, sizeof(size)};
+    msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    return sendmsg(sock, &msg, 0) == sizeof(size);
+}
+
+// 接收 fd 和附带的大小，失败返回 -1
+int recvFd(int sock, uint64_t *size)
+{
+    char control[CMSG_SPACE(sizeof(int))] = {};
+    iovec iov = {size, sizeof(*size)};
+    msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    if (recvmsg(sock, &msg, 0) != sizeof(*size))
+    {
+        return -1;
+    }
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == nullptr || cmsg->cmsg_type != SCM_RIGHTS)
+    {
+        return -1;
+    }
+    int fd;
+    std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    return fd;
+}
+
+// 消费者进程：导入 NV21 帧的 fd，经 to_cl_mem 的 fd 导入路径做 NV21 -> RGB，再把结果的 fd 发回
+int runConsumer(int sock, int width, int height)
+{
+    uint64_t frame_size;
+    int frame_fd = recvFd(sock, &frame_size);
+    if (frame_fd < 0)
+    {
+        std::cerr << "Failed to receive frame fd" << std::endl;
+        return 1;
+    }
+    Buffer frame(Buffer::Type::MEMFD, frame_size, frame_fd);
+    close(frame_fd);
+
+    size_t rgb_size = static_cast<size_t>(width) * height * 3;
+    Buffer rgb(Buffer::Type::MEMFD, rgb_size);
+
+    // OpenCL 必须在 fork 之后、只在本进程内初始化
+    cl_platform_id platform;
+    cl_device_id device;
+    cl_int err = clGetPlatformIDs(1, &platform, NULL);
+    CHECK_CL_ERROR(err);
+    err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_ALL, 1, &device, NULL);
+    CHECK_CL_ERROR(err);
+    cl_context context = clCreateContext(NULL, 1, &device, NULL, NULL, &err);
+    CHECK_CL_ERROR(err);
+    cl_command_queue queue = clCreateCommandQueue(context, device, 0, &err);
+    CHECK_CL_ERROR(err);
+
+    const char *options = "-D PIX_PER_WI_Y=1 -D SCN=1 -D DCN=3 -D BIDX=2 -D UIDX=1 -D SRC_DEPTH=0";
+    cl_program program = program_cache_build(context, device, "color_yuv.cl", options, NULL, &err);
+    CHECK_CL_ERROR(err);
+    cl_kernel kernel = clCreateKernel(program, "YUV2RGB_NVx", &err);
+    CHECK_CL_ERROR(err);
+
+    // 与 DMABUF 相同的导入路径：先尝试 fd 导入，不支持时退回映射地址上的 USE_HOST_PTR
+    cl_mem src = frame.get_cl_mem(context, true);
+    cl_mem dst = rgb.get_cl_mem(context, true);
+    if (src == nullptr || dst == nullptr)
+    {
+        std::cerr << "Failed to import memfd buffers" << std::endl;
+        return 1;
+    }
+
+    int src_step = width, dst_step = width * 3, offset = 0;
+    CHECK_CL_ERROR(clSetKernelArg(kernel, 0, sizeof(cl_mem), &src));
+    CHECK_CL_ERROR(clSetKernelArg(kernel, 1, sizeof(int), &src_step));
+    CHECK_CL_ERROR(clSetKernelArg(kernel, 2, sizeof(int), &offset));
+    CHECK_CL_ERROR(clSetKernelArg(kernel, 3, sizeof(cl_mem), &dst));
+    CHECK_CL_ERROR(clSetKernelArg(kernel, 4, sizeof(int), &dst_step));
+    CHECK_CL_ERROR(clSetKernelArg(kernel, 5, sizeof(int), &offset));
+    CHECK_CL_ERROR(clSetKernelArg(kernel, 6, sizeof(int), &height));
+    CHECK_CL_ERROR(clSetKernelArg(kernel, 7, sizeof(int), &width));
+
+    size_t global_work_size[2] = {static_cast<size_t>(width / 2), static_cast<size_t>(height / 2)};
+    CHECK_CL_ERROR(bos::mm::enqueue_tuned(queue, kernel, 2, global_work_size));
+
+    // USE_HOST_PTR 的内容只有在 map 之后才保证同步回宿主内存
+    void *mapped = clEnqueueMapBuffer(queue, dst, CL_TRUE, CL_MAP_READ, 0, rgb_size, 0, NULL, NULL, &err);
+    CHECK_CL_ERROR(err);
+    clEnqueueUnmapMemObject(queue, dst, mapped, 0, NULL, NULL);
+    clFinish(queue);
+
+    std::cout << "consumer: src zero-copy " << (frame.is_zero_copy(context, queue) ? "yes" : "no")
+              << ", dst zero-copy " << (rgb.is_zero_copy(context, queue) ? "yes" : "no")
+              << ", cl_mem hits " << cl_mem_stats().hits << " misses " << cl_mem_stats().misses << std::endl;
+
+    bool sent = sendFd(sock, rgb.get_dma_fd(), rgb_size);
+
+    clReleaseKernel(kernel);
+    clReleaseProgram(program);
+    clReleaseCommandQueue(queue);
+    clReleaseContext(context);
+    return sent ? 0 : 1;
+}
+
+int main()
+{
+    const int width = 960;
+    const int height = 540;
+    const size_t frame_size = static_cast<size_t>(width) * height * 3 / 2;
+
+    int socks[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, socks) != 0)
+    {
+        std::cerr << "Failed to create socket pair" << std::endl;
+        return 1;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        close(socks[0]);
+        return runConsumer(socks[1], width, height);
+    }
+    close(socks[1]);
+
+    // 生产者进程：把 NV21 帧直接读进 memfd 缓冲区，只传 fd，不复制像素
+    Buffer frame(Buffer::Type::MEMFD, frame_size);
+    std::ifstream file("input1.nv21", std::ios::binary);
+    if (!file.read(reinterpret_cast<char *>(frame.get_data()), frame_size))
+    {
+        std::cerr << "Failed to read input1.nv21" << std::endl;
+        return 1;
+    }
+    if (!sendFd(socks[0], frame.get_dma_fd(), frame_size))
+    {
+        std::cerr << "Failed to send frame fd" << std::endl;
+        return 1;
+    }
+
+    uint64_t rgb_size;
+    int rgb_fd = recvFd(socks[0], &rgb_size);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (rgb_fd < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        std::cerr << "Consumer process failed" << std::endl;
+        return 1;
+    }
+
+    // 结果同样是 memfd，映射后直接写文件
+    Buffer rgb(Buffer::Type::MEMFD, rgb_size, rgb_fd);
+    close(rgb_fd);
+    std::ofstream out("output_memfd.rgb", std::ios::binary);
+    out.write(reinterpret_cast<const char *>(rgb.get_data()), rgb_size);
+
+    std::cout << "Cross-process memfd hand-off completed, output saved to output_memfd.rgb" << std::endl;
+    return 0;
+}
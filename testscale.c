@@ -1,68 +1,55 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <chrono>
+#include <cstdlib>
 #include <CL/cl.h>
 
+#include "ProgramCache.h"
+#include "WorkSizeTuner.h"
+#include "ResizeNvx.h"
+#include "Sequence.h"
+
 // 检查 OpenCL 错误并打印
 #define CHECK_OPENCL_ERROR(call)                                                                                                                 \
     do                                                                                                                                           \
     {                                                                                                                                            \
-        cl_int err = (call);                                                                                                                     \
-        if (err != CL_SUCCESS)                                                                                                                   \
+        cl_int status = (call);                                                                                                                  \
+        if (status != CL_SUCCESS)                                                                                                                \
         {                                                                                                                                        \
-            std::cerr << "OpenCL error in " << __FILE__ << ":" << __LINE__ << " - " << #call << " failed with error code: " << err << std::endl; \
+            std::cerr << "OpenCL error in " << __FILE__ << ":" << __LINE__ << " - " << #call << " failed with error code: " << status << std::endl; \
             exit(1);                                                                                                                             \
         }                                                                                                                                        \
     } while (0)
 
-// 读取文件到缓冲区
-std::vector<uint8_t> readFile(const std::string &filename)
+// 将缓冲区写入文件
+void writeFile(const std::string &filename, const std::vector<uint8_t> &buffer)
 {
-    std::ifstream file(filename, std::ios::binary); // 以二进制模式打开文件
+    std::ofstream file(filename, std::ios::binary);
     if (!file)
     {
         std::cerr << "Failed to open file: " << filename << std::endl;
         exit(1);
     }
-    file.seekg(0, std::ios::end);
-    size_t size = file.tellg();
-    file.seekg(0, std::ios::beg);
-    std::vector<uint8_t> buffer(size);
-    file.read(reinterpret_cast<char *>(buffer.data()), size);
-    return buffer;
-}
-
-// 加载 OpenCL kernel 文件
-char *load_kernel_source(const char *filename, size_t *size)
-{
-    FILE *file = fopen(filename, "r");
-    if (!file)
-    {
-        fprintf(stderr, "Failed to open kernel file: %s\n", filename);
-        exit(EXIT_FAILURE);
-    }
-    fseek(file, 0, SEEK_END);
-    *size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    char *source = (char *)malloc(*size + 1);
-    fread(source, 1, *size, file);
-    source[*size] = '\0';
-    fclose(file);
-    return source;
+    file.write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
 }
 
-// 将缓冲区写入文件
-void writeFile(const std::string &filename, const std::vector<uint8_t> &buffer)
+// 每帧的墙钟时间（毫秒）：提交一帧并等待完成
+template <typename F>
+double frameTime(cl_command_queue queue, int runs, F enqueue)
 {
-    std::ofstream file(filename, std::ios::binary);
-    if (!file)
+    enqueue();
+    CHECK_OPENCL_ERROR(clFinish(queue));
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < runs; ++i)
     {
-        std::cerr << "Failed to open file: " << filename << std::endl;
-        exit(1);
+        enqueue();
+        CHECK_OPENCL_ERROR(clFinish(queue));
     }
-    file.write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / runs;
 }
 
+// NV21 缩放（resize_nvx.cl）：整数路径与 CPU 参考实现逐字节比较，采样器路径报告最大误差，两者都报告吞吐
 int main()
 {
     // 输入输出文件路径
@@ -74,25 +61,33 @@ int main()
     const int input_height = 1300;
     const int output_width = 3840; // 缩放后的宽度
     const int output_height = 650; // 缩放后的高度
+    const int num_runs = 100;
 
-    // 读取输入 NV21 数据
-    std::vector<uint8_t> input_data = readFile(input_filename);
-
-    // 分配输出 NV21 数据缓冲区
-    std::vector<uint8_t> output_data(output_width * output_height * 3 / 2, 0);
+    // 输入 NV21 的第一帧直接取自文件映射
+    const size_t input_size = (size_t)input_width * input_height * 3 / 2;
+    const size_t output_size = (size_t)output_width * output_height * 3 / 2;
+    std::shared_ptr<bos::mm::Buffer> input_frame;
+    try
+    {
+        bos::mm::SequenceReader sequence(input_filename, bos::mm::Image::Format::NV21, input_width, input_height);
+        input_frame = sequence.frame_buffer(0);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        exit(1);
+    }
+    uint8_t *input_data = input_frame->get_data();
 
-    // 将 NV21 数据拆分为 Y 和 UV 分量
-    std::vector<uint8_t> y_data(input_data.begin(), input_data.begin() + input_width * input_height);
-    std::vector<uint8_t> uv_data(input_data.begin() + input_width * input_height, input_data.end());
+    // CPU 参考结果
+    std::vector<uint8_t> reference(output_size);
+    bos::mm::resize_nvx_reference(input_data, input_width, input_height, reference.data(), output_width, output_height);
 
     // OpenCL 变量
     cl_platform_id platform;
     cl_device_id device;
     cl_context context;
     cl_command_queue queue;
-    cl_program program;
-    cl_kernel kernel;
-    cl_mem y_input_image, uv_input_image, y_output_image, uv_output_image;
 
     // 获取平台
     CHECK_OPENCL_ERROR(clGetPlatformIDs(1, &platform, nullptr));
@@ -116,122 +111,83 @@ int main()
         exit(1);
     }
 
-    // 创建 Y 分量输入图像
-    cl_image_format y_format;
-    y_format.image_channel_order = CL_R;              // 单通道
-    y_format.image_channel_data_type = CL_UNORM_INT8; // 8 位无符号整数
-    y_input_image = clCreateImage2D(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, &y_format, input_width, input_height, 0, y_data.data(), nullptr);
-    if (!y_input_image)
-    {
-        std::cerr << "Failed to create Y input image" << std::endl;
-        exit(1);
-    }
-
-    // 创建 UV 分量输入图像
-    cl_image_format uv_format;
-    uv_format.image_channel_order = CL_RG;             // 双通道
-    uv_format.image_channel_data_type = CL_UNORM_INT8; // 8 位无符号整数
-    uv_input_image = clCreateImage2D(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, &uv_format, input_width / 2, input_height / 2, 0, uv_data.data(), nullptr);
-    if (!uv_input_image)
+    bos::mm::Nv21Resizer resizer(context, device);
+    double frame_bytes = (double)(input_size + output_size);
+
+    // 整数路径：整帧放在一个缓冲区中，Y 与 UV 按偏移区分
+    cl_int err;
+    cl_mem src_buffer = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, input_size, input_data, &err);
+    CHECK_OPENCL_ERROR(err);
+    cl_mem dst_buffer = clCreateBuffer(context, CL_MEM_WRITE_ONLY, output_size, nullptr, &err);
+    CHECK_OPENCL_ERROR(err);
+    bos::mm::Nv21Target src = {src_buffer, src_buffer, 0, (size_t)input_width * input_height, (size_t)input_width};
+    bos::mm::Nv21Target dst = {dst_buffer, dst_buffer, 0, (size_t)output_width * output_height, (size_t)output_width};
+
+    double integer_ms = frameTime(queue, num_runs, [&]()
+                                  { CHECK_OPENCL_ERROR(resizer.resize(queue, src, input_width, input_height, dst, output_width, output_height)); });
+    std::vector<uint8_t> output_data(output_size);
+    CHECK_OPENCL_ERROR(clEnqueueReadBuffer(queue, dst_buffer, CL_TRUE, 0, output_size, output_data.data(), 0, nullptr, nullptr));
+    size_t mismatches = 0;
+    for (size_t i = 0; i < output_size; ++i)
     {
-        std::cerr << "Failed to create UV input image" << std::endl;
-        exit(1);
+        mismatches += output_data[i] != reference[i];
     }
+    printf("integer: %8.3f ms/frame  %6.2f GB/s  %s (%zu bytes differ from CPU reference)\n", integer_ms, frame_bytes / integer_ms / 1e6,
+           mismatches == 0 ? "bit-exact" : "MISMATCH", mismatches);
 
-    // 创建 Y 分量输出图像
-    y_output_image = clCreateImage2D(context, CL_MEM_WRITE_ONLY, &y_format, output_width, output_height, 0, nullptr, nullptr);
-    if (!y_output_image)
+    // 采样器路径：Y 为 CL_R、UV 为 CL_RG 图像
+    if (resizer.get_image_support())
     {
-        std::cerr << "Failed to create Y output image" << std::endl;
-        exit(1);
+        cl_image_format y_format = {CL_R, CL_UNORM_INT8};
+        cl_image_format uv_format = {CL_RG, CL_UNORM_INT8};
+        cl_mem y_input_image = clCreateImage2D(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, &y_format, input_width, input_height, 0,
+                                               input_data, &err);
+        CHECK_OPENCL_ERROR(err);
+        cl_mem uv_input_image = clCreateImage2D(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, &uv_format, input_width / 2, input_height / 2, 0,
+                                                input_data + (size_t)input_width * input_height, &err);
+        CHECK_OPENCL_ERROR(err);
+        cl_mem y_output_image = clCreateImage2D(context, CL_MEM_WRITE_ONLY, &y_format, output_width, output_height, 0, nullptr, &err);
+        CHECK_OPENCL_ERROR(err);
+        cl_mem uv_output_image = clCreateImage2D(context, CL_MEM_WRITE_ONLY, &uv_format, output_width / 2, output_height / 2, 0, nullptr, &err);
+        CHECK_OPENCL_ERROR(err);
+
+        double image_ms = frameTime(queue, num_runs, [&]()
+                                    { CHECK_OPENCL_ERROR(resizer.resize_image(queue, y_input_image, uv_input_image, y_output_image, uv_output_image)); });
+
+        // 读回 Y 和 UV 分量，拼成整帧
+        std::vector<uint8_t> image_data(output_size);
+        size_t origin[3] = {0, 0, 0};
+        size_t y_region[3] = {static_cast<size_t>(output_width), static_cast<size_t>(output_height), 1};
+        size_t uv_region[3] = {static_cast<size_t>(output_width / 2), static_cast<size_t>(output_height / 2), 1};
+        CHECK_OPENCL_ERROR(clEnqueueReadImage(queue, y_output_image, CL_TRUE, origin, y_region, 0, 0, image_data.data(), 0, nullptr, nullptr));
+        CHECK_OPENCL_ERROR(clEnqueueReadImage(queue, uv_output_image, CL_TRUE, origin, uv_region, 0, 0,
+                                              image_data.data() + (size_t)output_width * output_height, 0, nullptr, nullptr));
+        int max_diff = 0;
+        for (size_t i = 0; i < output_size; ++i)
+        {
+            max_diff = std::max(max_diff, std::abs((int)image_data[i] - (int)reference[i]));
+        }
+        printf("sampler: %8.3f ms/frame  %6.2f GB/s  max |diff| vs CPU reference = %d\n", image_ms, frame_bytes / image_ms / 1e6, max_diff);
+
+        clReleaseMemObject(y_input_image);
+        clReleaseMemObject(uv_input_image);
+        clReleaseMemObject(y_output_image);
+        clReleaseMemObject(uv_output_image);
     }
-
-    // 创建 UV 分量输出图像
-    uv_output_image = clCreateImage2D(context, CL_MEM_WRITE_ONLY, &uv_format, output_width / 2, output_height / 2, 0, nullptr, nullptr);
-    if (!uv_output_image)
+    else
     {
-        std::cerr << "Failed to create UV output image" << std::endl;
-        exit(1);
+        printf("sampler: skipped (device has no image support)\n");
     }
 
-    // 读取内核文件
-    size_t kernel_size;
-    char *kernel_source = load_kernel_source("resize_nv21.cl", &kernel_size);
-
-    // 创建程序
-    program = clCreateProgramWithSource(context, 1, (const char **)&kernel_source, nullptr, nullptr);
-    if (!program)
-    {
-        std::cerr << "Failed to create OpenCL program" << std::endl;
-        exit(1);
-    }
-
-    // 编译程序
-    cl_int build_status = clBuildProgram(program, 1, &device, nullptr, nullptr, nullptr);
-    if (build_status != CL_SUCCESS)
-    {
-        std::cerr << "Failed to build OpenCL program" << std::endl;
-        // 获取编译日志
-        size_t log_size;
-        clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, 0, nullptr, &log_size);
-        std::vector<char> log(log_size);
-        clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, log_size, log.data(), nullptr);
-        std::cerr << "Build log: " << log.data() << std::endl;
-        exit(1);
-    }
-
-    // 创建内核
-    kernel = clCreateKernel(program, "resize_nv21", nullptr);
-    if (!kernel)
-    {
-        std::cerr << "Failed to create OpenCL kernel" << std::endl;
-        exit(1);
-    }
-
-    // 设置内核参数
-    CHECK_OPENCL_ERROR(clSetKernelArg(kernel, 0, sizeof(cl_mem), &y_input_image));
-    CHECK_OPENCL_ERROR(clSetKernelArg(kernel, 1, sizeof(cl_mem), &uv_input_image));
-    CHECK_OPENCL_ERROR(clSetKernelArg(kernel, 2, sizeof(cl_mem), &y_output_image));
-    CHECK_OPENCL_ERROR(clSetKernelArg(kernel, 3, sizeof(cl_mem), &uv_output_image));
-    CHECK_OPENCL_ERROR(clSetKernelArg(kernel, 4, sizeof(int), &input_width));
-    CHECK_OPENCL_ERROR(clSetKernelArg(kernel, 5, sizeof(int), &input_height));
-    CHECK_OPENCL_ERROR(clSetKernelArg(kernel, 6, sizeof(int), &output_width));
-    CHECK_OPENCL_ERROR(clSetKernelArg(kernel, 7, sizeof(int), &output_height));
-
-    // 执行内核
-    size_t global_work_size[2] = {static_cast<size_t>(output_width), static_cast<size_t>(output_height)};
-    CHECK_OPENCL_ERROR(clEnqueueNDRangeKernel(queue, kernel, 2, nullptr, global_work_size, nullptr, 0, nullptr, nullptr));
-    CHECK_OPENCL_ERROR(clFinish(queue));
-    // 将输出数据复制回主机
-    std::vector<uint8_t> y_output_data(output_width * output_height);
-    std::vector<uint8_t> uv_output_data(output_width * output_height / 2);
-    // 读取 Y 分量
-    size_t y_origin[3] = {0, 0, 0};
-    size_t y_region[3] = {static_cast<size_t>(output_width), static_cast<size_t>(output_height), 1};
-    CHECK_OPENCL_ERROR(clEnqueueReadImage(queue, y_output_image, CL_TRUE, y_origin, y_region, 0, 0, y_output_data.data(), 0, nullptr, nullptr));
-
-    // 读取 UV 分量
-    size_t uv_origin[3] = {0, 0, 0};
-    size_t uv_region[3] = {static_cast<size_t>(output_width / 2), static_cast<size_t>(output_height / 2), 1};
-    CHECK_OPENCL_ERROR(clEnqueueReadImage(queue, uv_output_image, CL_TRUE, uv_origin, uv_region, 0, 0, uv_output_data.data(), 0, nullptr, nullptr));
-
-    // 合并 Y 和 UV 分量
-    output_data.insert(output_data.begin(), y_output_data.begin(), y_output_data.end());
-    output_data.insert(output_data.end(), uv_output_data.begin(), uv_output_data.end());
-
-    // 保存输出数据到文件
+    // 保存整数路径的输出
     writeFile(output_filename, output_data);
 
     // 释放资源
-    clReleaseMemObject(y_input_image);
-    clReleaseMemObject(uv_input_image);
-    clReleaseMemObject(y_output_image);
-    clReleaseMemObject(uv_output_image);
-    clReleaseKernel(kernel);
-    clReleaseProgram(program);
+    clReleaseMemObject(src_buffer);
+    clReleaseMemObject(dst_buffer);
     clReleaseCommandQueue(queue);
     clReleaseContext(context);
 
     std::cout << "Processing completed. Output saved to " << output_filename << std::endl;
-    return 0;
+    return mismatches == 0 ? 0 : 1;
 }
\ No newline at end of file